@@ -9,38 +9,78 @@
 
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "Simulation.h"
+#include "batch.h"
+#include "sweep.h"
+#include "server.h"
+#include "cache.h"
+#include "tune.h"
+#include "sample.h"
+#include "index.h"
+#include "branch.h"
+#include "checkpoint.h"
+#include "generator.h"
+#include "stream.h"
+#include "decompress.h"
+#include "import.h"
+#include "group.h"
+#include "deadline.h"
 #include "parser.h"
+#include "pool.h"
+#include "reference.h"
 #include "queue.h"
 
 /*
  * Function: Simulate
  *
- * Initializes the simulation based on preemption
+ * Runs the simulation to completion, taking periodic checkpoints if
+ * enabled, and prints the final statistics. Returns 0 on success, -1 if
+ * the engine ran out of memory.
  */
-void Simulate(int quantumA, int quantumB, int preemption, pQueue *queueB) {
-    // A function whose input is the quanta for queues A and B,
-    // well as whether preemption is enabled.
+int Simulate(Simulation *sim) {
+    int status;
+    while ((status = stepSimulation(sim)) > 0) {
+        // snapshot the engine state every checkpoint interval
+        if (sim->checkpoint && sim->stats->runtime >= sim->checkpoint->next) {
+            checkpointAsync(sim->checkpoint, sim);
+        }
+    }
 
-    if (preemption == 1) {
-        runPreemption(quantumA, quantumB, queueB);
-    } else {
-        runNonPreemption(quantumA, quantumB, queueB);
+    // wait for any snapshot still being written
+    if (sim->checkpoint) {
+        checkpointWait(sim->checkpoint);
+    }
+
+    if (status < 0) {
+        return -1;
     }
 
+    // print final stats
+    if (sim->generator) {
+        printGeneratorStats(sim->generator, sim);
+    } else {
+        printStats(sim->exitQueue, sim->stats);
+    }
+    if (sim->groups) {
+        printGroupStats(sim->groups, sim->exitQueue);
+    }
+    printDeadlineStats(sim->exitQueue);
+    return 0;
 }
 
 /*
  * Function: initializeStats
  *
- * Initializes the stats struct
+ * Initializes the stats struct, or returns NULL if allocation fails
  */
 Stats *initializeStats() {
     Stats *s = (Stats *)malloc(sizeof(Stats));
     if (!s) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     s->instructions = 0;
     s->startTime = 0;
@@ -53,561 +93,629 @@ Stats *initializeStats() {
 }
 
 /*
- * Function: allQueuesEmpty
+ * Function: defaultLevels
  *
- * Helper function to check if all queues are empty
+ * Fills levels with the classic two level configuration: queue A on top,
+ * and queue B, where processes enter and are promoted to queue A after 3
+ * completions or interrupts. Returns the number of levels.
  */
-int allQueuesEmpty(pQueue *queueA, pQueue *queueB, tQueue *readyQueueA, tQueue *readyQueueB, tQueue *ioQueue) {
-    if (isEmptyP(queueB) &&
-        isEmptyP(queueA) &&
-        isEmptyT(readyQueueA) &&
-        isEmptyT(readyQueueB) &&
-        isEmptyT(ioQueue)) {
-        return 1;
-    }
-    return 0;
+int defaultLevels(Level *levels, int quantumA, int quantumB) {
+    levels[0].quantum = quantumA;
+    levels[0].promote = 0;
+    levels[0].demote = 0;
+    levels[1].quantum = quantumB;
+    levels[1].promote = PROMOTE_AFTER;
+    levels[1].demote = 0;
+    return 2;
+}
+
+/*
+ * Function: levelName
+ *
+ * Returns the name of a level, which is also the termination queue printed
+ * for processes that finish there
+ */
+const char *levelName(int level) {
+    static const char *names[MAX_LEVELS] = {
+        "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+        "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z"
+    };
+    return level >= 0 && level < MAX_LEVELS ? names[level] : "?";
 }
 
 /*
- * Function: runPreemption
+ * Function: adoptProcess
  *
- * Runs the simulation for preemption scheduling
+ * Makes the engine responsible for freeing a process and its tasks. The
+ * process starts at the lowest level.
  */
- void runPreemption(int quantumA, int quantumB, pQueue *queueB) {
-
-     // Initialize simulation variables
-     Stats *stats = initializeStats();
-     Task *t = NULL;
-     Process *p = NULL;
-     int cpu = 0;
-
-     // Initialize queues
-     pQueue *queueA = createProcessQueue();
-     pQueue *exitQueue = createProcessQueue();
-     tQueue *ioQueue = createTaskQueue();
-     tQueue *readyQueueA = createTaskQueue();
-     tQueue *readyQueueB = createTaskQueue();
-
-     // simulation start time == first process arrival time
-     p = peekProcess(queueB);
-     stats->runtime = stats->startTime = p->arrival;
-     p = NULL;
-
-     // main simulation loop for non-preemption
-     while (!allQueuesEmpty(queueA, queueB, readyQueueA, readyQueueB, ioQueue)) {
-
-         // prioritize queue A
-         if (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
-
-             while (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
-
-                 // update I/O tasks to simulate concurrent execution
-                 if (!isEmptyT(ioQueue)) {
-                     updateIOTasks(ioQueue);
-                 }
-
-                 if (cpu == 0) {
-                     // fetch next task and set CPU flag
-                     t = getNextTaskPreemptive(queueA, readyQueueA, stats->runtime);
-                     if (t != NULL) {
-                         cpu = 1;
-                         t->parent->taskRunning = 1;
-                     }
-
-                     break;
-                 } else {
-                     p = t->parent;
-                     if (preemptionCheck(queueB, readyQueueB, t, stats->runtime)) {
-                         t->interrupts++;
-                         p->taskRunning = 0;
-                         priorityEnqueueTask(readyQueueB, t);
-                         t = getNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
-                     } else {
-                        switch (t->type) {
-                            case 'i':
-                                if (p->quantum > 0) { // if process has quantum left
-                                    p->quantum--;
-                                    if (p->quantum > 0) {
-                                        p->completions++;
-                                        // p->taskRunning = 0;
-                                    } else { // reset completions
-                                        p->completions = 0;
-                                    }
-                                    stats->instructions++;
-                                    enqueueTask(ioQueue, t); // add to I/O queue
-                                } else {
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    p->quantum = quantumA;
-                                    priorityEnqueueTask(readyQueueA, t);
-                                }
-                                cpu = 0;
-                                break;
-                            case 'e':
-                                if (t->time == 0) { // task completed
-                                    t->completed = 1;
-                                    p->taskRunning = 0;
-                                    p->currentTask++;
-                                    stats->instructions++;
-                                    cpu = 0;
-                                } else if (p->quantum <= 0) { // quantum used up
-                                    p->completions = 0;
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    p->quantum = quantumA;
-                                    priorityEnqueueTask(readyQueueA, t);
-                                    cpu = 0;
-                                } else {
-                                    t->time--;
-                                    p->quantum--;
-                                }
-                                break;
-                            default: // 't' - terminate process
-                                if (p->quantum > 0) {
-                                    p->quantum--;
-                                    stats->instructions++;
-                                    stats->runtime++;
-                                    p->taskRunning = 0;
-                                    p->runtime = stats->runtime;
-                                    stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
-                                    stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
-                                    stats->totalWait += p->ready;
-                                    endProcess(queueA, exitQueue, p);
-                                } else {
-                                    p->completions = 0;
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    p->quantum = quantumA;
-                                    priorityEnqueueTask(readyQueueA, t);
-                                }
-                                cpu = 0;
-                                break;
-                        }
-                     }
-                 }
-
-                 // update queueA wait/ready times
-                 if (!isEmptyP(queueA)) {
-                     updateProcessQueue(queueA, stats->runtime);
-                 }
-
-                 // update queueB wait/ready times
-                 if (!isEmptyP(queueB)) {
-                     updateProcessQueue(queueB, stats->runtime);
-                 }
-
-                 stats->runtime++;
-             }
-         } else { // if queue A is empty
-
-             while (!isEmptyP(queueB) || !isEmptyT(ioQueue) || !isEmptyT(readyQueueB)) {
-
-                 // update I/O queue to simulate concurrent execution
-                 if (!isEmptyT(ioQueue)) {
-                     updateIOTasks(ioQueue);
-                 }
-
-                 if (cpu == 0) {
-                     // fetch next task and set CPU flag
-                     t = getNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
-                     if (t != NULL) {
-                         cpu = 1;
-                         t->parent->taskRunning = 1;
-                     }
-
-                     break;
-                 } else {
-                     p = t->parent; // identify parent process
-                     if (preemptionCheck(queueB, readyQueueB, t, stats->runtime)) {
-                         t->interrupts++;
-                         p->taskRunning = 0;
-
-                         if (t->interrupts == 3) { // promote to queue A
-                             promoteProcess (queueB, queueA, p);
-                             p->quantum = quantumA;
-                         } else {
-                             priorityEnqueueTask(readyQueueB, t);
-                         }
-
-                         t = getNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
-                     } else {
-                        switch (t->type) {
-                            case 'i':
-                                if (p->quantum > 0) { // if process has quantum left
-                                    p->quantum--;
-                                    if (p->quantum > 0) {
-                                        p->completions++;
-                                        if (p->completions == 3) { // promote to queue A
-                                            p->quantum = quantumA;
-                                            priorityEnqueueProcess(queueA, p);
-                                            p->endQueue = "A";
-                                        }
-                                    } else { // reset completions
-                                        p->completions = 0;
-                                    }
-                                    stats->instructions++;
-                                    enqueueTask(ioQueue, t); // add to I/O queue
-                                } else {
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    if (t->interrupts == 3) { // promote to queue A
-                                        p->quantum = quantumA;
-                                        // p->taskRunning = 0;
-                                        promoteProcess(queueB, queueA, p);
-                                        priorityEnqueueTask(readyQueueA, t);
-                                    } else { // reset completions
-                                        p->quantum = quantumB;
-                                        p->completions = 0;
-                                        // p->taskRunning = 0;
-                                        priorityEnqueueTask(readyQueueB, t);
-                                    }
-                                }
-                                cpu = 0;
-                                break;
-                            case 'e':
-                                if (t->time == 0) { // task completed
-                                    t->completed = 1;
-                                    p->taskRunning = 0;
-                                    p->currentTask++;
-                                    stats->instructions++;
-                                    if (p->quantum > 0) { // if quantum not used up
-                                        p->completions++;
-                                        if (p->completions == 3) { // promote to queue A
-                                            p->quantum = quantumA;
-                                            promoteProcess(queueB, queueA, p);
-                                        }
-                                    } else { // reset completions
-                                        p->completions = 0;
-                                    }
-                                    cpu = 0;
-                                } else if (p->quantum == 0) { // quantum used up
-                                    p->completions = 0;
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    if (t->interrupts == 3) { // promote to queue A
-                                        p->quantum = quantumA;
-                                        promoteProcess(queueB, queueA, p);
-                                        priorityEnqueueTask(readyQueueA, t);
-                                        cpu = 0;
-                                    } else { // put back in ready queue
-                                        p->quantum = quantumB;
-                                        priorityEnqueueTask(readyQueueB, t);
-                                        cpu = 0;
-                                    }
-                                    cpu = 0;
-                                } else {
-                                    t->time--;
-                                    p->quantum--;
-                                }
-                                break;
-                            default: // 't' - terminate process
-                                if (p->quantum > 0) {
-                                    p->quantum--;
-                                    stats->instructions++;
-                                    stats->runtime++;
-                                    p->taskRunning = 0;
-                                    p->runtime = stats->runtime;
-                                    stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
-                                    stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
-                                    stats->totalWait += p->ready;
-                                    endProcess(queueB, exitQueue, p);
-                                    cpu = 0;
-                                } else {
-                                    p->completions = 0;
-                                    t->interrupts++;
-                                    p->taskRunning = 0;
-                                    p->quantum = quantumB;
-                                    priorityEnqueueTask(readyQueueB, t);
-                                    cpu = 0;
-                                }
-                                cpu = 0;
-                                break;
-                        }
-                     }
-                 }
-
-                 if (!isEmptyP(queueB)) {
-                     updateProcessQueue(queueB, stats->runtime);
-                 }
-
-                 stats->runtime++;
-             }
-         }
-     }
-     // free memory
-     free(queueA);
-     free(queueB);
-     free(ioQueue);
-     free(readyQueueA);
-     free(readyQueueB);
-
-     // print final stats
-     printStats(exitQueue, stats);
-
-     // Free exit queue
-     free(exitQueue);
-     free(stats);
- }
+void adoptProcess(Simulation *sim, Process *p) {
+    p->nextOwned = sim->owned;
+    p->prevOwned = NULL;
+    if (sim->owned != NULL) {
+        sim->owned->prevOwned = p;
+    }
+    p->endQueue = (char *)levelName(sim->levels - 1);
+    sim->owned = p;
+
+    // the first process placed in a group brings in the trace's hierarchy,
+    // and a process added later in none joins the hierarchy's group for them
+    if (p->group != NULL && sim->groups == NULL) {
+        sim->groups = holdGroups(p->group->tree);
+    } else if (p->group == NULL && sim->groups != NULL) {
+        placeUngroupedProcess(sim->groups, p);
+    }
+}
 
 /*
- * Function: runNonPreemption
+ * Function: retireProcess
  *
- * Runs the simulation for non-preemption scheduling
+ * Frees a completed process while the engine runs: every node still
+ * holding it is unlinked (the exit queue's and any stale copy left at
+ * another level) and it leaves the engine's list of owned processes. The
+ * caller must make sure none of its tasks are left (tasksOut is 0).
  */
-void runNonPreemption(int quantumA, int quantumB, pQueue *queueB) {
+void retireProcess(Simulation *sim, Process *p) {
+    unlinkProcess(p);
+    refreshLevels(sim);
 
-    // Initialize simulation variables
-    Stats *stats = initializeStats();
-    Task *t = NULL;
-    Process *p = NULL;
-    int cpu = 0;
+    if (p->prevOwned != NULL) {
+        p->prevOwned->nextOwned = p->nextOwned;
+    } else {
+        sim->owned = p->nextOwned;
+    }
+    if (p->nextOwned != NULL) {
+        p->nextOwned->prevOwned = p->prevOwned;
+    }
+    freeProcess(p);
+}
+
+/*
+ * Function: initializeSimulation
+ *
+ * Initializes the engine state for a new run over the parsed processes,
+ * using the quantum and promotion rules of count levels. The engine takes
+ * ownership of queue, which becomes the lowest level, and its processes.
+ * Returns 0 on success, -1 if allocation fails (the engine can still be
+ * passed to freeSimulation).
+ */
+int initializeSimulation(Simulation *sim, const Level *levels, int count, int preemption, pQueue *queue) {
+    sim->preemption = preemption == 1;
+    sim->CPU = 0;
+    sim->start = 0;
+    sim->end = 0;
+    sim->loop = 0;
+    sim->idleTicks = 0;
+    sim->lastArrival = LLONG_MIN;
+    sim->levels = count;
+    sim->aging = 0;
+    sim->active = 0;
+    sim->owned = NULL;
+    sim->generator = NULL;
+    sim->stream = NULL;
+    sim->groups = NULL;
+    sim->deadlines = NULL;
 
     // Initialize queues
-    pQueue *queueA = createProcessQueue();
-    pQueue *exitQueue = createProcessQueue();
-    tQueue *ioQueue = createTaskQueue();
-    tQueue *readyQueueA = createTaskQueue();
-    tQueue *readyQueueB = createTaskQueue();
+    int ok = 1;
+    for (int i = 0; i < count; i++) {
+        Level *l = &sim->level[i];
+        l->queue = i == count - 1 ? queue : createProcessQueue();
+        l->ready = createTaskQueue();
+        l->quantum = levels[i].quantum;
+        l->promote = levels[i].promote;
+        l->demote = levels[i].demote;
+        ok = ok && l->queue && l->ready;
+    }
+    sim->exitQueue = createProcessQueue();
+    sim->ioQueue = createTaskQueue();
+    sim->task = NULL;
+    sim->stats = initializeStats();
+
+    for (pNode *n = queue ? queue->head : NULL; n != NULL; n = n->next) {
+        adoptProcess(sim, n->process);
+    }
+
+    if (!ok || !sim->exitQueue || !sim->ioQueue || !sim->stats) {
+        return -1;
+    }
+
+    // with groups, every process is in one and the levels keep their lists
+    if (sim->groups) {
+        placeUngrouped(sim->groups, queue);
+    }
+    for (int i = 0; i < count; i++) {
+        attachGroupQueue(sim->level[i].queue, i);
+        sim->level[i].ready->level = i;
+    }
+    refreshLevels(sim);
 
     // simulation start time == first process arrival time
-    p = peekProcess(queueB);
-    stats->runtime = stats->startTime = p->arrival;
-    p = NULL;
+    Process *p = peekProcess(queue);
+    if (p != NULL) {
+        sim->stats->runtime = sim->stats->startTime = p->arrival;
+    }
+    sim->start = 1;
+    return 0;
+}
 
-    // main simulation loop for non-preemption
-    while (!allQueuesEmpty(queueA, queueB, readyQueueA, readyQueueB, ioQueue)) {
+/*
+ * Function: refreshLevel
+ *
+ * Updates the bit of one level in the bitmap of levels with work
+ */
+static inline void refreshLevel(Simulation *sim, int i) {
+    if (i < 0 || i >= sim->levels) return;
 
-        // prioritize queue A
-        if (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+    if (isEmptyP(sim->level[i].queue) && isEmptyT(sim->level[i].ready)) {
+        sim->active &= ~(1u << i);
+    } else {
+        sim->active |= 1u << i;
+    }
+}
 
-            while (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+/*
+ * Function: refreshLevels
+ *
+ * Rebuilds the bitmap of levels with work after the queues were changed
+ * from outside the engine
+ */
+void refreshLevels(Simulation *sim) {
+    for (int i = 0; i < sim->levels; i++) {
+        refreshLevel(sim, i);
+    }
+}
 
-                // update I/O tasks to simulate concurrent execution
-                if (!isEmptyT(ioQueue)) {
-                    updateIOTasks(ioQueue);
-                }
+/*
+ * Function: setAging
+ *
+ * Makes waiting processes gain a point of priority for every aging ticks
+ * of ready time (0 turns aging off). A ready queue is ordered by priority
+ * less the time each task entered it, an offset that stays fixed while
+ * the tasks wait, and processes are ranked from their ready time when two
+ * are compared, so aging costs no pass over the queued processes.
+ */
+void setAging(Simulation *sim, int aging) {
+    sim->aging = aging > 0 ? aging : 0;
+    for (int i = 0; i < sim->levels; i++) {
+        sim->level[i].queue->aging = sim->aging;
+        sim->level[i].ready->aging = sim->aging;
+    }
+}
 
-                if (cpu == 0) {
-                    // fetch next task and set CPU flag
-                    t = getNextTask(queueA, readyQueueA, stats->runtime);
-                    if (t != NULL) {
-                        cpu = 1;
-                        t->parent->taskRunning = 1;
-                    }
+/*
+ * Function: setDeadlineOrder
+ *
+ * Turns earliest-deadline-first ordering on or off. While it is on, the
+ * processes owned by the engine that have a deadline and have not
+ * completed are kept in a heap on their absolute deadline, so it is
+ * turned on once every process has been adopted, and so are the ready
+ * tasks with a deadline of each level, in a heap the level's ready queue
+ * keeps up to date. Returns 0 on success, -1 if a heap cannot be
+ * allocated.
+ */
+int setDeadlineOrder(Simulation *sim, int edf) {
+    freeDeadlineHeap(sim->deadlines);
+    sim->deadlines = NULL;
+    for (int i = 0; i < sim->levels; i++) {
+        freeReadyDeadlines(sim->level[i].ready->deadlines);
+        sim->level[i].ready->deadlines = NULL;
+    }
+    if (!edf) {
+        return 0;
+    }
+
+    if ((sim->deadlines = createDeadlineHeap()) == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < sim->levels; i++) {
+        tQueue *ready = sim->level[i].ready;
+        if ((ready->deadlines = createReadyDeadlines()) == NULL) {
+            return -1;
+        }
+        for (tNode *n = ready->head; n != NULL; n = n->next) {
+            if (reserveReadyDeadline(ready->deadlines) != 0) {
+                return -1;
+            }
+            pushReadyDeadline(ready->deadlines, n->task);
+        }
+    }
+    for (Process *p = sim->owned; p != NULL; p = p->nextOwned) {
+        int completed = 0;
+        for (pNode *n = p->nodes; n != NULL && !completed; n = n->sibling) {
+            completed = n->queue == sim->exitQueue;
+        }
+        if (p->deadline > 0 && !completed && pushDeadline(sim->deadlines, p) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: freeSimulation
+ *
+ * Frees the queues, statistics and every process and pending task owned
+ * by the engine
+ */
+void freeSimulation(Simulation *sim) {
+    // the task on the CPU is not in any queue
+    if (sim->CPU && sim->task != NULL) {
+        freeTask(sim->task);
+    }
+    freeTaskQueue(sim->ioQueue);
+    for (int i = 0; i < sim->levels; i++) {
+        if (sim->level[i].ready != NULL) {
+            freeReadyDeadlines(sim->level[i].ready->deadlines);
+            sim->level[i].ready->deadlines = NULL;
+        }
+        freeTaskQueue(sim->level[i].ready);
+        freeProcessQueue(sim->level[i].queue);
+    }
+    freeProcessQueue(sim->exitQueue);
+
+    while (sim->owned != NULL) {
+        Process *p = sim->owned;
+        sim->owned = p->nextOwned;
+        freeProcess(p);
+    }
+
+    free(sim->stats);
+    releaseGroups(sim->groups);
+    sim->groups = NULL;
+    freeDeadlineHeap(sim->deadlines);
+    sim->deadlines = NULL;
+    poolTrim();
+}
+
+/*
+ * Function: allQueuesEmpty
+ *
+ * Helper function to check if all queues are empty
+ */
+int allQueuesEmpty(Simulation *sim) {
+    return sim->active == 0 && isEmptyT(sim->ioQueue);
+}
+
+/*
+ * Function: moveProcess
+ *
+ * Moves a process from level i to level j (up or down) with the quantum of
+ * level j
+ */
+static void moveProcess(Simulation *sim, Process *p, int i, int j) {
+    p->quantum = sim->level[j].quantum;
+    p->interrupts = 0;
+    if (promoteProcess(sim->level[i].queue, sim->level[j].queue, p) == 0) {
+        p->endQueue = (char *)levelName(j);
+    }
+}
+
+/*
+ * Function: makeReady
+ *
+ * Puts an interrupted task in a ready queue by priority, recording when it
+ * started waiting there
+ */
+static int makeReady(Simulation *sim, tQueue *ready, Task *t) {
+    t->readySince = sim->stats->runtime;
+    return priorityEnqueueTask(ready, t);
+}
+
+/*
+ * Function: expireQuantum
+ *
+ * Puts an interrupted task back in a ready queue once its process has used
+ * up its quantum at level i. The process moves down a level after the
+ * level's demotion threshold of expiries, and otherwise waits at level i
+ * with a fresh quantum.
+ */
+static int expireQuantum(Simulation *sim, Task *t, int i) {
+    Level *level = &sim->level[i];
+    Process *p = t->parent;
+
+    if (level->demote > 0 && i + 1 < sim->levels && ++p->interrupts >= level->demote) {
+        moveProcess(sim, p, i, i + 1);
+        return makeReady(sim, sim->level[i + 1].ready, t);
+    }
 
-                    break;
+    p->quantum = level->quantum;
+    return makeReady(sim, level->ready, t);
+}
+
+/*
+ * Function: fetchTask
+ *
+ * Takes the next task to run at level i: earliest deadline first if
+ * enabled, and otherwise by queue order, or by priority with preemption,
+ * within the group furthest behind its share when the trace has fair-share
+ * groups
+ */
+static Task *fetchTask(Simulation *sim, int i) {
+    Level *level = &sim->level[i];
+    if (sim->deadlines) {
+        return getNextDeadlineTask(sim->deadlines, level->queue, level->ready, sim->stats->runtime);
+    }
+    if (sim->groups) {
+        return getNextGroupTask(sim->groups, level->queue, level->ready, sim->stats->runtime, sim->preemption);
+    }
+    return sim->preemption ? getNextTaskPreemptive(level->queue, level->ready, sim->stats->runtime)
+                           : getNextTask(level->queue, level->ready, sim->stats->runtime);
+}
+
+/*
+ * Function: runLevel
+ *
+ * Advances the task on the CPU by one tick while servicing level i. Below
+ * the top level, a process moves up a level after the level's promotion
+ * threshold of completions or interrupts. Returns 0 on success, -1 if a
+ * queue node cannot be allocated.
+ */
+static int runLevel(Simulation *sim, int i) {
+    Stats *stats = sim->stats;
+    Level *level = &sim->level[i];
+    Level *entry = &sim->level[sim->levels - 1];
+    int promote = i > 0 ? level->promote : 0;
+    int status = 0;
+    Task *t = sim->task;
+    Process *p = t->parent; // identify parent process
+
+    // new arrivals enter at the lowest level, so that is where preemption looks
+    if (sim->preemption && preemptionCheck(entry->queue, entry->ready, t, stats->runtime)) {
+        t->interrupts++;
+        p->taskRunning = 0;
+
+        if (promote && t->interrupts == promote) { // promote a level
+            moveProcess(sim, p, i, i - 1);
+            freeTask(t); // the task is dropped, as it always has been
+        } else {
+            status |= makeReady(sim, entry->ready, t);
+        }
+
+        sim->task = fetchTask(sim, sim->levels - 1);
+        return status;
+    }
+
+    switch (t->type) {
+        case 'i':
+            if (p->quantum > 0) { // if process has quantum left
+                p->quantum--;
+                if (p->quantum > 0) {
+                    p->completions++;
+                    if (promote && p->completions == promote) { // promote a level
+                        p->quantum = sim->level[i - 1].quantum;
+                        p->interrupts = 0;
+                        status |= priorityEnqueueProcess(sim->level[i - 1].queue, p);
+                        p->endQueue = (char *)levelName(i - 1);
+                    }
+                } else { // reset completions
+                    p->completions = 0;
+                }
+                stats->instructions++;
+                status |= enqueueTask(sim->ioQueue, t); // add to I/O queue
+            } else {
+                t->interrupts++;
+                p->taskRunning = 0;
+                if (promote && t->interrupts == promote) { // promote a level
+                    moveProcess(sim, p, i, i - 1);
+                    status |= makeReady(sim, sim->level[i - 1].ready, t);
                 } else {
-                    p = t->parent;
-                    switch (t->type) {
-                        case 'i':
-                            if (p->quantum > 0) { // if process has quantum left
-                                p->quantum--;
-                                if (p->quantum > 0) {
-                                    p->completions++;
-                                    // p->taskRunning = 0;
-                                } else { // reset completions
-                                    p->completions = 0;
-                                }
-                                stats->instructions++;
-                                enqueueTask(ioQueue, t); // add to I/O queue
-                            } else {
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                p->quantum = quantumA;
-                                priorityEnqueueTask(readyQueueA, t);
-                            }
-                            cpu = 0;
-                            break;
-                        case 'e':
-                            if (t->time == 0) { // task completed
-                                t->completed = 1;
-                                p->taskRunning = 0;
-                                p->currentTask++;
-                                stats->instructions++;
-                                cpu = 0;
-                            } else if (p->quantum <= 0) { // quantum used up
-                                p->completions = 0;
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                p->quantum = quantumA;
-                                priorityEnqueueTask(readyQueueA, t);
-                                cpu = 0;
-                            } else {
-                                t->time--;
-                                p->quantum--;
-                            }
-                            break;
-                        default: // 't' - terminate process
-                            if (p->quantum > 0) {
-                                p->quantum--;
-                                stats->instructions++;
-                                stats->runtime++;
-                                p->taskRunning = 0;
-                                p->runtime = stats->runtime;
-                                stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
-                                stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
-                                stats->totalWait += p->ready;
-                                endProcess(queueA, exitQueue, p);
-                            } else {
-                                p->completions = 0;
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                p->quantum = quantumA;
-                                priorityEnqueueTask(readyQueueA, t);
-                            }
-                            cpu = 0;
-                            break;
+                    if (promote) { // completions only count where they can promote
+                        p->completions = 0;
                     }
+                    status |= expireQuantum(sim, t, i);
                 }
-
-                // update queueA wait/ready times
-                if (!isEmptyP(queueA)) {
-                    updateProcessQueue(queueA, stats->runtime);
+            }
+            sim->CPU = 0;
+            break;
+        case 'e':
+            if (t->time == 0) { // task completed
+                p->taskRunning = 0;
+                p->currentTask++;
+                stats->instructions++;
+                freeTask(t);
+                sim->task = NULL;
+                if (!promote) {
+                    // completions are not counted at the top level
+                } else if (p->quantum > 0) { // if quantum not used up
+                    p->completions++;
+                    if (p->completions == promote) { // promote a level
+                        moveProcess(sim, p, i, i - 1);
+                    }
+                } else { // reset completions
+                    p->completions = 0;
                 }
-
-                // update queueB wait/ready times
-                if (!isEmptyP(queueB)) {
-                    updateProcessQueue(queueB, stats->runtime);
+                sim->CPU = 0;
+            } else if (p->quantum <= 0) { // quantum used up
+                p->completions = 0;
+                t->interrupts++;
+                p->taskRunning = 0;
+                if (promote && t->interrupts == promote) { // promote a level
+                    moveProcess(sim, p, i, i - 1);
+                    status |= makeReady(sim, sim->level[i - 1].ready, t);
+                } else { // put back in ready queue
+                    status |= expireQuantum(sim, t, i);
                 }
-
+                sim->CPU = 0;
+            } else {
+                t->time--;
+                p->quantum--;
+            }
+            break;
+        default: // 't' - terminate process
+            if (p->quantum > 0) {
+                p->quantum--;
+                stats->instructions++;
                 stats->runtime++;
+                p->taskRunning = 0;
+                p->runtime = stats->runtime;
+                stats->minWait = stats->minWait != INT_MAX && stats->minWait < p->ready ? stats->minWait : p->ready;
+                stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
+                stats->totalWait += p->ready;
+                if (sim->deadlines) {
+                    removeDeadline(sim->deadlines, p);
+                }
+                if (sim->idleTicks || sim->deadlines) {
+                    // a run that lets idle time pass only stops once every
+                    // queue is empty, so no copy of the process may be left
+                    // behind at another level (generated processes are
+                    // also freed once they end); deadline order often
+                    // starts a final task just before a pass of another
+                    // level runs it, so it ends the process wherever it is
+                    // queued
+                    unlinkProcess(p);
+                    refreshLevels(sim);
+                    status |= enqueueProcess(sim->exitQueue, p);
+                } else {
+                    endProcess(level->queue, sim->exitQueue, p);
+                }
+                freeTask(t);
+                sim->task = NULL;
+            } else {
+                p->completions = 0;
+                t->interrupts++;
+                p->taskRunning = 0;
+                status |= expireQuantum(sim, t, i);
             }
-        } else { // if queue A is empty
+            sim->CPU = 0;
+            break;
+    }
 
-            while (!isEmptyP(queueB) || !isEmptyT(ioQueue) || !isEmptyT(readyQueueB)) {
+    return status;
+}
 
-                // update I/O queue to simulate concurrent execution
-                if (!isEmptyT(ioQueue)) {
-                    updateIOTasks(ioQueue);
-                }
+/*
+ * Function: updateWaits
+ *
+ * Adds a tick of ready time to the waiting processes of the serviced level
+ * and of the lowest level
+ */
+static void updateWaits(Simulation *sim, int i) {
+    int entry = sim->levels - 1;
+    if (i != entry && !isEmptyP(sim->level[i].queue)) {
+        updateProcessQueue(sim->level[i].queue, sim->stats->runtime);
+    }
+    if (!isEmptyP(sim->level[entry].queue)) {
+        updateProcessQueue(sim->level[entry].queue, sim->stats->runtime);
+    }
+}
 
-                if (cpu == 0) {
-                    // fetch next task and set CPU flag
-                    t = getNextTask(queueB, readyQueueB, stats->runtime);
-                    if (t != NULL) {
-                        cpu = 1;
-                        t->parent->taskRunning = 1;
-                    }
+/*
+ * Function: awaitingArrival
+ *
+ * Returns 1 if a process the engine owns, or one still to be generated,
+ * arrives after the current time. The latest arrival is kept as a bound
+ * and only looked for again once the clock has passed it.
+ */
+static int awaitingArrival(Simulation *sim) {
+    Ticks now = sim->stats->runtime;
+    if ((sim->generator && !sim->generator->done) || now < sim->lastArrival) {
+        return 1;
+    }
+    for (Process *p = sim->owned; p != NULL; p = p->nextOwned) {
+        if (p->arrival > sim->lastArrival) {
+            sim->lastArrival = p->arrival;
+        }
+    }
+    return now < sim->lastArrival;
+}
 
-                    break;
-                } else {
-                    p = t->parent; // identify parent process
-
-                    switch (t->type) {
-                        case 'i':
-                            if (p->quantum > 0) { // if process has quantum left
-                                p->quantum--;
-                                if (p->quantum > 0) {
-                                    p->completions++;
-                                    if (p->completions == 3) { // promote to queue A
-                                        p->quantum = quantumA;
-                                        priorityEnqueueProcess(queueA, p);
-                                        p->endQueue = "A";
-                                    }
-                                } else { // reset completions
-                                    p->completions = 0;
-                                }
-                                stats->instructions++;
-                                enqueueTask(ioQueue, t); // add to I/O queue
-                            } else {
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                if (t->interrupts == 3) { // promote to queue A
-                                    p->quantum = quantumA;
-                                    // p->taskRunning = 0;
-                                    promoteProcess(queueB, queueA, p);
-                                    priorityEnqueueTask(readyQueueA, t);
-                                } else { // reset completions
-                                    p->quantum = quantumB;
-                                    p->completions = 0;
-                                    // p->taskRunning = 0;
-                                    priorityEnqueueTask(readyQueueB, t);
-                                }
-                            }
-                            cpu = 0;
-                            break;
-                        case 'e':
-                            if (t->time == 0) { // task completed
-                                t->completed = 1;
-                                p->taskRunning = 0;
-                                p->currentTask++;
-                                stats->instructions++;
-                                if (p->quantum > 0) { // if quantum not used up
-                                    p->completions++;
-                                    if (p->completions == 3) { // promote to queue A
-                                        p->quantum = quantumA;
-                                        promoteProcess(queueB, queueA, p);
-                                    }
-                                } else { // reset completions
-                                    p->completions = 0;
-                                }
-                                cpu = 0;
-                            } else if (p->quantum == 0) { // quantum used up
-                                p->completions = 0;
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                if (t->interrupts == 3) { // promote to queue A
-                                    p->quantum = quantumA;
-                                    promoteProcess(queueB, queueA, p);
-                                    priorityEnqueueTask(readyQueueA, t);
-                                    cpu = 0;
-                                } else { // put back in ready queue
-                                    p->quantum = quantumB;
-                                    priorityEnqueueTask(readyQueueB, t);
-                                    cpu = 0;
-                                }
-                                cpu = 0;
-                            } else {
-                                t->time--;
-                                p->quantum--;
-                            }
-                            break;
-                        default: // 't' - terminate process
-                            if (p->quantum > 0) {
-                                p->quantum--;
-                                stats->instructions++;
-                                stats->runtime++;
-                                p->taskRunning = 0;
-                                p->runtime = stats->runtime;
-                                stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
-                                stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
-                                stats->totalWait += p->ready;
-                                endProcess(queueB, exitQueue, p);
-                                cpu = 0;
-                            } else {
-                                p->completions = 0;
-                                t->interrupts++;
-                                p->taskRunning = 0;
-                                p->quantum = quantumB;
-                                priorityEnqueueTask(readyQueueB, t);
-                                cpu = 0;
-                            }
-                            cpu = 0;
-                            break;
-                    }
-                }
+/*
+ * Function: stepSimulation
+ *
+ * Runs one iteration of the scheduler loop. Each pass services the highest
+ * level with work, found from the bitmap of levels in constant time, and
+ * ends after fetching the next task. Returns 1 while work remains, 0 once
+ * all queues are empty (or, letting idle time pass, once nothing queued
+ * can ever run), -1 if a queue node cannot be allocated.
+ */
+int stepSimulation(Simulation *sim) {
+    Stats *stats = sim->stats;
+    int entry = sim->levels - 1;
 
-                if (!isEmptyP(queueB)) {
-                    updateProcessQueue(queueB, stats->runtime);
-                }
+    // queue the streamed processes arriving by now, ahead of any pass
+    if (sim->stream && feedStream(sim->stream, sim) != 0) {
+        return -1;
+    }
 
-                stats->runtime++;
+    // choose which level to service on this pass
+    if (sim->loop == 0) {
+        // bring in generated arrivals and free the processes that completed
+        if (sim->generator && advanceGenerator(sim->generator, sim) != 0) {
+            return -1;
+        }
+        if (allQueuesEmpty(sim)) {
+            sim->end = 1;
+            return 0;
+        }
+        sim->loop = 'A' + (sim->active ? __builtin_ctz(sim->active) : entry);
+    }
+
+    // end the pass once the serviced level has no work left (the lowest
+    // level also waits for I/O)
+    int i = sim->loop - 'A';
+    if (!(sim->active & (1u << i)) && (i != entry || isEmptyT(sim->ioQueue))) {
+        sim->loop = 0;
+        return 1;
+    }
+
+    // report progress every interval iterations
+    progressTick(sim->progress, stats->runtime, sim->exitQueue, sim->level[0].queue, sim->level[entry].queue, sim->ioQueue);
+
+    // update I/O tasks to simulate concurrent execution
+    if (!isEmptyT(sim->ioQueue)) {
+        updateIOTasks(sim->ioQueue);
+    }
+
+    Level *level = &sim->level[i];
+    if (sim->CPU == 0) {
+        // fetch next task and set CPU flag
+        int idle = isEmptyT(level->ready) && isEmptyT(sim->ioQueue);
+        Task *t = fetchTask(sim, i);
+        if (t != NULL) {
+            sim->CPU = 1;
+            t->parent->taskRunning = 1;
+        }
+        sim->task = t;
+        refreshLevel(sim, i);
+
+        // with nothing runnable and no I/O pending the state cannot change
+        // until the clock moves, so let an idle tick pass if enabled; once
+        // nothing is left to arrive it never changes, and the run ends
+        if (t == NULL && idle && sim->idleTicks) {
+            if (!awaitingArrival(sim)) {
+                sim->loop = 0;
+                sim->end = 1;
+                return 0;
             }
+            updateWaits(sim, i);
+            stats->runtime++;
         }
+
+        sim->loop = 0;
+        return 1;
     }
-    // free memory
-    free(queueA);
-    free(queueB);
-    free(ioQueue);
-    free(readyQueueA);
-    free(readyQueueB);
 
-    // print final stats
-    printStats(exitQueue, stats);
+    // the tick is the CPU time of the running process's groups
+    if (sim->groups && sim->task) {
+        chargeGroup(sim->groups, sim->task->parent);
+    }
+    int status = runLevel(sim, i);
+
+    // a tick can only move work between neighbouring levels and the lowest
+    refreshLevel(sim, i - 1);
+    refreshLevel(sim, i);
+    refreshLevel(sim, i + 1);
+    refreshLevel(sim, entry);
+    if (status != 0) {
+        return -1;
+    }
 
-    // Free exit queue
-    free(exitQueue);
-    free(stats);
+    // update wait/ready times
+    updateWaits(sim, i);
+
+    stats->runtime++;
+    return 1;
 }
 
 /*
@@ -617,70 +725,657 @@ void runNonPreemption(int quantumA, int quantumB, pQueue *queueB) {
  */
 void printStats(pQueue *exitQueue, Stats *stats) {
 
-    printf("Start/End Time: %d, %d\n", stats->startTime, stats->runtime);
+    printf("Start/End Time: %lld, %lld\n", stats->startTime, stats->runtime);
     printf("Processes completed: %d\n", exitQueue->size);
-    printf("Instructions completed: %d\n", stats->instructions);
-    printf("Average ready time: %.2f\n", stats->totalWait / exitQueue->size);
-    printf("Max ready time: %d\n", stats->maxWait);
-    printf("Min ready time: %d\n", stats->minWait);
-    while (!isEmptyP(exitQueue)) {
-        Process *p = dequeueProcess(exitQueue);
-        printf("P%d time_completion:%d time_waiting:%d termination_queue:%s\n", p->pid, p->runtime, p->ready, p->endQueue);
-
-        // free the process
-        free(p->tasks);
-        free(p);
+    printf("Instructions completed: %lld\n", stats->instructions);
+    printf("Average ready time: %.2f\n", (double)stats->totalWait / exitQueue->size);
+    printf("Max ready time: %lld\n", stats->maxWait);
+    printf("Min ready time: %lld\n", stats->minWait);
+    for (pNode *n = exitQueue->head; n != NULL; n = n->next) {
+        Process *p = n->process;
+        printf("P%d time_completion:%lld time_waiting:%lld termination_queue:%s\n", p->pid, p->runtime, p->ready, p->endQueue);
     }
 }
 
+#ifndef SCHEDULER_LIBRARY
+
+/*
+ * Function: failStream
+ *
+ * Ends a run whose streamed trace failed, reporting it as ParseFile would
+ */
+static void failStream(TraceStream *stream) {
+    if (__atomic_load_n(&stream->status, __ATOMIC_ACQUIRE) != PARSE_OK) {
+        fprintf(stderr, "%s\n", stream->err.message);
+    } else {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * Function: printUsage
+ *
+ * Prints the command line usage and the optional arguments
+ */
+static void printUsage(char *program) {
+    printf("Usage: %s <input-file> <quantumA> <quantumB> <preemption> [options]\n", program);
+    printf("Options:\n");
+    printf("  --progress <N>               report progress to stderr, checking the clock every N iterations\n");
+    printf("  --progress-shm <name>        publish progress to the shared-memory block <name>\n");
+    printf("  --checkpoint <file>          periodically snapshot the simulation state to <file>\n");
+    printf("  --checkpoint-interval <T>    simulated ticks between snapshots (default %d)\n", CHECKPOINT_INTERVAL);
+    printf("  --restore <file>             resume from a snapshot instead of parsing <input-file>\n");
+    printf("  --branch <qA:qB:preemption>  after the shared prefix, also run this configuration (repeatable)\n");
+    printf("  --branch-at <T>              simulated time at which branches split off (default start)\n");
+    printf("  --levels <spec|@file>        feedback levels from highest to lowest, each quantum[:promote[:demote]],\n");
+    printf("                               separated by commas or lines; replaces quantumA and quantumB\n");
+    printf("  --aging <T>                  raise a waiting process's priority by one for every T ticks of ready time\n");
+    printf("  --edf                        run the task whose process has the earliest deadline first at each level\n");
+    printf("  --memory                     report current and peak engine memory to stderr after the run\n");
+    printf("  --reference                  run the frozen original two queue engine (quanta and preemption only)\n");
+    printf("  --generate <spec>            generate arrivals instead of reading <input-file>: poisson, mmpp or diurnal\n");
+    printf("                               followed by ,key=value settings (see README)\n");
+    printf("  --batch <results>            run every file of <input-file> (a glob, or @list with one path per line)\n");
+    printf("                               on a thread pool and write one row per run to <results> (- for stdout)\n");
+    printf("  --config <qA:qB:preemption>  in batch mode, also run every file under this configuration (repeatable)\n");
+    printf("  --jobs <N>                   worker threads for batch mode (default: one per CPU)\n");
+    printf("  --batch-limit <N>            stop a batch run after N scheduler iterations and report it as limit\n");
+    printf("  --sweep <results>            like --batch, but hand the runs to worker processes connected to --listen\n");
+    printf("  --listen <address>           address the sweep coordinator listens on: unix:<path> or tcp:<host>:<port>\n");
+    printf("  --spawn <N>                  start N local workers for the sweep (others run %s --worker <address>)\n", program);
+    printf("  --retries <N>                extra attempts for a sweep run whose worker failed (default 2)\n");
+    printf("  --serve <address>            keep parsed traces resident and answer simulation requests on <address>\n");
+    printf("                               (unix:<path> or tcp:<host>:<port>) with --jobs worker threads\n");
+    printf("  --cache-entries <N>          parsed traces the server keeps resident (default %d)\n", SERVER_CACHE);
+    printf("  --cache <dir>                reuse results stored in <dir> for the same trace contents and settings\n");
+    printf("                               (plain and batch runs; default $MLFQ_CACHE)\n");
+    printf("  --cache-limit <bytes>        evict the least recently used results beyond this size (default %lld)\n", CACHE_LIMIT);
+    printf("  --import                     read <input-file> as a perf sched script or ftrace sched_switch dump\n");
+    printf("  --import-tick <us>           microseconds per simulated tick when importing (default %d)\n", IMPORT_TICK);
+    printf("  --import-save <file>         also write the imported processes to <file> as a trace\n");
+    printf("  --no-stream                  parse the whole trace before the run instead of reading it alongside\n");
+    printf("  --no-cache                   neither read nor store cached results\n");
+    printf("  --tune <objective>           search quantumA, quantumB and preemption for the best avg or p99 ready time,\n");
+    printf("                               or throughput, on <input-file> with --jobs threads\n");
+    printf("  --tune-quanta <min:max>      quanta the search tries (default 2:64)\n");
+    printf("  --tune-preemption <0|1|both> preemption settings the search tries (default both)\n");
+    printf("  --approximate <spec>         estimate the statistics from sampled windows of the trace: default, or\n");
+    printf("                               strata=,windows=,size=,warmup=,maxwarmup=,seed= (see README)\n");
+    printf("  --from-arrival <T>           replay only the processes arriving at T or later, read through the\n");
+    printf("                               trace's index (<input-file>.idx, built on first use)\n");
+    printf("  --to-arrival <T>             replay only the processes arriving at T or earlier\n");
+    printf("  --from-pid <N>               replay only the processes with pid N or higher\n");
+    printf("  --to-pid <N>                 replay only the processes with pid N or lower\n\n");
+}
+
+/*
+ * Function: parseLevels
+ *
+ * Parses a level specification, inline or from the file named after '@'.
+ * Levels are listed from highest to lowest as quantum[:promote[:demote]],
+ * separated by commas or newlines, and '#' starts a comment. Promotion
+ * defaults to 3 completions or interrupts and demotion to never. Returns
+ * the number of levels, or -1 if the specification is invalid.
+ */
+static int parseLevels(const char *spec, Level *levels) {
+    char line[256];
+    FILE *f = spec[0] == '@' ? fopen(spec + 1, "r") : fmemopen((void *)spec, strlen(spec), "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line[strcspn(line, "#\n")] = '\0';
+        for (char *item = strtok(line, ", \t"); item != NULL; item = strtok(NULL, ", \t")) {
+            Level *l = &levels[count];
+            l->promote = PROMOTE_AFTER;
+            l->demote = 0;
+            if (count == MAX_LEVELS || sscanf(item, "%d:%d:%d", &l->quantum, &l->promote, &l->demote) < 1 ||
+                l->quantum < 2 || l->promote < 0 || l->demote < 0) {
+                fclose(f);
+                return -1;
+            }
+            count++;
+        }
+    }
+
+    fclose(f);
+    return count > 0 ? count : -1;
+}
+
 /*
  * Function: main
  *
- * Usage: ./a.out <input-file> <quantumA> <quantumB> <preemption>
+ * Usage: ./a.out <input-file> <quantumA> <quantumB> <preemption> [options]
  */
 int main(int argc, char *argv[]) {
 
+    // a sweep worker only needs the coordinator's address
+    if (argc == 3 && strcmp(argv[1], "--worker") == 0) {
+        return sweepWorker(argv[2]) != 0;
+    }
+
     // check for correct number of arguments
-    if (argc != 5) {
+    if (argc < 5) {
         printf("\nIncorrect num of arguments\n");
-        printf("Usage: %s <input-file> <quantumA> <quantumB> <preemption>\n\n", argv[0]);
+        printUsage(argv[0]);
         return 1;
     }
 
     // check for valid quantum values
     if (atoi(argv[2]) < 2 || atoi(argv[3]) < 2) {
         printf("\nInvalid arguments: quantumA and quantumB must be greater than 1\n");
-        printf("Usage: %s <input-file> <quantumA> <quantumB> <preemption>\n\n", argv[0]);
+        printUsage(argv[0]);
         return 1;
     }
 
     // initialize the simulation struct
-    Simulation sim;
+    Simulation sim = { 0 };
+    Level levels[MAX_LEVELS];
+    int numLevels = defaultLevels(levels, atoi(argv[2]), atoi(argv[3]));
 
     // Assign stats
-    sim.quantumA = atoi(argv[2]);
-    sim.quantumB = atoi(argv[3]);
     sim.preemption = atoi(argv[4]);
     sim.start = 0;
     sim.end = 0;
-
-    // Open the input file
-    sim.input_file = fopen(argv[1], "r");
-    if (sim.input_file == NULL) {
-        if (errno == ENOENT) {
-            printf("Error: File %s does not exist\n", argv[1]);
+    sim.progress = NULL;
+    sim.checkpoint = NULL;
+
+    // Parse optional arguments
+    long progressInterval = 0;
+    char *progressShm = NULL;
+    char *checkpointFile = NULL;
+    Ticks checkpointInterval = CHECKPOINT_INTERVAL;
+    char *restoreFile = NULL;
+    Ticks branchTime = 0;
+    int aging = 0;
+    int edf = 0;
+    int memoryReport = 0;
+    int reference = 0;
+    char *generateSpec = NULL;
+    char *batchResults = NULL;
+    int batchWorkers = 0;
+    long batchLimit = 0;
+    char *sweepResults = NULL;
+    SweepOptions sweep = { NULL, 0, 2 };
+    ServerOptions server = { NULL, 0, SERVER_CACHE };
+    char *cacheDir = getenv("MLFQ_CACHE");
+    long long cacheLimit = 0;
+    int noCache = 0;
+    int noStream = 0;
+    int importing = 0;
+    long long importTick = IMPORT_TICK;
+    char *importSave = NULL;
+    ResultCache cache;
+    char *tuneObjective = NULL;
+    TuneOptions tune = { TUNE_AVG, 2, 64, -1 };
+    char *sampleSpec = NULL;
+    SampleSpec sample;
+    TraceRange range;
+    initTraceRange(&range);
+    int numConfigs = 0;
+    int levelsGiven = 0;
+    int numBranches = 0;
+    Branch *branches = (Branch *)malloc(argc * sizeof(Branch));
+    Branch *configs = (Branch *)malloc((argc + 1) * sizeof(Branch));
+    if (!branches || !configs) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--progress") == 0 && i + 1 < argc) {
+            progressInterval = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--progress-shm") == 0 && i + 1 < argc) {
+            progressShm = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            checkpointInterval = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            restoreFile = argv[++i];
+        } else if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            if (parseBranch(argv[++i], &branches[numBranches]) != 0) {
+                printf("\nInvalid branch: %s (expected quantumA:quantumB:preemption, quanta greater than 1)\n", argv[i]);
+                return 1;
+            }
+            numBranches++;
+        } else if (strcmp(argv[i], "--branch-at") == 0 && i + 1 < argc) {
+            branchTime = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc) {
+            aging = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--edf") == 0) {
+            edf = 1;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            memoryReport = 1;
+        } else if (strcmp(argv[i], "--reference") == 0) {
+            reference = 1;
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generateSpec = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchResults = argv[++i];
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            if (parseBranch(argv[++i], &configs[1 + numConfigs]) != 0) {
+                printf("\nInvalid configuration: %s (expected quantumA:quantumB:preemption, quanta greater than 1)\n", argv[i]);
+                return 1;
+            }
+            numConfigs++;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            batchWorkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-limit") == 0 && i + 1 < argc) {
+            batchLimit = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweepResults = argv[++i];
+        } else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            sweep.address = argv[++i];
+        } else if (strcmp(argv[i], "--spawn") == 0 && i + 1 < argc) {
+            sweep.spawn = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--retries") == 0 && i + 1 < argc) {
+            sweep.retries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            server.address = argv[++i];
+        } else if (strcmp(argv[i], "--cache-entries") == 0 && i + 1 < argc) {
+            server.cacheEntries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-limit") == 0 && i + 1 < argc) {
+            cacheLimit = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            noCache = 1;
+        } else if (strcmp(argv[i], "--no-stream") == 0) {
+            noStream = 1;
+        } else if (strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            tuneObjective = argv[++i];
+            if ((tune.objective = parseTuneObjective(tuneObjective)) < 0) {
+                printf("\nInvalid objective: %s (expected avg, p99 or throughput)\n", tuneObjective);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tune-quanta") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d:%d", &tune.minQuantum, &tune.maxQuantum) != 2 ||
+                tune.minQuantum < 2 || tune.maxQuantum < tune.minQuantum) {
+                printf("\nInvalid quanta: %s (expected min:max, both greater than 1)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tune-preemption") == 0 && i + 1 < argc) {
+            i++;
+            tune.preemption = strcmp(argv[i], "both") == 0 ? -1 : atoi(argv[i]) != 0;
+        } else if (strcmp(argv[i], "--approximate") == 0 && i + 1 < argc) {
+            sampleSpec = argv[++i];
+            if (parseSampleSpec(sampleSpec, &sample) != 0) {
+                printf("\nInvalid sampling: %s (expected default or strata=,windows=,size=,warmup=,maxwarmup=,seed=)\n", sampleSpec);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--from-arrival") == 0 && i + 1 < argc) {
+            range.fromArrival = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--to-arrival") == 0 && i + 1 < argc) {
+            range.toArrival = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--from-pid") == 0 && i + 1 < argc) {
+            range.fromPid = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--to-pid") == 0 && i + 1 < argc) {
+            range.toPid = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--import") == 0) {
+            importing = 1;
+        } else if (strcmp(argv[i], "--import-tick") == 0 && i + 1 < argc) {
+            importing = 1;
+            importTick = atoll(argv[++i]);
+            if (importTick < 1) {
+                printf("\nInvalid import tick: %s (expected microseconds, at least 1)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--import-save") == 0 && i + 1 < argc) {
+            importing = 1;
+            importSave = argv[++i];
+        } else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            if ((numLevels = parseLevels(argv[++i], levels)) < 0) {
+                printf("\nInvalid levels: %s (expected quantum[:promote[:demote]],..., quanta greater than 1, at most %d levels)\n", argv[i], MAX_LEVELS);
+                return 1;
+            }
+            levelsGiven = 1;
         } else {
-            printf("Error: Could not open file %s\n", argv[1]);
+            printf("\nUnknown option: %s\n", argv[i]);
+            printUsage(argv[0]);
+            return 1;
         }
+    }
+
+    if (noCache || (cacheDir != NULL && cacheDir[0] == '\0')) {
+        cacheDir = NULL;
+    }
+
+    // The reference engine only knows the two original queues
+    if (reference && (levelsGiven || aging || edf || restoreFile || checkpointFile || numBranches > 0)) {
+        printf("\n--reference only runs the original two queue engine and takes no other engine options\n");
         return 1;
     }
 
-    // Parse the input file
-    pQueue *queueB = ParseFile(sim.input_file, sim.quantumB);
+    // Batch mode runs whole files on worker threads and only reports totals;
+    // a sweep does the same on worker processes, a server on request, the
+    // autotuner for every candidate configuration and an approximate run
+    // for sampled windows of the trace
+    if (batchResults != NULL || sweepResults != NULL || server.address != NULL || tuneObjective != NULL || sampleSpec != NULL) {
+        if (reference || generateSpec || restoreFile || checkpointFile || numBranches > 0 ||
+            progressInterval > 0 || progressShm != NULL || !isFullRange(&range) || importing || edf ||
+            (batchResults != NULL) + (sweepResults != NULL) + (server.address != NULL) + (tuneObjective != NULL) + (sampleSpec != NULL) > 1) {
+            printf("\n--batch, --sweep, --serve, --tune and --approximate cannot be combined with each other or with --reference, --generate, --restore, --checkpoint, --branch, --progress, --import, --edf or a range\n");
+            return 1;
+        }
+        if (sweepResults != NULL && sweep.address == NULL) {
+            printf("\n--sweep needs --listen <address>\n");
+            return 1;
+        }
+        BatchSettings settings;
+        memcpy(settings.levels, levels, numLevels * sizeof(Level));
+        settings.numLevels = numLevels;
+        settings.aging = aging;
+        settings.limit = batchLimit;
+        settings.workers = batchWorkers > 0 ? batchWorkers : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (settings.workers < 1) {
+            settings.workers = 1;
+        }
+        settings.cache = NULL;
+
+        // the command line configuration comes first
+        configs[0].quantumA = levels[0].quantum;
+        configs[0].quantumB = levels[numLevels - 1].quantum;
+        configs[0].preemption = sim.preemption;
+        if (tuneObjective != NULL || sampleSpec != NULL) {
+            int failed = tuneObjective != NULL ? autotune(argv[1], &settings, &tune)
+                                               : approximateRun(argv[1], &configs[0], &settings, &sample);
+            free(branches);
+            free(configs);
+            return failed != 0;
+        }
+        if (cacheDir != NULL && server.address == NULL) {
+            if (openResultCache(&cache, cacheDir, cacheLimit) == 0) {
+                settings.cache = &cache;
+            } else {
+                fprintf(stderr, "Could not open result cache %s\n", cacheDir);
+            }
+        }
+        if (server.address != NULL) {
+            server.workers = settings.workers;
+            serveSimulations(&configs[0], &settings, &server);
+            free(branches);
+            free(configs);
+            return 1;
+        }
+        int failed = sweepResults != NULL
+            ? simulateSweep(argv[1], configs, numConfigs + 1, &settings, &sweep, sweepResults)
+            : simulateBatch(argv[1], configs, numConfigs + 1, &settings, batchResults);
+        if (settings.cache != NULL) {
+            closeResultCache(&cache);
+        }
+        free(branches);
+        free(configs);
+        return failed != 0;
+    }
+    free(configs);
+
+    // Generated processes are freed as they complete, so there is nothing to
+    // snapshot, branch from or hand to the reference engine
+    GeneratorSpec spec;
+    if (generateSpec != NULL && parseGeneratorSpec(generateSpec, &spec) != 0) {
+        printf("\nInvalid generator: %s\n", generateSpec);
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (generateSpec != NULL && (reference || restoreFile || checkpointFile || numBranches > 0 || edf)) {
+        printf("\n--generate cannot be combined with --reference, --restore, --checkpoint, --branch or --edf\n");
+        return 1;
+    }
+    if (!isFullRange(&range) && (generateSpec != NULL || restoreFile != NULL)) {
+        printf("\n--from-arrival, --to-arrival, --from-pid and --to-pid select processes of <input-file> and cannot be combined with --generate or --restore\n");
+        return 1;
+    }
+    // Imported processes need idle time to pass, which neither the reference
+    // engine nor a snapshot knows about
+    if (importing && (generateSpec != NULL || restoreFile != NULL || reference || checkpointFile != NULL || !isFullRange(&range))) {
+        printf("\n--import reads <input-file> as a scheduler trace and cannot be combined with --generate, --restore, --reference, --checkpoint or a range\n");
+        return 1;
+    }
+
+    // Set up the optional progress reporter
+    if (progressInterval > 0 || progressShm != NULL) {
+        sim.progress = createProgress(progressInterval > 0 ? progressInterval : PROGRESS_INTERVAL, 1.0);
+        sim.progress->toStderr = progressInterval > 0;
+        if (progressShm != NULL && attachProgressBlock(sim.progress, progressShm) != 0) {
+            printf("Error: Could not create shared-memory block %s\n", progressShm);
+            return 1;
+        }
+    }
+
+    // A plain run of a whole trace can be answered from the result cache; a
+    // ranged run would have to hash all of the trace it avoids reading, and
+    // an import depends on settings the key does not cover
+    char cacheKey[CACHE_KEY];
+    const char *cacheKind = edf ? "edf" : "out";
+    int cached = 0;
+    if (cacheDir != NULL && !reference && generateSpec == NULL && restoreFile == NULL && checkpointFile == NULL &&
+        numBranches == 0 && !memoryReport && sim.progress == NULL && isFullRange(&range) && !importing &&
+        resultKey(cacheKey, argv[1], cacheKind, levels, numLevels, sim.preemption, aging, 0) == 0 &&
+        openResultCache(&cache, cacheDir, cacheLimit) == 0) {
+        char *data;
+        size_t size;
+        if (loadResult(&cache, cacheKey, cacheKind, &data, &size) == 0) {
+            fwrite(data, 1, size, stdout);
+            free(data);
+            closeResultCache(&cache);
+            free(branches);
+            return 0;
+        }
+        cached = 1;
+    }
+
+    Generator *generator = NULL;
+    TraceStream *stream = NULL;
+    if (generateSpec != NULL) {
+        // Start with no processes and let the generator feed the lowest level
+        generator = createGenerator(&spec);
+        if (generator == NULL || initializeSimulation(&sim, levels, numLevels, sim.preemption, createProcessQueue()) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 1;
+        }
+        setAging(&sim, aging);
+        attachGenerator(&sim, generator);
+    } else if (restoreFile != NULL) {
+        // Resume from the snapshot (its quanta and preemption flag are used)
+        if (loadCheckpoint(&sim, restoreFile) != 0) {
+            freeSimulation(&sim);
+            printf("Error: Could not restore snapshot %s\n", restoreFile);
+            return 1;
+        }
+        if (setDeadlineOrder(&sim, edf) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 1;
+        }
+    } else {
+        // Open the input file
+        sim.input_file = openTrace(argv[1]);
+        if (sim.input_file == NULL) {
+            if (errno == ENOENT) {
+                printf("Error: File %s does not exist\n", argv[1]);
+            } else {
+                printf("Error: Could not open file %s\n", argv[1]);
+            }
+            return 1;
+        }
+
+        // A plain run reads the trace on another thread while it simulates,
+        // unless something needs every process up front (deadline order
+        // does) or demotes into the lowest level, whose order would then
+        // depend on unread processes
+        int streamable = !noStream && isFullRange(&range) && !importing && !reference && checkpointFile == NULL && numBranches == 0 && !edf &&
+                         !memoryReport && (numLevels < 2 || levels[numLevels - 2].demote == 0);
+        if (streamable && (stream = openTraceStream(sim.input_file, levels[numLevels - 1].quantum)) != NULL) {
+            sim.input_file = NULL;
+        }
+
+        // Parse the input file, or only the records of the range through its index
+        pQueue *queue;
+        if (stream != NULL) {
+            queue = createProcessQueue();
+        } else if (importing) {
+            // Turn the scheduler trace into processes, saving them as a trace if asked
+            ImportStats stats;
+            ParseError err;
+            queue = createProcessQueue();
+            if (queue == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            if (importSchedTrace(sim.input_file, importTick * 1000, levels[numLevels - 1].quantum, queue, &stats, &err) != PARSE_OK) {
+                fprintf(stderr, "%s\n", err.message);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr, "Imported %ld tasks from %lld scheduler events (%ld ran for less than a tick, %lld unreadable events)\n",
+                    stats.tasks, stats.events, stats.idle, stats.skipped);
+            if (queue->size == 0) {
+                printf("Error: No tasks ran in %s\n", argv[1]);
+                return 1;
+            }
+            FILE *out = importSave != NULL ? fopen(importSave, "w") : NULL;
+            if (importSave != NULL && (out == NULL || (writeImportedTrace(out, queue) != 0) | (fclose(out) != 0))) {
+                printf("Error: Could not write %s\n", importSave);
+                return 1;
+            }
+        } else if (isFullRange(&range)) {
+            queue = ParseFile(sim.input_file, levels[numLevels - 1].quantum);
+        } else {
+            ParseError err;
+            queue = createProcessQueue();
+            if (queue == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            if (parseTraceRange(argv[1], sim.input_file, &range, levels[numLevels - 1].quantum, queue, &err) != PARSE_OK) {
+                fprintf(stderr, "%s\n", err.message);
+                exit(EXIT_FAILURE);
+            }
+            if (queue->size == 0) {
+                printf("Error: No processes of %s in the range\n", argv[1]);
+                return 1;
+            }
+        }
+
+        // Close the input file
+        if (sim.input_file != NULL) {
+            fclose(sim.input_file);
+        }
+
+        // The reference engine and snapshots know nothing of fair-share
+        // groups, and deadline order leaves no room for their shares
+        if (findGroups(queue) != NULL && (reference || checkpointFile != NULL || edf)) {
+            printf("\nThe groups of %s cannot be combined with --reference, --checkpoint or --edf\n", argv[1]);
+            return 1;
+        }
+
+        // Run the frozen reference engine instead if requested
+        if (reference) {
+            Reference ref;
+            int status = runReference(&ref, levels[0].quantum, levels[1].quantum, sim.preemption, queue, 0);
+            if (status == 0) {
+                printStats(ref.exitQueue, ref.stats);
+            } else {
+                fprintf(stderr, "Memory allocation failed\n");
+            }
+            if (memoryReport) {
+                printMemoryUsage(stderr);
+            }
+            freeReference(&ref);
+            free(branches);
+            freeProgress(sim.progress);
+            return status != 0;
+        }
+
+        if (initializeSimulation(&sim, levels, numLevels, sim.preemption, queue) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 1;
+        }
+        setAging(&sim, aging);
+        if (setDeadlineOrder(&sim, edf) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 1;
+        }
+
+        // a traced host idles between tasks, as generated runs do
+        if (importing) {
+            sim.idleTicks = 1;
+        }
+        if (stream != NULL && attachStream(&sim, stream) != 0 && !stream->late) {
+            failStream(stream);
+        }
+    }
+
+    // Set up periodic snapshots
+    if (checkpointFile != NULL) {
+        sim.checkpoint = createCheckpoint(checkpointFile, checkpointInterval);
+        sim.checkpoint->next = sim.stats->runtime + sim.checkpoint->interval;
+    }
+
+    // Run simulation, splitting into branches at the branch time if requested
+    int status = 0;
+    if (numBranches > 0) {
+        branches = (Branch *)realloc(branches, (numBranches + 1) * sizeof(Branch));
+        branches[numBranches].quantumA = sim.level[0].quantum;
+        branches[numBranches].quantumB = sim.level[sim.levels - 1].quantum;
+        branches[numBranches].preemption = sim.preemption;
+        // the command line configuration runs as the last branch
+        status = simulateBranches(&sim, branchTime, branches, numBranches + 1) != 0;
+    } else {
+        // on a cache miss the output is captured on its way out and stored
+        OutputCapture capture;
+        int capturing = cached && beginCapture(&capture) == 0;
+        int failed = stream != NULL && stream->late ? -1 : Simulate(&sim);
+        if (failed != 0 && stream != NULL) {
+            if (!stream->late) {
+                failStream(stream);
+            }
+            // a trace out of arrival order is run again from a full parse
+            closeTraceStream(stream);
+            stream = NULL;
+            freeSimulation(&sim);
+            FILE *file = openTrace(argv[1]);
+            if (file == NULL) {
+                printf("Error: Could not open file %s\n", argv[1]);
+                return 1;
+            }
+            pQueue *queue = ParseFile(file, levels[numLevels - 1].quantum);
+            fclose(file);
+            failed = initializeSimulation(&sim, levels, numLevels, sim.preemption, queue);
+            if (failed == 0) {
+                setAging(&sim, aging);
+                failed = Simulate(&sim);
+            }
+        }
+        if (failed != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            status = 1;
+        }
+        char *data;
+        size_t size;
+        if (capturing && endCapture(&capture, &data, &size) == 0) {
+            if (status == 0) {
+                storeResult(&cache, cacheKey, cacheKind, data, size);
+            }
+            free(data);
+        }
+    }
+    if (cached) {
+        closeResultCache(&cache);
+    }
 
-    // Close the input file
-    fclose(sim.input_file);
+    if (memoryReport) {
+        printMemoryUsage(stderr);
+    }
 
-    // Run simulation
-    Simulate(sim.quantumA, sim.quantumB, sim.preemption, queueB);
+    free(branches);
+    freeSimulation(&sim);
+    closeTraceStream(stream);
+    freeGenerator(generator);
+    freeCheckpoint(sim.checkpoint);
+    freeProgress(sim.progress);
+    return status;
 }
+
+#endif
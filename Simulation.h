@@ -15,37 +15,92 @@
  #define INT_MAX 2147483647
  #endif
 
+ #ifndef MAX_LEVELS
+ #define MAX_LEVELS 26  // one level per letter, from A (highest) down
+ #endif
+
+ #ifndef PROMOTE_AFTER
+ #define PROMOTE_AFTER 3 // default completions or interrupts before promotion
+ #endif
+
+ #ifndef ENGINE_VERSION
+ #define ENGINE_VERSION 6 // bump whenever a change alters the results of a simulation
+ #endif
+
+ #ifndef PROGRESS_INTERVAL
+ #define PROGRESS_INTERVAL 65536
+ #endif
+
  #include <stdio.h>
  #include "queue.h"
+ #include "progress.h"
+
+ struct Checkpoint;
+ struct Generator;
+ struct TraceStream;
+ struct GroupTree;
+ struct DeadlineHeap;
+
+ // Struct for the statistics
+ typedef struct Stats {
+     Ticks instructions; // total number of instructions
+     Ticks startTime;   // start time of simulation
+     Ticks runtime;     // total runtime of simulation
+     Ticks maxWait;     // maximum wait time
+     Ticks minWait;     // minimum wait time, INT_MAX until a process completes
+     Ticks totalWait;   // total wait time
+ } Stats;
+
+ // Struct for one level of the feedback queue
+ typedef struct Level {
+     pQueue *queue;     // processes at this level
+     tQueue *ready;     // interrupted tasks waiting at this level
+     int quantum;       // quantum for execution at this level
+     int promote;       // completions or interrupts before moving up, 0 = never
+     int demote;        // quantum expiries before moving down, 0 = never
+ } Level;
 
  // Struct for the simulation
  typedef struct Simulation {
      FILE *input_file;  // file pointer for input file
-     int quantumA;      // quantum for queueA
-     int quantumB;      // quantum for queueB
      int preemption;    // flag for preemption
-     int CPU;           // flag for CPU availability
+     int CPU;           // flag for CPU in use
      int start;         // flag for start of simulation
      int end;           // flag for end of simulation
-     pQueue *queueB;    // main process queue
+     int loop;          // level being serviced ('A', 'B', ... or 0 between passes)
+     int idleTicks;     // flag for letting time pass while nothing is runnable
+     Ticks lastArrival; // latest arrival of an owned process seen so far
+     int levels;        // number of levels, the last one is where processes enter
+     int aging;         // ready ticks per point of priority aging, 0 = none
+     unsigned int active; // bitmap of levels with queued processes or ready tasks
+     Level level[MAX_LEVELS]; // levels from highest (A) to lowest
+     pQueue *exitQueue; // completed process queue
+     tQueue *ioQueue;   // tasks performing I/O
+     Task *task;        // task currently on the CPU
+     Process *owned;    // every process owned by the engine
+     Stats *stats;      // running statistics
+     Progress *progress; // optional progress reporter
+     struct Checkpoint *checkpoint; // optional periodic snapshots
+     struct Generator *generator; // optional open-loop arrivals
+     struct TraceStream *stream; // optional trace read ahead on another thread
+     struct GroupTree *groups; // fair-share groups of the trace, NULL if it names none
+     struct DeadlineHeap *deadlines; // earliest-deadline-first order, NULL unless enabled
  } Simulation;
 
- // Struct for the statistics
- typedef struct Stats {
-     int instructions;  // total number of instructions
-     int startTime;     // start time of simulation
-     int runtime;       // total runtime of simulation
-     int maxWait;       // maximum wait time
-     int minWait;       // minimum wait time
-     float totalWait;   // total wait time
- } Stats;
-
  // function prototypes
- void Simulate(int quantumA, int quantumB, int preemption, pQueue *queueB);
+ int Simulate(Simulation *sim);
  Stats *initializeStats();
- int allQueuesEmpty(pQueue *queueA, pQueue *queueB, tQueue *readyQueueA, tQueue *readyQueueB, tQueue *ioQueue);
- void runPreemption(int quantumA, int quantumB, pQueue *queueB);
- void runNonPreemption(int quantumA, int quantumB, pQueue *queueB);
+ int defaultLevels(Level *levels, int quantumA, int quantumB);
+ const char *levelName(int level);
+ void adoptProcess(Simulation *sim, Process *p);
+ void retireProcess(Simulation *sim, Process *p);
+ int initializeSimulation(Simulation *sim, const Level *levels, int count, int preemption, pQueue *queue);
+ void refreshLevels(Simulation *sim);
+ void setAging(Simulation *sim, int aging);
+ int setDeadlineOrder(Simulation *sim, int edf);
+ void freeSimulation(Simulation *sim);
+ int allQueuesEmpty(Simulation *sim);
+ int stepSimulation(Simulation *sim);
  void printStats(pQueue *exitQueue, Stats *stats);
  int main(int argc, char *argv[]);
 
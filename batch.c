@@ -0,0 +1,457 @@
+/*
+ * batch.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of batch mode. Every trace is run
+ * under every configuration as a separate job. Worker threads take jobs
+ * from a shared counter, and since the object pools are per thread, each
+ * worker allocates and recycles its own tasks, processes and nodes without
+ * any locking. Results are written in job order once all jobs have
+ * finished, so the results file does not depend on scheduling.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glob.h>
+#include <pthread.h>
+
+#include "batch.h"
+#include "parser.h"
+#include "decompress.h"
+#include "pool.h"
+
+// Struct for the state shared by the worker threads
+typedef struct BatchPool {
+    BatchJob *jobs;                     // jobs in result order
+    int count;                          // number of jobs
+    int next;                           // index of the next job to take
+    const BatchSettings *settings;      // settings shared by every job
+} BatchPool;
+
+/*
+ * Function: addInput
+ *
+ * Appends a copy of path to a growing list of inputs. Returns 0 on
+ * success, -1 if allocation fails.
+ */
+static int addInput(char ***paths, int *count, int *capacity, const char *path) {
+    if (*count == *capacity) {
+        int grown = *capacity ? 2 * *capacity : 64;
+        char **list = (char **)realloc(*paths, grown * sizeof(char *));
+        if (list == NULL) {
+            return -1;
+        }
+        *paths = list;
+        *capacity = grown;
+    }
+    if (((*paths)[*count] = strdup(path)) == NULL) {
+        return -1;
+    }
+    (*count)++;
+    return 0;
+}
+
+/*
+ * Function: listBatchInputs
+ *
+ * Expands an input specification into trace paths: either @file, naming a
+ * file with one path per line ('#' starts a comment), or a glob pattern.
+ * Returns the number of paths, or -1 if the list cannot be read or the
+ * pattern matches nothing.
+ */
+int listBatchInputs(const char *spec, char ***paths) {
+    int count = 0, capacity = 0;
+    *paths = NULL;
+
+    if (spec[0] == '@') {
+        FILE *f = fopen(spec + 1, "r");
+        if (f == NULL) {
+            return -1;
+        }
+        char line[4096];
+        while (fgets(line, sizeof(line), f) != NULL) {
+            line[strcspn(line, "#\r\n")] = '\0';
+            char *end = line + strlen(line);
+            while (end > line && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+            char *start = line + strspn(line, " \t");
+            if (*start != '\0' && addInput(paths, &count, &capacity, start) != 0) {
+                fclose(f);
+                freeBatchInputs(*paths, count);
+                return -1;
+            }
+        }
+        fclose(f);
+        return count;
+    }
+
+    glob_t matches;
+    if (glob(spec, 0, NULL, &matches) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < matches.gl_pathc; i++) {
+        if (addInput(paths, &count, &capacity, matches.gl_pathv[i]) != 0) {
+            globfree(&matches);
+            freeBatchInputs(*paths, count);
+            return -1;
+        }
+    }
+    globfree(&matches);
+    return count;
+}
+
+/*
+ * Function: freeBatchInputs
+ *
+ * Frees a list of paths returned by listBatchInputs
+ */
+void freeBatchInputs(char **paths, int count) {
+    for (int i = 0; i < count; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+/*
+ * Function: batchLevels
+ *
+ * Fills levels with the batch levels under a job's quanta and returns
+ * their number
+ */
+int batchLevels(Level *levels, const BatchSettings *settings, const Branch *config) {
+    int count = settings->numLevels;
+    memcpy(levels, settings->levels, count * sizeof(Level));
+    levels[0].quantum = config->quantumA;
+    levels[count - 1].quantum = config->quantumB;
+    return count;
+}
+
+/*
+ * Function: formatBatchOutcome
+ *
+ * Writes the outcome of a job as one line of text, without a newline,
+ * for parseBatchOutcome to read back. Returns the length snprintf gives.
+ */
+int formatBatchOutcome(char *line, size_t size, const BatchJob *job) {
+    return snprintf(line, size, "%d %d %lld %lld %d %lld %lld %lld %lld %ld %s", job->status, job->line,
+                    job->startTime, job->endTime, job->completed, job->instructions, job->totalWait,
+                    job->maxWait, job->minWait, job->iterations, job->message ? job->message : "-");
+}
+
+/*
+ * Function: parseBatchOutcome
+ *
+ * Reads an outcome written by formatBatchOutcome into a job, leaving its
+ * path, configuration and message alone. Returns the offset of the
+ * message within line, or -1 if the line is malformed.
+ */
+int parseBatchOutcome(const char *line, BatchJob *job) {
+    int offset = 0;
+    if (sscanf(line, "%d %d %lld %lld %d %lld %lld %lld %lld %ld %n", &job->status, &job->line,
+               &job->startTime, &job->endTime, &job->completed, &job->instructions, &job->totalWait,
+               &job->maxWait, &job->minWait, &job->iterations, &offset) < 10 || offset == 0) {
+        return -1;
+    }
+    return offset;
+}
+
+/*
+ * Function: batchResultKey
+ *
+ * Computes the result cache key of a job. Returns 0 on success, -1 if
+ * its trace could not be read.
+ */
+int batchResultKey(char *key, const BatchJob *job, const BatchSettings *settings) {
+    Level levels[MAX_LEVELS];
+    int count = batchLevels(levels, settings, &job->config);
+    return resultKey(key, job->path, "row", levels, count, job->config.preemption, settings->aging, settings->limit);
+}
+
+/*
+ * Function: loadBatchResult
+ *
+ * Fills in a job's outcome from the result cache. Returns 1 on a hit,
+ * 0 on a miss.
+ */
+int loadBatchResult(BatchJob *job, const BatchSettings *settings, const char *key) {
+    char *data;
+    size_t size;
+    if (loadResult(settings->cache, key, "row", &data, &size) != 0) {
+        return 0;
+    }
+    BatchJob r = *job;
+    int hit = parseBatchOutcome(data, &r) >= 0 && r.status >= 0;
+    free(data);
+    if (hit) {
+        r.message = NULL;
+        *job = r;
+    }
+    return hit;
+}
+
+/*
+ * Function: storeBatchResult
+ *
+ * Stores a job's outcome in the result cache. Only runs that finished or
+ * reached the iteration limit are stored; errors are worth retrying.
+ */
+void storeBatchResult(const BatchJob *job, const BatchSettings *settings, const char *key) {
+    if (job->status < 0) {
+        return;
+    }
+    char line[256];
+    int length = formatBatchOutcome(line, sizeof(line), job);
+    if (length > 0 && length < (int)sizeof(line)) {
+        storeResult(settings->cache, key, "row", line, length);
+    }
+}
+
+/*
+ * Function: runBatchQueue
+ *
+ * Simulates parsed processes under a job's configuration and records the
+ * outcome in the job. The engine takes ownership of queue and is left in
+ * sim, for the caller to inspect and then free with freeSimulation.
+ */
+void runBatchQueue(BatchJob *job, const BatchSettings *settings, pQueue *queue, Simulation *sim) {
+    Level levels[MAX_LEVELS];
+    int count = batchLevels(levels, settings, &job->config);
+
+    job->iterations = 0;
+    int status = initializeSimulation(sim, levels, count, job->config.preemption, queue);
+    if (status == 0) {
+        setAging(sim, settings->aging);
+        while ((status = stepSimulation(sim)) > 0) {
+            job->iterations++;
+            if (settings->limit > 0 && job->iterations >= settings->limit) {
+                break;
+            }
+        }
+    }
+
+    job->status = status < 0 ? BATCH_NOMEM : status > 0 ? BATCH_LIMIT : BATCH_DONE;
+    if (status < 0) {
+        job->message = "Memory allocation failed";
+    }
+    Stats *s = sim->stats;
+    if (s != NULL) {
+        job->startTime = s->startTime;
+        job->endTime = s->runtime;
+        job->completed = sim->exitQueue ? sim->exitQueue->size : 0;
+        job->instructions = s->instructions;
+        job->totalWait = s->totalWait;
+        job->maxWait = s->maxWait;
+        job->minWait = s->minWait;
+    }
+}
+
+/*
+ * Function: runBatchJob
+ *
+ * Parses and simulates one job on the calling thread and records its
+ * outcome in the job, or takes the outcome from the result cache
+ */
+void runBatchJob(BatchJob *job, const BatchSettings *settings) {
+    job->line = 0;
+    job->message = NULL;
+    job->iterations = 0;
+
+    // a stored result needs neither the parser nor the engine
+    char key[CACHE_KEY];
+    int keyed = settings->cache != NULL && batchResultKey(key, job, settings) == 0;
+    if (keyed && loadBatchResult(job, settings, key)) {
+        return;
+    }
+
+    FILE *file = openTrace(job->path);
+    if (file == NULL) {
+        job->status = BATCH_OPEN;
+        job->message = "Could not open file";
+        return;
+    }
+
+    pQueue *queue = createProcessQueue();
+    ParseError err;
+    int parsed = queue ? parseProcesses(file, job->config.quantumB, queue, &err) : PARSE_NOMEM;
+    fclose(file);
+    if (parsed != PARSE_OK) {
+        // a failed parse leaves the processes it queued to the caller
+        Process *p;
+        while (queue != NULL && (p = dequeueProcess(queue)) != NULL) {
+            freeProcess(p);
+        }
+        freeProcessQueue(queue);
+        job->status = parsed == PARSE_NOMEM ? BATCH_NOMEM : BATCH_PARSE;
+        job->line = parsed == PARSE_NOMEM ? 0 : err.line;
+        job->message = parsed == PARSE_NOMEM ? "Memory allocation failed" : err.message;
+        return;
+    }
+
+    Simulation sim = { 0 };
+    runBatchQueue(job, settings, queue, &sim);
+    freeSimulation(&sim);
+    if (keyed) {
+        storeBatchResult(job, settings, key);
+    }
+}
+
+/*
+ * Function: batchWorker
+ *
+ * Worker thread body: takes jobs until none are left, then hands the
+ * thread's pooled objects back to the allocator
+ */
+static void *batchWorker(void *arg) {
+    BatchPool *pool = (BatchPool *)arg;
+    int i;
+    while ((i = __sync_fetch_and_add(&pool->next, 1)) < pool->count) {
+        runBatchJob(&pool->jobs[i], pool->settings);
+    }
+    poolTrim();
+    return NULL;
+}
+
+/*
+ * Function: runBatchJobs
+ *
+ * Runs every job on settings->workers threads. Returns the number of jobs
+ * that did not run to completion.
+ */
+int runBatchJobs(BatchJob *jobs, int count, const BatchSettings *settings) {
+    BatchPool pool = { jobs, count, 0, settings };
+    int workers = settings->workers < count ? settings->workers : count;
+    pthread_t *threads = (pthread_t *)malloc((workers > 0 ? workers : 1) * sizeof(pthread_t));
+    if (threads == NULL) {
+        workers = 0;
+    }
+
+    int started = 0;
+    while (started < workers && pthread_create(&threads[started], NULL, batchWorker, &pool) == 0) {
+        started++;
+    }
+    // without any thread the jobs still run, on the calling thread
+    if (started == 0) {
+        batchWorker(&pool);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        failed += jobs[i].status != BATCH_DONE;
+    }
+    return failed;
+}
+
+/*
+ * Function: writeBatchHeader
+ *
+ * Writes the column names of the results file
+ */
+void writeBatchHeader(FILE *f) {
+    fprintf(f, "file\tquantumA\tquantumB\tpreemption\tstatus\tstart\tend\tcompleted\tinstructions\tavg_ready\tmax_ready\tmin_ready\n");
+}
+
+/*
+ * Function: writeBatchResult
+ *
+ * Writes one tab separated row of results. The statistics are formatted
+ * as printStats formats them, so a row matches a single run of the file.
+ */
+void writeBatchResult(FILE *f, const BatchJob *job) {
+    fprintf(f, "%s\t%d\t%d\t%d\t", job->path, job->config.quantumA, job->config.quantumB, job->config.preemption);
+    switch (job->status) {
+        case BATCH_DONE:
+        case BATCH_LIMIT:
+            fprintf(f, "%s\t%lld\t%lld\t%d\t%lld\t%.2f\t%lld\t%lld\n", job->status == BATCH_DONE ? "done" : "limit",
+                    job->startTime, job->endTime, job->completed, job->instructions,
+                    (double)job->totalWait / job->completed, job->maxWait, job->minWait);
+            break;
+        case BATCH_PARSE:
+            fprintf(f, "error: line %d: %s\n", job->line, job->message);
+            break;
+        default:
+            fprintf(f, "error: %s\n", job->message);
+            break;
+    }
+}
+
+/*
+ * Function: writeBatchResults
+ *
+ * Writes the header and one row per job, in job order
+ */
+void writeBatchResults(FILE *f, const BatchJob *jobs, int count) {
+    writeBatchHeader(f);
+    for (int i = 0; i < count; i++) {
+        writeBatchResult(f, &jobs[i]);
+    }
+    fflush(f);
+}
+
+/*
+ * Function: createBatchJobs
+ *
+ * Creates one job for every input under every configuration, in input
+ * then configuration order, or returns NULL if allocation fails
+ */
+BatchJob *createBatchJobs(char **paths, int numPaths, const Branch *configs, int numConfigs) {
+    int count = numPaths * numConfigs;
+    BatchJob *jobs = (BatchJob *)calloc(count > 0 ? count : 1, sizeof(BatchJob));
+    if (jobs == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < numPaths; i++) {
+        for (int j = 0; j < numConfigs; j++) {
+            jobs[i * numConfigs + j].path = paths[i];
+            jobs[i * numConfigs + j].config = configs[j];
+        }
+    }
+    return jobs;
+}
+
+/*
+ * Function: simulateBatch
+ *
+ * Runs every input under every configuration and writes the results to
+ * the file results ("-" for stdout). Returns the number of jobs that did
+ * not run to completion, or -1 if the batch could not be set up.
+ */
+int simulateBatch(const char *inputs, const Branch *configs, int numConfigs, const BatchSettings *settings, const char *results) {
+    char **paths;
+    int numPaths = listBatchInputs(inputs, &paths);
+    if (numPaths < 0) {
+        fprintf(stderr, "No inputs found for %s\n", inputs);
+        return -1;
+    }
+
+    int count = numPaths * numConfigs;
+    BatchJob *jobs = createBatchJobs(paths, numPaths, configs, numConfigs);
+    if (jobs == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        freeBatchInputs(paths, numPaths);
+        return -1;
+    }
+
+    FILE *out = strcmp(results, "-") == 0 ? stdout : fopen(results, "w");
+    if (out == NULL) {
+        perror(results);
+        free(jobs);
+        freeBatchInputs(paths, numPaths);
+        return -1;
+    }
+
+    int failed = runBatchJobs(jobs, count, settings);
+
+    writeBatchResults(out, jobs, count);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    free(jobs);
+    freeBatchInputs(paths, numPaths);
+    return failed;
+}
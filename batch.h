@@ -0,0 +1,73 @@
+/*
+ * batch.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for batch mode: simulating many
+ * trace files under one or more configurations in a single invocation,
+ * on a pool of worker threads, with one consolidated results file.
+ */
+
+ #ifndef BATCH_H
+ #define BATCH_H
+
+ #include <stdio.h>
+ #include "Simulation.h"
+ #include "branch.h"
+ #include "cache.h"
+
+ // Batch job outcomes
+ #define BATCH_DONE 0           // ran to completion
+ #define BATCH_LIMIT 1          // stopped by the iteration limit
+ #define BATCH_OPEN -1          // input could not be opened
+ #define BATCH_PARSE -2         // input could not be parsed
+ #define BATCH_NOMEM -3         // engine ran out of memory
+ #define BATCH_FAILED -4        // no worker returned a result
+
+ // Struct for the settings shared by every job of a batch
+ typedef struct BatchSettings {
+     Level levels[MAX_LEVELS];  // levels, highest first
+     int numLevels;             // number of levels
+     int aging;                 // ready ticks per point of priority aging, 0 = none
+     long limit;                // loop iterations per job, 0 = no limit
+     int workers;               // worker threads
+     ResultCache *cache;        // finished results to reuse, NULL = none
+ } BatchSettings;
+
+ // Struct for one trace under one configuration, and its outcome
+ typedef struct BatchJob {
+     const char *path;          // trace file
+     Branch config;             // quanta and preemption flag
+     int status;                // BATCH_DONE, BATCH_LIMIT or an error
+     int line;                  // line of a parse error
+     const char *message;       // description of an error
+     Ticks startTime;           // start time of simulation
+     Ticks endTime;             // end time of simulation
+     int completed;             // number of processes completed
+     Ticks instructions;        // number of instructions completed
+     Ticks totalWait;           // total ready time of completed processes
+     Ticks maxWait;             // maximum ready time
+     Ticks minWait;             // minimum ready time
+     long iterations;           // scheduler loop iterations
+ } BatchJob;
+
+ // function prototypes
+ int listBatchInputs(const char *spec, char ***paths);
+ void freeBatchInputs(char **paths, int count);
+ int formatBatchOutcome(char *line, size_t size, const BatchJob *job);
+ int parseBatchOutcome(const char *line, BatchJob *job);
+ int batchLevels(Level *levels, const BatchSettings *settings, const Branch *config);
+ int batchResultKey(char *key, const BatchJob *job, const BatchSettings *settings);
+ int loadBatchResult(BatchJob *job, const BatchSettings *settings, const char *key);
+ void storeBatchResult(const BatchJob *job, const BatchSettings *settings, const char *key);
+ void runBatchQueue(BatchJob *job, const BatchSettings *settings, pQueue *queue, Simulation *sim);
+ void runBatchJob(BatchJob *job, const BatchSettings *settings);
+ int runBatchJobs(BatchJob *jobs, int count, const BatchSettings *settings);
+ void writeBatchHeader(FILE *f);
+ void writeBatchResult(FILE *f, const BatchJob *job);
+ void writeBatchResults(FILE *f, const BatchJob *jobs, int count);
+ BatchJob *createBatchJobs(char **paths, int numPaths, const Branch *configs, int numConfigs);
+ int simulateBatch(const char *inputs, const Branch *configs, int numConfigs, const BatchSettings *settings, const char *results);
+
+ #endif
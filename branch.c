@@ -0,0 +1,159 @@
+/*
+ * branch.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of what-if branching. The shared
+ * prefix is simulated once; every branch is then a fork() of the engine, so
+ * the processes, tasks and queues are shared copy-on-write and only the
+ * pages a branch modifies are copied. Branches run concurrently and their
+ * reports are relayed through pipes in branch order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "branch.h"
+
+/*
+ * Function: parseBranch
+ *
+ * Parses a branch specification of the form quantumA:quantumB:preemption.
+ * Returns 0 on success, -1 if the specification is invalid.
+ */
+int parseBranch(const char *spec, Branch *b) {
+    if (sscanf(spec, "%d:%d:%d", &b->quantumA, &b->quantumB, &b->preemption) != 3) {
+        return -1;
+    }
+    if (b->quantumA < 2 || b->quantumB < 2) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: runToTime
+ *
+ * Steps the simulation until the simulated time reaches time or the
+ * simulation ends. Returns 0 on success, -1 if a queue node cannot be
+ * allocated.
+ */
+int runToTime(Simulation *sim, Ticks time) {
+    int status = 1;
+    while (sim->stats->runtime < time && (status = stepSimulation(sim)) > 0);
+    return status < 0 ? -1 : 0;
+}
+
+/*
+ * Function: simulateBranches
+ *
+ * Runs the simulation up to branchTime and then forks one child per branch
+ * configuration. Each child finishes the run under its own quanta and
+ * preemption flag and prints its own statistics. Returns the number of
+ * branches that failed, all of them if the shared prefix fails.
+ */
+int simulateBranches(Simulation *sim, Ticks branchTime, Branch *branches, int count) {
+    // a broken engine is not forked, so every branch fails with the prefix
+    if (runToTime(sim, branchTime) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return count;
+    }
+
+    int *pipes = (int *)malloc(count * sizeof(int));
+    pid_t *pids = (pid_t *)malloc(count * sizeof(pid_t));
+    if (!pipes || !pids) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // flush so buffered output is not duplicated into the children
+    fflush(stdout);
+    fflush(stderr);
+
+    for (int i = 0; i < count; i++) {
+        int fds[2];
+        pids[i] = -1;
+        pipes[i] = -1;
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            continue;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // child: report through the pipe and finish this branch
+            close(fds[0]);
+            for (int j = 0; j < i; j++) {
+                if (pipes[j] >= 0) close(pipes[j]);
+            }
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[1]);
+
+            // snapshots and the shared progress block belong to the parent
+            sim->checkpoint = NULL;
+            if (sim->progress) {
+                sim->progress->block = NULL;
+            }
+
+            // processes that have not used any CPU yet start with the branch quantum
+            Level *entry = &sim->level[sim->levels - 1];
+            for (pNode *n = entry->queue->head; n != NULL; n = n->next) {
+                Process *p = n->process;
+                if (p->arrival >= sim->stats->runtime && p->taskRunning == 0 &&
+                    p->currentTask == 0 && p->quantum == entry->quantum) {
+                    p->quantum = branches[i].quantumB;
+                }
+            }
+
+            sim->level[0].quantum = branches[i].quantumA;
+            entry->quantum = branches[i].quantumB;
+            sim->preemption = branches[i].preemption == 1;
+
+            printf("Branch %d: quantumA:%d quantumB:%d preemption:%d from time:%lld\n",
+                   i + 1, branches[i].quantumA, branches[i].quantumB, branches[i].preemption, sim->stats->runtime);
+            int status = Simulate(sim);
+            fflush(stdout);
+            _exit(status == 0 ? 0 : 1);
+        }
+
+        close(fds[1]);
+        if (pid < 0) {
+            perror("fork");
+            close(fds[0]);
+            continue;
+        }
+        pids[i] = pid;
+        pipes[i] = fds[0];
+    }
+
+    // relay each branch report in order while later branches keep running
+    int failed = 0;
+    char buffer[4096];
+    for (int i = 0; i < count; i++) {
+        if (pipes[i] < 0) {
+            failed++;
+            continue;
+        }
+
+        ssize_t n;
+        while ((n = read(pipes[i], buffer, sizeof(buffer))) > 0) {
+            fwrite(buffer, 1, n, stdout);
+        }
+        close(pipes[i]);
+        fflush(stdout);
+
+        int status = 0;
+        waitpid(pids[i], &status, 0);
+        if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            fprintf(stderr, "BRANCH %d: simulation failed\n", i + 1);
+            failed++;
+        }
+    }
+
+    free(pipes);
+    free(pids);
+    return failed;
+}
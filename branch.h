@@ -0,0 +1,29 @@
+/*
+ * branch.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for what-if branching: the simulation
+ * runs once up to a branch time and then continues under several scheduler
+ * configurations, each in its own forked copy of the engine.
+ */
+
+ #ifndef BRANCH_H
+ #define BRANCH_H
+
+ #include "Simulation.h"
+
+ // Struct for one branch configuration
+ typedef struct Branch {
+     int quantumA;      // quantum for the highest level after the branch point
+     int quantumB;      // quantum for the lowest level after the branch point
+     int preemption;    // flag for preemption after the branch point
+ } Branch;
+
+ // function prototypes
+ int parseBranch(const char *spec, Branch *b);
+ int runToTime(Simulation *sim, Ticks time);
+ int simulateBranches(Simulation *sim, Ticks branchTime, Branch *branches, int count);
+
+ #endif
@@ -0,0 +1,386 @@
+/*
+ * cache.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the result cache. An entry is
+ * the file <dir>/<key>.<kind>, where the key hashes the engine version,
+ * the kind of result, the settings and every byte of the trace, so an
+ * edited trace or a changed engine simply misses. Entries are written to
+ * a temporary file and renamed into place, so concurrent runs never read
+ * half an entry. A hit touches the entry, and once the entries outgrow
+ * the limit the least recently used are deleted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+
+#define CACHE_BLOCK 65536 // bytes of trace hashed at a time
+
+// Struct for the running hash of a key
+typedef struct KeyHash {
+    unsigned long long a;      // first lane
+    unsigned long long b;      // second lane, seeded differently
+} KeyHash;
+
+// Struct for one entry found while trimming the cache
+typedef struct CacheEntry {
+    char *name;                // file name within the cache directory
+    struct timespec used;      // last write or hit
+    long long size;            // bytes on disk
+} CacheEntry;
+
+/*
+ * Function: rotate
+ *
+ * Rotates a 64 bit word left by n bits
+ */
+static unsigned long long rotate(unsigned long long x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+/*
+ * Function: finish
+ *
+ * Mixes every bit of a lane into every bit of the result
+ */
+static unsigned long long finish(unsigned long long x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/*
+ * Function: hashWord
+ *
+ * Adds one 64 bit word to both lanes of the hash
+ */
+static void hashWord(KeyHash *h, unsigned long long w) {
+    h->a = rotate(h->a ^ (w * 0x9e3779b97f4a7c15ULL), 31) * 0x87c37b91114253d5ULL;
+    h->b = rotate(h->b + (w * 0xc2b2ae3d27d4eb4fULL), 29) * 0x4cf5ad432745937fULL + 0x52dce729;
+}
+
+/*
+ * Function: hashBlock
+ *
+ * Adds a block of bytes to the hash a word at a time. The last, partial
+ * word carries the block length, so splitting the same bytes into other
+ * blocks gives another hash.
+ */
+static void hashBlock(KeyHash *h, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    size_t left = size;
+    unsigned long long w;
+    while (left >= 8) {
+        memcpy(&w, p, 8);
+        hashWord(h, w);
+        p += 8;
+        left -= 8;
+    }
+    w = 0;
+    memcpy(&w, p, left);
+    hashWord(h, w ^ ((unsigned long long)size << 8));
+}
+
+/*
+ * Function: resultKey
+ *
+ * Computes the key of a result of the given kind for the trace at path
+ * under the given engine settings. Returns 0 on success, -1 if the trace
+ * could not be read.
+ */
+int resultKey(char *key, const char *path, const char *kind, const Level *levels, int numLevels, int preemption, int aging, long limit) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    unsigned char *block = (unsigned char *)malloc(CACHE_BLOCK);
+    if (block == NULL) {
+        fclose(file);
+        return -1;
+    }
+
+    // the settings go in as text, so the key does not depend on struct layout
+    char settings[64 + MAX_LEVELS * 40];
+    int length = snprintf(settings, sizeof(settings), "mlfq %d %s preemption=%d aging=%d limit=%ld levels=",
+                          ENGINE_VERSION, kind, preemption, aging, limit);
+    for (int i = 0; i < numLevels; i++) {
+        length += snprintf(settings + length, sizeof(settings) - length, "%d:%d:%d,",
+                           levels[i].quantum, levels[i].promote, levels[i].demote);
+    }
+
+    KeyHash h = { 0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL };
+    hashBlock(&h, settings, length);
+    size_t n;
+    while ((n = fread(block, 1, CACHE_BLOCK, file)) > 0) {
+        hashBlock(&h, block, n);
+    }
+    int failed = ferror(file);
+    fclose(file);
+    free(block);
+    if (failed) {
+        return -1;
+    }
+
+    snprintf(key, CACHE_KEY, "%016llx%016llx", finish(h.a ^ rotate(h.b, 17)), finish(h.b + h.a));
+    return 0;
+}
+
+/*
+ * Function: openResultCache
+ *
+ * Opens the cache in dir, creating the directory if needed, keeping at
+ * most limit bytes of entries. Returns 0 on success, -1 on failure.
+ */
+int openResultCache(ResultCache *cache, const char *dir, long long limit) {
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return -1;
+    }
+    cache->dir = dir;
+    cache->limit = limit > 0 ? limit : CACHE_LIMIT;
+    cache->used = -1;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+/*
+ * Function: closeResultCache
+ *
+ * Releases a cache opened with openResultCache; the entries stay on disk
+ */
+void closeResultCache(ResultCache *cache) {
+    pthread_mutex_destroy(&cache->lock);
+}
+
+/*
+ * Function: entryPath
+ *
+ * Writes the path of an entry to path
+ */
+static void entryPath(char *path, size_t size, const ResultCache *cache, const char *key, const char *kind) {
+    snprintf(path, size, "%s/%s.%s", cache->dir, key, kind);
+}
+
+/*
+ * Function: loadResult
+ *
+ * Reads the entry for key into a new buffer, terminated by a zero byte
+ * that size does not count, and marks it as recently used. Returns 0 on
+ * a hit, -1 on a miss.
+ */
+int loadResult(ResultCache *cache, const char *key, const char *kind, char **data, size_t *size) {
+    char path[4096];
+    entryPath(path, sizeof(path), cache, key, kind);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    struct stat st;
+    char *buffer = NULL;
+    if (fstat(fileno(file), &st) == 0 && (buffer = (char *)malloc(st.st_size + 1)) != NULL &&
+        fread(buffer, 1, st.st_size, file) != (size_t)st.st_size) {
+        free(buffer);
+        buffer = NULL;
+    }
+    fclose(file);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    buffer[st.st_size] = '\0';
+    utime(path, NULL);
+    *data = buffer;
+    *size = st.st_size;
+    return 0;
+}
+
+/*
+ * Function: compareEntries
+ *
+ * Orders cache entries from least to most recently used
+ */
+static int compareEntries(const void *x, const void *y) {
+    const CacheEntry *a = (const CacheEntry *)x;
+    const CacheEntry *b = (const CacheEntry *)y;
+    if (a->used.tv_sec != b->used.tv_sec) {
+        return a->used.tv_sec < b->used.tv_sec ? -1 : 1;
+    }
+    return (a->used.tv_nsec > b->used.tv_nsec) - (a->used.tv_nsec < b->used.tv_nsec);
+}
+
+/*
+ * Function: trimCache
+ *
+ * Totals the entries in the cache directory and deletes the least
+ * recently used until at most target bytes are left. Called with the
+ * cache locked.
+ */
+static void trimCache(ResultCache *cache, long long target) {
+    DIR *dir = opendir(cache->dir);
+    if (dir == NULL) {
+        return;
+    }
+
+    CacheEntry *entries = NULL;
+    int count = 0, capacity = 0;
+    long long total = 0;
+    char path[4096];
+    struct dirent *d;
+    while ((d = readdir(dir)) != NULL) {
+        // temporary files start with a dot and belong to a writer
+        if (d->d_name[0] == '.') {
+            continue;
+        }
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", cache->dir, d->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 256;
+            CacheEntry *grown = (CacheEntry *)realloc(entries, capacity * sizeof(CacheEntry));
+            if (grown == NULL) {
+                break;
+            }
+            entries = grown;
+        }
+        entries[count].name = strdup(d->d_name);
+        if (entries[count].name == NULL) {
+            break;
+        }
+        entries[count].used = st.st_mtim;
+        entries[count].size = st.st_size;
+        total += st.st_size;
+        count++;
+    }
+    closedir(dir);
+
+    if (total > target) {
+        qsort(entries, count, sizeof(CacheEntry), compareEntries);
+        for (int i = 0; i < count && total > target; i++) {
+            snprintf(path, sizeof(path), "%s/%s", cache->dir, entries[i].name);
+            if (unlink(path) == 0 || errno == ENOENT) {
+                total -= entries[i].size;
+            }
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        free(entries[i].name);
+    }
+    free(entries);
+    cache->used = total;
+}
+
+/*
+ * Function: storeResult
+ *
+ * Stores data as the entry for key, then evicts the least recently used
+ * entries if the cache has outgrown its limit, down to three quarters of
+ * it so that the directory is not scanned on every store. Returns 0 on
+ * success, -1 if the entry could not be written.
+ */
+int storeResult(ResultCache *cache, const char *key, const char *kind, const char *data, size_t size) {
+    char path[4096], temp[4096];
+    entryPath(path, sizeof(path), cache, key, kind);
+    snprintf(temp, sizeof(temp), "%s/.%s.%s.XXXXXX", cache->dir, key, kind);
+    int fd = mkstemp(temp);
+    if (fd < 0) {
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, data + written, size - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    fchmod(fd, 0644);
+    if (close(fd) != 0 || written < size || rename(temp, path) != 0) {
+        unlink(temp);
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->used < 0) {
+        trimCache(cache, cache->limit);
+    } else {
+        cache->used += size;
+        if (cache->used > cache->limit) {
+            trimCache(cache, cache->limit / 4 * 3);
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+/*
+ * Function: beginCapture
+ *
+ * Diverts standard output to a temporary file until endCapture. Returns
+ * 0 on success, -1 if standard output is left as it was.
+ */
+int beginCapture(OutputCapture *capture) {
+    fflush(stdout);
+    capture->file = tmpfile();
+    if (capture->file == NULL) {
+        return -1;
+    }
+    capture->saved = dup(STDOUT_FILENO);
+    if (capture->saved < 0 || dup2(fileno(capture->file), STDOUT_FILENO) < 0) {
+        if (capture->saved >= 0) {
+            close(capture->saved);
+        }
+        fclose(capture->file);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: endCapture
+ *
+ * Restores standard output, writes everything captured to it and hands
+ * the captured bytes back in a new buffer. Returns 0 on success, -1 if
+ * the captured bytes could not be read back.
+ */
+int endCapture(OutputCapture *capture, char **data, size_t *size) {
+    fflush(stdout);
+    dup2(capture->saved, STDOUT_FILENO);
+    close(capture->saved);
+
+    long length = ftell(capture->file);
+    char *buffer = length >= 0 ? (char *)malloc(length + 1) : NULL;
+    rewind(capture->file);
+    if (buffer != NULL && fread(buffer, 1, length, capture->file) != (size_t)length) {
+        free(buffer);
+        buffer = NULL;
+    }
+    fclose(capture->file);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    buffer[length] = '\0';
+    fwrite(buffer, 1, length, stdout);
+    fflush(stdout);
+    *data = buffer;
+    *size = length;
+    return 0;
+}
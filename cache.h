@@ -0,0 +1,49 @@
+/*
+ * cache.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for the result cache: an optional
+ * directory of finished results keyed by a hash of the trace contents,
+ * the engine settings and the engine version, so a repeated run returns
+ * its stored result without parsing or simulating.
+ */
+
+ #ifndef CACHE_H
+ #define CACHE_H
+
+ #include <stddef.h>
+ #include <pthread.h>
+ #include "Simulation.h"
+
+ #ifndef CACHE_LIMIT
+ #define CACHE_LIMIT (256LL << 20) // default bytes of stored results
+ #endif
+
+ #define CACHE_KEY 33 // 32 hex digits and the terminator
+
+ // Struct for an open result cache
+ typedef struct ResultCache {
+     const char *dir;           // directory holding the entries
+     long long limit;           // bytes the entries may use before the oldest are evicted
+     long long used;            // bytes in use, -1 until the directory is first scanned
+     pthread_mutex_t lock;      // guards used between batch workers
+ } ResultCache;
+
+ // Struct for standard output diverted to a file while it is captured
+ typedef struct OutputCapture {
+     int saved;                 // duplicate of the original standard output
+     FILE *file;                // temporary file standard output is written to
+ } OutputCapture;
+
+ // function prototypes
+ int openResultCache(ResultCache *cache, const char *dir, long long limit);
+ void closeResultCache(ResultCache *cache);
+ int resultKey(char *key, const char *path, const char *kind, const Level *levels, int numLevels, int preemption, int aging, long limit);
+ int loadResult(ResultCache *cache, const char *key, const char *kind, char **data, size_t *size);
+ int storeResult(ResultCache *cache, const char *key, const char *kind, const char *data, size_t size);
+ int beginCapture(OutputCapture *capture);
+ int endCapture(OutputCapture *capture, char **data, size_t *size);
+
+ #endif
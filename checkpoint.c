@@ -0,0 +1,654 @@
+/*
+ * checkpoint.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of simulation snapshots. A snapshot
+ * holds every process and task reachable from the engine queues (plus the
+ * task on the CPU), the statistics and the scheduler loop state, encoded as
+ * variable-length integers. Periodic snapshots are written by a forked
+ * child, which sees a copy-on-write image of the engine, so the main loop
+ * only pays for the fork.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "checkpoint.h"
+
+#define SNAPSHOT_MAGIC "MLFQSNP7"
+
+/************************************************************
+ * Pointer Table
+ ************************************************************/
+
+// Struct for mapping object pointers to snapshot indices
+typedef struct PtrTable {
+    void **items;      // objects in index order
+    int count;         // number of objects
+    int capacity;      // capacity of items
+    void **keys;       // open-addressed hash of objects
+    int *slots;        // index of each hashed object
+    int buckets;       // number of hash buckets (power of two)
+} PtrTable;
+
+/*
+ * Function: hashPtr
+ *
+ * Hashes a pointer into a bucket index
+ */
+static unsigned hashPtr(void *ptr, int buckets) {
+    uintptr_t h = (uintptr_t)ptr;
+    h ^= h >> 17;
+    h *= 0x9E3779B1u;
+    return (unsigned)(h ^ (h >> 15)) & (buckets - 1);
+}
+
+/*
+ * Function: tableInit
+ *
+ * Initializes an empty pointer table
+ */
+static void tableInit(PtrTable *tb) {
+    tb->count = 0;
+    tb->capacity = 64;
+    tb->buckets = 128;
+    tb->items = (void **)malloc(tb->capacity * sizeof(void *));
+    tb->keys = (void **)calloc(tb->buckets, sizeof(void *));
+    tb->slots = (int *)malloc(tb->buckets * sizeof(int));
+    if (!tb->items || !tb->keys || !tb->slots) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Function: tableFind
+ *
+ * Returns the index of an object, or -1 if it is not in the table
+ */
+static int tableFind(PtrTable *tb, void *ptr) {
+    if (ptr == NULL) return -1;
+    for (unsigned b = hashPtr(ptr, tb->buckets); tb->keys[b] != NULL; b = (b + 1) & (tb->buckets - 1)) {
+        if (tb->keys[b] == ptr) return tb->slots[b];
+    }
+    return -1;
+}
+
+/*
+ * Function: tableAdd
+ *
+ * Adds an object to the table if it is not already present
+ */
+static void tableAdd(PtrTable *tb, void *ptr) {
+    if (ptr == NULL || tableFind(tb, ptr) >= 0) return;
+
+    // grow the hash before it passes half full
+    if (2 * (tb->count + 1) > tb->buckets) {
+        void **oldKeys = tb->keys;
+        int *oldSlots = tb->slots;
+        int oldBuckets = tb->buckets;
+        tb->buckets *= 2;
+        tb->keys = (void **)calloc(tb->buckets, sizeof(void *));
+        tb->slots = (int *)malloc(tb->buckets * sizeof(int));
+        if (!tb->keys || !tb->slots) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < oldBuckets; i++) {
+            if (oldKeys[i] == NULL) continue;
+            unsigned b = hashPtr(oldKeys[i], tb->buckets);
+            while (tb->keys[b] != NULL) b = (b + 1) & (tb->buckets - 1);
+            tb->keys[b] = oldKeys[i];
+            tb->slots[b] = oldSlots[i];
+        }
+        free(oldKeys);
+        free(oldSlots);
+    }
+
+    if (tb->count == tb->capacity) {
+        tb->capacity *= 2;
+        tb->items = (void **)realloc(tb->items, tb->capacity * sizeof(void *));
+        if (!tb->items) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    unsigned b = hashPtr(ptr, tb->buckets);
+    while (tb->keys[b] != NULL) b = (b + 1) & (tb->buckets - 1);
+    tb->keys[b] = ptr;
+    tb->slots[b] = tb->count;
+    tb->items[tb->count++] = ptr;
+}
+
+/*
+ * Function: tableFree
+ *
+ * Frees the memory held by a pointer table
+ */
+static void tableFree(PtrTable *tb) {
+    free(tb->items);
+    free(tb->keys);
+    free(tb->slots);
+}
+
+/************************************************************
+ * Encoding
+ ************************************************************/
+
+/*
+ * Function: putInt
+ *
+ * Writes a signed integer as a zigzag variable-length integer
+ */
+static void putInt(FILE *f, Ticks value) {
+    unsigned long long v = ((unsigned long long)value << 1) ^ (unsigned long long)(value >> (8 * sizeof(Ticks) - 1));
+    while (v >= 0x80) {
+        fputc((int)(v & 0x7F) | 0x80, f);
+        v >>= 7;
+    }
+    fputc((int)v, f);
+}
+
+/*
+ * Function: getInt
+ *
+ * Reads a zigzag variable-length integer, setting *ok to 0 on EOF
+ */
+static Ticks getInt(FILE *f, int *ok) {
+    unsigned long long v = 0;
+    int shift = 0;
+    int c;
+    do {
+        if ((c = fgetc(f)) == EOF || shift >= 64) {
+            *ok = 0;
+            return 0;
+        }
+        v |= (unsigned long long)(c & 0x7F) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return (Ticks)(v >> 1) ^ -(Ticks)(v & 1);
+}
+
+/*
+ * Function: putProcessQueue
+ *
+ * Writes a process queue as a count followed by process indices
+ */
+static void putProcessQueue(FILE *f, pQueue *q, PtrTable *procs) {
+    putInt(f, q->size);
+    for (pNode *n = q->head; n != NULL; n = n->next) {
+        putInt(f, tableFind(procs, n->process));
+    }
+}
+
+/*
+ * Function: putTaskQueue
+ *
+ * Writes a task queue as a count followed by task indices
+ */
+static void putTaskQueue(FILE *f, tQueue *q, PtrTable *tasks) {
+    int count = 0;
+    for (tNode *n = q->head; n != NULL; n = n->next) count++;
+    putInt(f, count);
+    for (tNode *n = q->head; n != NULL; n = n->next) {
+        putInt(f, tableFind(tasks, n->task));
+    }
+}
+
+/*
+ * Function: getProcessQueue
+ *
+ * Reads a process queue written by putProcessQueue
+ */
+static int getProcessQueue(FILE *f, pQueue *q, Process **procs, long numProcs) {
+    int ok = 1;
+    long count = getInt(f, &ok);
+    for (long i = 0; ok && i < count; i++) {
+        long idx = getInt(f, &ok);
+        if (!ok || idx < 0 || idx >= numProcs) return 0;
+        if (enqueueProcess(q, procs[idx]) != 0) return 0;
+    }
+    return ok;
+}
+
+/*
+ * Function: getTaskQueue
+ *
+ * Reads a task queue written by putTaskQueue
+ */
+static int getTaskQueue(FILE *f, tQueue *q, Task **tasks, long numTasks) {
+    int ok = 1;
+    long count = getInt(f, &ok);
+    for (long i = 0; ok && i < count; i++) {
+        long idx = getInt(f, &ok);
+        if (!ok || idx < 0 || idx >= numTasks) return 0;
+        if (enqueueTask(q, tasks[idx]) != 0) return 0;
+    }
+    return ok;
+}
+
+/*
+ * Function: collectTasks
+ *
+ * Adds every task in a task queue (and its parent) to the tables
+ */
+static void collectTasks(tQueue *q, PtrTable *procs, PtrTable *tasks) {
+    for (tNode *n = q->head; n != NULL; n = n->next) {
+        tableAdd(tasks, n->task);
+        tableAdd(procs, n->task->parent);
+    }
+}
+
+/************************************************************
+ * Snapshot Functions
+ ************************************************************/
+
+/*
+ * Function: createCheckpoint
+ *
+ * Creates the settings for periodic snapshots to path
+ */
+Checkpoint *createCheckpoint(char *path, Ticks interval) {
+    Checkpoint *cp = (Checkpoint *)malloc(sizeof(Checkpoint));
+    if (!cp) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    cp->path = path;                                        // snapshot file
+    cp->interval = interval > 0 ? interval : CHECKPOINT_INTERVAL; // ticks between snapshots
+    cp->next = cp->interval;                                // time of next snapshot
+    cp->writer = 0;                                         // no writer running
+
+    return cp;
+}
+
+/*
+ * Function: saveCheckpoint
+ *
+ * Writes a snapshot of the engine state to path. The snapshot is written
+ * to a temporary file and renamed so a crash never leaves a torn file.
+ * Returns 0 on success, -1 on failure.
+ */
+int saveCheckpoint(Simulation *sim, const char *path) {
+    PtrTable procs, tasks, programs;
+    tableInit(&procs);
+    tableInit(&tasks);
+    tableInit(&programs);
+
+    // number every process and task reachable from the engine, lowest level first
+    for (int i = sim->levels - 1; i >= 0; i--) {
+        for (pNode *n = sim->level[i].queue->head; n != NULL; n = n->next) {
+            tableAdd(&procs, n->process);
+        }
+    }
+    for (pNode *n = sim->exitQueue->head; n != NULL; n = n->next) {
+        tableAdd(&procs, n->process);
+    }
+    for (int i = 0; i < sim->levels; i++) {
+        collectTasks(sim->level[i].ready, &procs, &tasks);
+    }
+    collectTasks(sim->ioQueue, &procs, &tasks);
+    // a task left over from an idle CPU may already have been freed
+    Task *running = sim->CPU ? sim->task : NULL;
+    if (running != NULL) {
+        tableAdd(&tasks, running);
+        tableAdd(&procs, running->parent);
+    }
+    for (int i = 0; i < procs.count; i++) {
+        collectTasks(((Process *)procs.items[i])->tasks, &procs, &tasks);
+    }
+    for (int i = 0; i < procs.count; i++) {
+        tableAdd(&programs, ((Process *)procs.items[i])->program);
+    }
+
+    size_t len = strlen(path);
+    char *tmp = (char *)malloc(len + 5);
+    if (!tmp) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        perror(tmp);
+        free(tmp);
+        tableFree(&procs);
+        tableFree(&tasks);
+        tableFree(&programs);
+        return -1;
+    }
+
+    // header, parameters and scheduler loop state
+    Stats *s = sim->stats;
+    fwrite(SNAPSHOT_MAGIC, 1, 8, f);
+    putInt(f, sim->levels);
+    for (int i = 0; i < sim->levels; i++) {
+        putInt(f, sim->level[i].quantum);
+        putInt(f, sim->level[i].promote);
+        putInt(f, sim->level[i].demote);
+    }
+    putInt(f, sim->preemption);
+    putInt(f, sim->aging);
+    putInt(f, sim->CPU);
+    putInt(f, sim->loop);
+    putInt(f, s->instructions);
+    putInt(f, s->startTime);
+    putInt(f, s->runtime);
+    putInt(f, s->maxWait);
+    putInt(f, s->minWait);
+    putInt(f, s->totalWait);
+
+    // shared programs, written once however many processes run them
+    putInt(f, programs.count);
+    for (int i = 0; i < programs.count; i++) {
+        Program *prog = (Program *)programs.items[i];
+        putInt(f, prog->count);
+        for (int j = 0; j < prog->count; j++) {
+            putInt(f, prog->instructions[j].type);
+            putInt(f, programTime(prog, j));
+        }
+    }
+
+    // process table
+    putInt(f, procs.count);
+    putInt(f, tasks.count);
+    for (int i = 0; i < procs.count; i++) {
+        Process *p = (Process *)procs.items[i];
+        putInt(f, p->pid);
+        putInt(f, p->priority);
+        putInt(f, p->arrival);
+        putInt(f, p->runtime);
+        putInt(f, p->numTasks);
+        putInt(f, p->currentTask);
+        putInt(f, p->completions);
+        putInt(f, p->interrupts);
+        putInt(f, p->ready);
+        putInt(f, p->taskRunning);
+        putInt(f, p->quantum);
+        putInt(f, p->bursts);
+        putInt(f, p->endQueue[0]);
+        putTaskQueue(f, p->tasks, &tasks);
+        putInt(f, tableFind(&programs, p->program));
+        putInt(f, p->programNext);
+        putInt(f, p->deadline);
+    }
+
+    // task table
+    for (int i = 0; i < tasks.count; i++) {
+        Task *t = (Task *)tasks.items[i];
+        putInt(f, t->type);
+        putInt(f, t->time);
+        putInt(f, t->completed);
+        putInt(f, t->interrupts);
+        putInt(f, t->readySince);
+        putInt(f, tableFind(&procs, t->parent));
+    }
+
+    // queues and the task on the CPU
+    for (int i = 0; i < sim->levels; i++) {
+        putProcessQueue(f, sim->level[i].queue, &procs);
+        putTaskQueue(f, sim->level[i].ready, &tasks);
+    }
+    putProcessQueue(f, sim->exitQueue, &procs);
+    putTaskQueue(f, sim->ioQueue, &tasks);
+    putInt(f, tableFind(&tasks, running));
+
+    int rc = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) != 0) {
+        perror(path);
+        rc = -1;
+    }
+
+    free(tmp);
+    tableFree(&procs);
+    tableFree(&tasks);
+    tableFree(&programs);
+    return rc;
+}
+
+/*
+ * Function: loadCheckpoint
+ *
+ * Rebuilds the engine state from a snapshot written by saveCheckpoint.
+ * Returns 0 on success, -1 on failure.
+ */
+int loadCheckpoint(Simulation *sim, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char magic[8];
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, SNAPSHOT_MAGIC, 8) != 0) {
+        fprintf(stderr, "%s: not a simulation snapshot\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    int ok = 1;
+    Level levels[MAX_LEVELS];
+    int numLevels = getInt(f, &ok);
+    if (!ok || numLevels < 1 || numLevels > MAX_LEVELS) {
+        fprintf(stderr, "%s: truncated snapshot\n", path);
+        fclose(f);
+        return -1;
+    }
+    for (int i = 0; i < numLevels; i++) {
+        levels[i].quantum = getInt(f, &ok);
+        levels[i].promote = getInt(f, &ok);
+        levels[i].demote = getInt(f, &ok);
+    }
+    int preemption = getInt(f, &ok);
+    int aging = getInt(f, &ok);
+
+    if (initializeSimulation(sim, levels, numLevels, preemption, createProcessQueue()) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        fclose(f);
+        return -1;
+    }
+    setAging(sim, aging);
+    sim->CPU = getInt(f, &ok);
+    sim->loop = getInt(f, &ok);
+
+    Stats *s = sim->stats;
+    s->instructions = getInt(f, &ok);
+    s->startTime = getInt(f, &ok);
+    s->runtime = getInt(f, &ok);
+    s->maxWait = getInt(f, &ok);
+    s->minWait = getInt(f, &ok);
+    s->totalWait = getInt(f, &ok);
+
+    long numPrograms = getInt(f, &ok);
+    if (!ok || numPrograms < 0) {
+        fprintf(stderr, "%s: truncated snapshot\n", path);
+        fclose(f);
+        return -1;
+    }
+    Program **programs = (Program **)malloc((numPrograms + 1) * sizeof(Program *));
+    if (!programs) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < numPrograms; i++) {
+        long count = getInt(f, &ok);
+        if (!ok || count < 0 || (programs[i] = createProgram(count)) == NULL) {
+            fprintf(stderr, ok && count >= 0 ? "Memory allocation failed\n" : "%s: truncated snapshot\n", path);
+            exit(EXIT_FAILURE);
+        }
+        for (long j = 0; j < count; j++) {
+            programs[i]->instructions[j].type = getInt(f, &ok);
+            if (setProgramTime(programs[i], j, getInt(f, &ok)) != 0) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    long numProcs = getInt(f, &ok);
+    long numTasks = getInt(f, &ok);
+    if (!ok || numProcs < 0 || numTasks < 0) {
+        fprintf(stderr, "%s: truncated snapshot\n", path);
+        fclose(f);
+        free(programs);
+        return -1;
+    }
+
+    // allocate every object first so indices can be resolved in any order
+    Process **procs = (Process **)malloc((numProcs + 1) * sizeof(Process *));
+    Task **tasks = (Task **)malloc((numTasks + 1) * sizeof(Task *));
+    if (!procs || !tasks) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < numProcs; i++) {
+        if ((procs[i] = createProcess()) == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        adoptProcess(sim, procs[i]);
+    }
+    for (long i = 0; i < numTasks; i++) {
+        if ((tasks[i] = createTask()) == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (long i = 0; ok && i < numProcs; i++) {
+        Process *p = procs[i];
+        p->pid = getInt(f, &ok);
+        p->priority = getInt(f, &ok);
+        p->arrival = getInt(f, &ok);
+        p->runtime = getInt(f, &ok);
+        p->numTasks = getInt(f, &ok);
+        p->currentTask = getInt(f, &ok);
+        p->completions = getInt(f, &ok);
+        p->interrupts = getInt(f, &ok);
+        p->ready = getInt(f, &ok);
+        p->taskRunning = getInt(f, &ok);
+        p->quantum = getInt(f, &ok);
+        p->bursts = getInt(f, &ok);
+        p->endQueue = (char *)levelName(getInt(f, &ok) - 'A');
+        ok = ok && getTaskQueue(f, p->tasks, tasks, numTasks);
+        long program = getInt(f, &ok);
+        if (program >= 0 && program < numPrograms) {
+            attachProgram(p, programs[program]);
+        }
+        p->programNext = getInt(f, &ok);
+        if (p->programNext < 0 || p->programNext > (p->program ? p->program->count : 0)) {
+            ok = 0;
+        }
+        p->deadline = getInt(f, &ok);
+    }
+
+    for (long i = 0; ok && i < numTasks; i++) {
+        Task *t = tasks[i];
+        t->type = getInt(f, &ok);
+        t->time = getInt(f, &ok);
+        t->completed = getInt(f, &ok);
+        t->interrupts = getInt(f, &ok);
+        t->readySince = getInt(f, &ok);
+        long parent = getInt(f, &ok);
+        t->parent = (parent >= 0 && parent < numProcs) ? procs[parent] : NULL;
+    }
+
+    for (int i = 0; i < sim->levels; i++) {
+        ok = ok && getProcessQueue(f, sim->level[i].queue, procs, numProcs);
+        ok = ok && getTaskQueue(f, sim->level[i].ready, tasks, numTasks);
+    }
+    ok = ok && getProcessQueue(f, sim->exitQueue, procs, numProcs);
+    ok = ok && getTaskQueue(f, sim->ioQueue, tasks, numTasks);
+    refreshLevels(sim);
+    long running = getInt(f, &ok);
+    sim->task = (running >= 0 && running < numTasks) ? tasks[running] : NULL;
+
+    // the processes now hold the programs
+    for (long i = 0; i < numPrograms; i++) {
+        releaseProgram(programs[i]);
+    }
+    fclose(f);
+    free(procs);
+    free(tasks);
+    free(programs);
+
+    if (!ok) {
+        fprintf(stderr, "%s: truncated snapshot\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: checkpointWait
+ *
+ * Waits for the snapshot writer (if any) and reports a failed write
+ */
+void checkpointWait(Checkpoint *cp) {
+    if (cp->writer <= 0) return;
+
+    int status = 0;
+    if (waitpid(cp->writer, &status, 0) == cp->writer && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+        fprintf(stderr, "CHECKPOINT: failed to write %s\n", cp->path);
+    }
+    cp->writer = 0;
+}
+
+/*
+ * Function: checkpointAsync
+ *
+ * Forks a child to write a snapshot of the current state. If the previous
+ * snapshot is still being written this one is skipped rather than stalling
+ * the simulation.
+ */
+void checkpointAsync(Checkpoint *cp, Simulation *sim) {
+    cp->next = sim->stats->runtime + cp->interval;
+
+    if (cp->writer > 0) {
+        int status = 0;
+        pid_t done = waitpid(cp->writer, &status, WNOHANG);
+        if (done == 0) {
+            return; // previous writer still busy
+        }
+        if (done == cp->writer && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            fprintf(stderr, "CHECKPOINT: failed to write %s\n", cp->path);
+        }
+        cp->writer = 0;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // child: write the copy-on-write image and exit without flushing stdio
+        _exit(saveCheckpoint(sim, cp->path) == 0 ? 0 : 1);
+    } else if (pid < 0) {
+        // no child available, write synchronously
+        if (saveCheckpoint(sim, cp->path) != 0) {
+            fprintf(stderr, "CHECKPOINT: failed to write %s\n", cp->path);
+        }
+    } else {
+        cp->writer = pid;
+    }
+}
+
+/*
+ * Function: freeCheckpoint
+ *
+ * Waits for any pending snapshot and frees the settings
+ */
+void freeCheckpoint(Checkpoint *cp) {
+    if (!cp) return;
+
+    checkpointWait(cp);
+    free(cp);
+}
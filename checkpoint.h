@@ -0,0 +1,37 @@
+/*
+ * checkpoint.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for saving and restoring snapshots of
+ * the complete simulation state.
+ */
+
+ #ifndef CHECKPOINT_H
+ #define CHECKPOINT_H
+
+ #include <sys/types.h>
+ #include "Simulation.h"
+
+ #ifndef CHECKPOINT_INTERVAL
+ #define CHECKPOINT_INTERVAL 1000000
+ #endif
+
+ // Struct for periodic checkpoint settings
+ typedef struct Checkpoint {
+     char *path;        // snapshot file
+     Ticks interval;    // simulated ticks between snapshots
+     Ticks next;        // simulated time of the next snapshot
+     pid_t writer;      // child process writing a snapshot, 0 if none
+ } Checkpoint;
+
+ // function prototypes
+ Checkpoint *createCheckpoint(char *path, Ticks interval);
+ int saveCheckpoint(Simulation *sim, const char *path);
+ int loadCheckpoint(Simulation *sim, const char *path);
+ void checkpointAsync(Checkpoint *cp, Simulation *sim);
+ void checkpointWait(Checkpoint *cp);
+ void freeCheckpoint(Checkpoint *cp);
+
+ #endif
@@ -0,0 +1,379 @@
+/*
+ * deadline.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of process deadlines. For
+ * earliest-deadline-first ordering the engine keeps every process with a
+ * deadline that has not completed in a min-heap on its absolute deadline,
+ * and the ready tasks with a deadline of every level in a min-heap of the
+ * level, kept up to date as the level's ready queue changes. A ready task
+ * is taken from the top of its level's heap. Otherwise a pick searches the
+ * process heap from the top for a process that can run at the serviced
+ * level, never going below a process that can or one due no sooner than
+ * the best found, so it only visits the processes due before the one
+ * chosen that are waiting on I/O, running or at another level.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "deadline.h"
+
+/*
+ * Function: dueTime
+ *
+ * Returns the time by which a process should complete, or LLONG_MAX if it
+ * has no deadline
+ */
+Ticks dueTime(const Process *p) {
+    return p->deadline > 0 ? p->arrival + p->deadline : LLONG_MAX;
+}
+
+/*
+ * Function: dueBefore
+ *
+ * Returns 1 if process a is due before process b, ties going to the lower
+ * pid
+ */
+static inline int dueBefore(const Process *a, const Process *b) {
+    Ticks x = dueTime(a), y = dueTime(b);
+    return x < y || (x == y && a->pid < b->pid);
+}
+
+/*
+ * Function: placeDeadline
+ *
+ * Puts process p in slot i of the heap and records the slot
+ */
+static inline void placeDeadline(DeadlineHeap *h, int i, Process *p) {
+    h->items[i] = p;
+    p->deadlineSlot = i;
+}
+
+/*
+ * Function: siftDeadline
+ *
+ * Moves the process in slot i of the heap up or down to its place
+ */
+static void siftDeadline(DeadlineHeap *h, int i) {
+    Process *p = h->items[i];
+    while (i > 0 && dueBefore(p, h->items[(i - 1) / 2])) {
+        placeDeadline(h, i, h->items[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int first = 2 * i + 1;
+        if (first >= h->count) break;
+        if (first + 1 < h->count && dueBefore(h->items[first + 1], h->items[first])) {
+            first++;
+        }
+        if (!dueBefore(h->items[first], p)) break;
+        placeDeadline(h, i, h->items[first]);
+        i = first;
+    }
+    placeDeadline(h, i, p);
+}
+
+/*
+ * Function: createDeadlineHeap
+ *
+ * Creates an empty heap, or returns NULL if allocation fails
+ */
+DeadlineHeap *createDeadlineHeap() {
+    return (DeadlineHeap *)calloc(1, sizeof(DeadlineHeap));
+}
+
+/*
+ * Function: freeDeadlineHeap
+ *
+ * Frees a heap, but not the processes in it
+ */
+void freeDeadlineHeap(DeadlineHeap *h) {
+    if (h == NULL) return;
+
+    for (int i = 0; i < h->count; i++) {
+        h->items[i]->deadlineSlot = -1;
+    }
+    free(h->items);
+    free(h);
+}
+
+/*
+ * Function: pushDeadline
+ *
+ * Adds a process with a deadline to the heap. Returns 0 on success, -1 if
+ * the heap cannot grow.
+ */
+int pushDeadline(DeadlineHeap *h, Process *p) {
+    if (h->count == h->capacity) {
+        int capacity = h->capacity ? 2 * h->capacity : 64;
+        Process **items = (Process **)realloc(h->items, capacity * sizeof(Process *));
+        if (items == NULL) {
+            return -1;
+        }
+        h->items = items;
+        h->capacity = capacity;
+    }
+    placeDeadline(h, h->count++, p);
+    siftDeadline(h, h->count - 1);
+    return 0;
+}
+
+/*
+ * Function: removeDeadline
+ *
+ * Takes a process out of the heap, if it is in it
+ */
+void removeDeadline(DeadlineHeap *h, Process *p) {
+    int i = p->deadlineSlot;
+    if (i < 0 || i >= h->count || h->items[i] != p) {
+        return;
+    }
+    p->deadlineSlot = -1;
+    Process *last = h->items[--h->count];
+    if (i < h->count) {
+        placeDeadline(h, i, last);
+        siftDeadline(h, i);
+    }
+}
+
+/*
+ * Function: placeReady
+ *
+ * Puts task t in slot i of the heap and records the slot
+ */
+static inline void placeReady(ReadyDeadlines *h, int i, Task *t) {
+    h->items[i] = t;
+    t->deadlineSlot = i;
+}
+
+/*
+ * Function: siftReady
+ *
+ * Moves the task in slot i of the heap up or down to its place
+ */
+static void siftReady(ReadyDeadlines *h, int i) {
+    Task *t = h->items[i];
+    while (i > 0 && dueBefore(t->parent, h->items[(i - 1) / 2]->parent)) {
+        placeReady(h, i, h->items[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int first = 2 * i + 1;
+        if (first >= h->count) break;
+        if (first + 1 < h->count && dueBefore(h->items[first + 1]->parent, h->items[first]->parent)) {
+            first++;
+        }
+        if (!dueBefore(h->items[first]->parent, t->parent)) break;
+        placeReady(h, i, h->items[first]);
+        i = first;
+    }
+    placeReady(h, i, t);
+}
+
+/*
+ * Function: createReadyDeadlines
+ *
+ * Creates an empty heap of ready tasks, or returns NULL if allocation
+ * fails
+ */
+ReadyDeadlines *createReadyDeadlines() {
+    return (ReadyDeadlines *)calloc(1, sizeof(ReadyDeadlines));
+}
+
+/*
+ * Function: freeReadyDeadlines
+ *
+ * Frees a heap of ready tasks, but not the tasks in it
+ */
+void freeReadyDeadlines(ReadyDeadlines *h) {
+    if (h == NULL) return;
+
+    for (int i = 0; i < h->count; i++) {
+        h->items[i]->deadlineSlot = -1;
+    }
+    free(h->items);
+    free(h);
+}
+
+/*
+ * Function: reserveReadyDeadline
+ *
+ * Makes room in the heap for one more task, so that the push of a task
+ * being queued cannot fail. Returns 0 on success, -1 if the heap cannot
+ * grow.
+ */
+int reserveReadyDeadline(ReadyDeadlines *h) {
+    if (h->count < h->capacity) {
+        return 0;
+    }
+    int capacity = h->capacity ? 2 * h->capacity : 64;
+    Task **items = (Task **)realloc(h->items, capacity * sizeof(Task *));
+    if (items == NULL) {
+        return -1;
+    }
+    h->items = items;
+    h->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Function: pushReadyDeadline
+ *
+ * Adds a task just queued to the heap if its process has a deadline. Room
+ * must have been reserved.
+ */
+void pushReadyDeadline(ReadyDeadlines *h, Task *t) {
+    if (t->parent == NULL || t->parent->deadline <= 0) {
+        return;
+    }
+    placeReady(h, h->count++, t);
+    siftReady(h, h->count - 1);
+}
+
+/*
+ * Function: removeReadyDeadline
+ *
+ * Takes a task leaving its queue out of the heap, if it is in it
+ */
+void removeReadyDeadline(ReadyDeadlines *h, Task *t) {
+    int i = t->deadlineSlot;
+    if (i < 0 || i >= h->count || h->items[i] != t) {
+        return;
+    }
+    t->deadlineSlot = -1;
+    Task *last = h->items[--h->count];
+    if (i < h->count) {
+        placeReady(h, i, last);
+        siftReady(h, i);
+    }
+}
+
+/*
+ * Function: queuedIn
+ *
+ * Returns 1 if process p is in queue q
+ */
+static int queuedIn(const Process *p, const pQueue *q) {
+    for (pNode *n = p->nodes; n != NULL; n = n->sibling) {
+        if (n->queue == q) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: earliestRunnable
+ *
+ * Searches the part of the heap below slot i for a process of q that can
+ * run at runtime and is due before best, and returns the earliest found
+ * (or best). A process can run under the same conditions getNextTask
+ * applies.
+ */
+static Process *earliestRunnable(DeadlineHeap *h, int i, pQueue *q, Ticks runtime, Process *best) {
+    if (i >= h->count) {
+        return best;
+    }
+    Process *p = h->items[i];
+    if (best != NULL && !dueBefore(p, best)) {
+        return best;
+    }
+    if (p->arrival <= runtime && p->taskRunning == 0 && hasTask(p) && queuedIn(p, q)) {
+        return p;
+    }
+    best = earliestRunnable(h, 2 * i + 1, q, runtime, best);
+    return earliestRunnable(h, 2 * i + 2, q, runtime, best);
+}
+
+/*
+ * Function: getNextDeadlineTask
+ *
+ * Returns the next task to be executed at a level with processes q and
+ * ready tasks ready, earliest deadline first. As in getNextTask, a ready
+ * task resumes before a process starts a new one; the ready tasks with a
+ * deadline are kept in a heap of their own, so the one due soonest is at
+ * its top, ties going to the lower pid. Tasks and processes without a
+ * deadline run once none with one can, in queue order.
+ */
+Task *getNextDeadlineTask(DeadlineHeap *h, pQueue *q, tQueue *ready, Ticks runtime) {
+    if (!isEmptyT(ready)) {
+        ReadyDeadlines *due = ready->deadlines;
+        Task *t = due != NULL && due->count > 0 ? due->items[0] : peekTask(ready);
+        removeTask(ready, t);
+        t->parent->taskRunning = 1;
+        return t;
+    }
+
+    Process *p = earliestRunnable(h, 0, q, runtime, NULL);
+    if (p != NULL) {
+        Task *t = takeTask(p);
+        if (t != NULL) {
+            p->taskRunning = 1;
+            return t;
+        }
+    }
+    return getNextTask(q, ready, runtime);
+}
+
+/*
+ * Function: compareTicks
+ *
+ * qsort comparison of two times
+ */
+static int compareTicks(const void *a, const void *b) {
+    Ticks x = *(const Ticks *)a, y = *(const Ticks *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Function: printDeadlineStats
+ *
+ * Prints how many completed processes with a deadline missed it, and the
+ * distribution of their lateness (completion time minus deadline, so a
+ * process that finished early has a negative lateness). Percentiles are
+ * nearest rank. Prints nothing if no completed process has a deadline.
+ */
+void printDeadlineStats(pQueue *exitQueue) {
+    int count = 0;
+    for (pNode *n = exitQueue->head; n != NULL; n = n->next) {
+        count += n->process->deadline > 0;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    Ticks *lateness = (Ticks *)malloc(count * sizeof(Ticks));
+    if (lateness == NULL) {
+        return;
+    }
+    int n = 0, missed = 0;
+    Ticks total = 0, overrun = 0;
+    for (pNode *node = exitQueue->head; node != NULL; node = node->next) {
+        Process *p = node->process;
+        if (p->deadline > 0) {
+            Ticks late = p->runtime - dueTime(p);
+            lateness[n++] = late;
+            total += late;
+            if (late > 0) {
+                missed++;
+                overrun += late;
+            }
+        }
+    }
+    qsort(lateness, n, sizeof(Ticks), compareTicks);
+
+    static const int ranks[] = { 50, 90, 95, 99 };
+    printf("Deadlines missed: %d of %d (%.2f%%)\n", missed, n, 100.0 * missed / n);
+    printf("Lateness: min:%lld", lateness[0]);
+    for (int i = 0; i < (int)(sizeof(ranks) / sizeof(ranks[0])); i++) {
+        int k = (int)(((long long)ranks[i] * n + 99) / 100) - 1;
+        printf(" p%d:%lld", ranks[i], lateness[k < 0 ? 0 : k]);
+    }
+    printf(" max:%lld average:%.2f\n", lateness[n - 1], (double)total / n);
+    printf("Average overrun of a missed deadline: %.2f\n", missed > 0 ? (double)overrun / missed : 0.0);
+    free(lateness);
+}
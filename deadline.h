@@ -0,0 +1,48 @@
+/*
+ * deadline.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for process deadlines. A trace can
+ * give a process a deadline, in ticks after its arrival, by which it should
+ * complete. With earliest-deadline-first ordering the next task of a level
+ * is taken from the process whose deadline is nearest, and the report of
+ * any run with deadlines gives the rate of misses and the distribution of
+ * lateness.
+ */
+
+ #ifndef DEADLINE_H
+ #define DEADLINE_H
+
+ #include "queue.h"
+
+ // Struct for the processes ordered by deadline
+ typedef struct DeadlineHeap {
+     Process **items;           // processes with a deadline, a min-heap on absolute deadline
+     int count;                 // number of processes in the heap
+     int capacity;              // slots allocated in items
+ } DeadlineHeap;
+
+ // Struct for the ready tasks of a level ordered by deadline
+ typedef struct ReadyDeadlines {
+     Task **items;              // ready tasks whose process has a deadline, a min-heap on it
+     int count;                 // number of tasks in the heap
+     int capacity;              // slots allocated in items
+ } ReadyDeadlines;
+
+ // function prototypes
+ Ticks dueTime(const Process *p);
+ DeadlineHeap *createDeadlineHeap();
+ void freeDeadlineHeap(DeadlineHeap *h);
+ int pushDeadline(DeadlineHeap *h, Process *p);
+ void removeDeadline(DeadlineHeap *h, Process *p);
+ ReadyDeadlines *createReadyDeadlines();
+ void freeReadyDeadlines(ReadyDeadlines *h);
+ int reserveReadyDeadline(ReadyDeadlines *h);
+ void pushReadyDeadline(ReadyDeadlines *h, Task *t);
+ void removeReadyDeadline(ReadyDeadlines *h, Task *t);
+ Task *getNextDeadlineTask(DeadlineHeap *h, pQueue *q, tQueue *ready, Ticks runtime);
+ void printDeadlineStats(pQueue *exitQueue);
+
+ #endif
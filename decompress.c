@@ -0,0 +1,381 @@
+/*
+ * decompress.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of compressed traces. A compressed
+ * trace is returned as a custom stream whose read function decodes the
+ * next chunk, so the parser reads it like any other file and fclose frees
+ * the decoder. gzip is decoded with zlib. zstd is decoded with libzstd
+ * when built with ZSTD=1, and otherwise by a zstd process writing to a
+ * pipe. When more than one CPU is online, the decoding of a gzip or
+ * libzstd trace moves to a thread of its own, which writes to a pipe the
+ * stream reads from, so decompression overlaps tokenizing.
+ */
+
+#define _GNU_SOURCE // fopencookie and pipe2
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "decompress.h"
+
+// Struct for the decoder behind a compressed stream
+typedef struct Decoder {
+    FILE *source;              // compressed trace
+    int format;                // trace format code
+    z_stream gzip;             // gzip state
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd;        // zstd state
+#endif
+    unsigned char *in;         // compressed bytes read from source
+    size_t next;               // first unused byte of in
+    size_t available;          // unused bytes of in
+    int eof;                   // 1 once source has been read to the end
+    int complete;              // 1 when the input so far ends on a whole frame
+    long long position;        // decoded bytes handed to the stream
+    int pipe;                  // read end of the decoder's pipe, -1 when decoding inline
+    int output;                // write end, used by the decoder thread
+    pthread_t thread;          // decoder thread, when threaded
+    int threaded;              // 1 while the thread has not been joined
+    pid_t child;               // zstd process, or 0
+    int failed;                // set once the decoder thread or process has failed
+} Decoder;
+
+/*
+ * Function: traceFormat
+ *
+ * Returns the format of the trace open as file from its magic bytes,
+ * without moving the file. Input that cannot be read from the start, such
+ * as a pipe, is taken to be plain.
+ */
+int traceFormat(FILE *file) {
+    unsigned char magic[4];
+    ssize_t n = pread(fileno(file), magic, sizeof(magic), 0);
+
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return TRACE_GZIP;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return TRACE_ZSTD;
+    }
+    return TRACE_PLAIN;
+}
+
+/*
+ * Function: decodeChunk
+ *
+ * Decodes up to size bytes of the trace into out. Returns the number of
+ * bytes decoded, 0 at the end of the trace, -1 if it is damaged, cut
+ * short or cannot be read.
+ */
+static ssize_t decodeChunk(Decoder *d, char *out, size_t size) {
+    for (;;) {
+        if (d->available == 0 && !d->eof) {
+            d->next = 0;
+            d->available = fread(d->in, 1, DECODE_CHUNK, d->source);
+            if (d->available == 0) {
+                if (ferror(d->source)) return -1;
+                d->eof = 1;
+            }
+        }
+
+        size_t produced = 0;
+        if (d->format == TRACE_GZIP) {
+            // concatenated members decode as one trace
+            if (d->complete && d->available > 0) {
+                inflateReset(&d->gzip);
+                d->complete = 0;
+            }
+            d->gzip.next_in = d->in + d->next;
+            d->gzip.avail_in = (uInt)d->available;
+            d->gzip.next_out = (Bytef *)out;
+            d->gzip.avail_out = (uInt)size;
+            int status = inflate(&d->gzip, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                d->complete = 1;
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                return -1;
+            }
+            d->next += d->available - d->gzip.avail_in;
+            d->available = d->gzip.avail_in;
+            produced = size - d->gzip.avail_out;
+        }
+#ifdef HAVE_ZSTD
+        else {
+            ZSTD_inBuffer input = { d->in + d->next, d->available, 0 };
+            ZSTD_outBuffer output = { out, size, 0 };
+            size_t status = ZSTD_decompressStream(d->zstd, &output, &input);
+            if (ZSTD_isError(status)) {
+                return -1;
+            }
+            // a decoder between frames asks for more input, which is no sign of a cut
+            if (input.pos > 0 || output.pos > 0) {
+                d->complete = status == 0;
+            }
+            d->next += input.pos;
+            d->available -= input.pos;
+            produced = output.pos;
+        }
+#endif
+
+        if (produced > 0) {
+            return (ssize_t)produced;
+        }
+        if (d->available == 0 && d->eof) {
+            return d->complete ? 0 : -1;
+        }
+    }
+}
+
+/*
+ * Function: decodeTrace
+ *
+ * Body of the decoder thread: decodes the whole trace into the pipe, and
+ * stops early if the stream is closed first
+ */
+static void *decodeTrace(void *arg) {
+    Decoder *d = (Decoder *)arg;
+    char *buffer = (char *)malloc(DECODE_CHUNK);
+    ssize_t n = buffer != NULL ? 0 : -1;
+
+    // a closed stream shows up as EPIPE rather than a signal
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    while (buffer != NULL && (n = decodeChunk(d, buffer, DECODE_CHUNK)) > 0) {
+        ssize_t written = 0;
+        while (written < n) {
+            ssize_t w = write(d->output, buffer + written, n - written);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) break;
+            written += w;
+        }
+        if (written < n) {
+            n = 0;
+            break;
+        }
+    }
+
+    __atomic_store_n(&d->failed, n < 0, __ATOMIC_SEQ_CST);
+    close(d->output);
+    free(buffer);
+    return NULL;
+}
+
+/*
+ * Function: finishDecoder
+ *
+ * Waits for the decoder thread or process to end. Returns 0 if it decoded
+ * the whole trace, -1 if it failed.
+ */
+static int finishDecoder(Decoder *d) {
+    if (d->threaded) {
+        pthread_join(d->thread, NULL);
+        d->threaded = 0;
+    }
+    if (d->child > 0) {
+        int status = 0;
+        while (waitpid(d->child, &status, 0) < 0 && errno == EINTR);
+        d->child = 0;
+        d->failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    return __atomic_load_n(&d->failed, __ATOMIC_SEQ_CST) ? -1 : 0;
+}
+
+/*
+ * Function: readDecoded
+ *
+ * Read function of a compressed stream
+ */
+static ssize_t readDecoded(void *cookie, char *buffer, size_t size) {
+    Decoder *d = (Decoder *)cookie;
+    ssize_t n;
+
+    if (d->pipe < 0) {
+        n = decodeChunk(d, buffer, size);
+    } else {
+        while ((n = read(d->pipe, buffer, size)) < 0 && errno == EINTR);
+        // the pipe also ends when the decoder fails
+        if (n == 0 && finishDecoder(d) != 0) {
+            n = -1;
+        }
+    }
+
+    if (n > 0) {
+        d->position += n;
+    } else if (n < 0) {
+        errno = EIO;
+    }
+    return n;
+}
+
+/*
+ * Function: seekDecoded
+ *
+ * Seek function of a compressed stream: only reports the position, so
+ * ftell works and rewinding a stream that has not been read succeeds
+ */
+static int seekDecoded(void *cookie, off64_t *offset, int whence) {
+    Decoder *d = (Decoder *)cookie;
+    off64_t target = whence == SEEK_SET ? *offset : whence == SEEK_CUR ? d->position + *offset : -1;
+    if (target != d->position) {
+        errno = ESPIPE;
+        return -1;
+    }
+    *offset = target;
+    return 0;
+}
+
+/*
+ * Function: freeDecoder
+ *
+ * Stops the decoder, closing the pipe first so that it gives up, and
+ * frees it along with the compressed trace
+ */
+static void freeDecoder(Decoder *d) {
+    if (d->pipe >= 0) {
+        close(d->pipe);
+    }
+    finishDecoder(d);
+    if (d->format == TRACE_GZIP) {
+        inflateEnd(&d->gzip);
+    }
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(d->zstd);
+#endif
+    fclose(d->source);
+    free(d->in);
+    free(d);
+}
+
+/*
+ * Function: closeDecoded
+ *
+ * Close function of a compressed stream
+ */
+static int closeDecoded(void *cookie) {
+    freeDecoder((Decoder *)cookie);
+    return 0;
+}
+
+/*
+ * Function: startDecoder
+ *
+ * Moves decoding to a thread of its own, or for zstd without libzstd to a
+ * zstd process, feeding the pipe read by the stream. A thread that cannot
+ * be started leaves the stream decoding inline. Returns 0 on success, -1
+ * if the trace cannot be decoded.
+ */
+static int startDecoder(Decoder *d) {
+    int fds[2];
+#ifndef HAVE_ZSTD
+    if (d->format == TRACE_ZSTD) {
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            return -1;
+        }
+        fflush(NULL);
+        d->child = fork();
+        if (d->child == 0) {
+            // the trace has not been read, so the descriptor is at its start
+            if (dup2(fileno(d->source), STDIN_FILENO) < 0 || dup2(fds[1], STDOUT_FILENO) < 0) {
+                _exit(127);
+            }
+            signal(SIGPIPE, SIG_DFL);
+            execlp("zstd", "zstd", "-dcq", (char *)NULL);
+            _exit(127);
+        }
+        close(fds[1]);
+        if (d->child < 0) {
+            d->child = 0;
+            close(fds[0]);
+            return -1;
+        }
+        d->pipe = fds[0];
+        return 0;
+    }
+#endif
+
+    if (!DECODE_THREAD || sysconf(_SC_NPROCESSORS_ONLN) < 2 || pipe2(fds, O_CLOEXEC) != 0) {
+        return 0;
+    }
+    d->pipe = fds[0];
+    d->output = fds[1];
+    if (pthread_create(&d->thread, NULL, decodeTrace, d) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        d->pipe = -1;
+        return 0;
+    }
+    d->threaded = 1;
+    return 0;
+}
+
+/*
+ * Function: openTrace
+ *
+ * Opens the trace at path for reading, decompressing it as it is read if
+ * it is gzip or zstd. The stream is closed with fclose. Returns NULL, with
+ * errno set, if the trace cannot be opened.
+ */
+FILE *openTrace(const char *path) {
+    FILE *source = fopen(path, "r");
+    if (source == NULL) {
+        return NULL;
+    }
+    int format = traceFormat(source);
+    if (format == TRACE_PLAIN) {
+        return source;
+    }
+
+    // the whole file is about to be read in order
+    posix_fadvise(fileno(source), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    Decoder *d = (Decoder *)calloc(1, sizeof(Decoder));
+    if (d == NULL || (d->in = (unsigned char *)malloc(DECODE_CHUNK)) == NULL) {
+        free(d);
+        fclose(source);
+        errno = ENOMEM;
+        return NULL;
+    }
+    d->source = source;
+    d->format = format;
+    d->pipe = -1;
+    d->output = -1;
+
+    int ready;
+    if (format == TRACE_GZIP) {
+        // 16 selects the gzip wrapper
+        ready = inflateInit2(&d->gzip, 16 + MAX_WBITS) == Z_OK;
+        if (!ready) d->format = TRACE_PLAIN;
+    } else {
+#ifdef HAVE_ZSTD
+        ready = (d->zstd = ZSTD_createDStream()) != NULL && !ZSTD_isError(ZSTD_initDStream(d->zstd));
+#else
+        ready = 1;
+#endif
+    }
+
+    cookie_io_functions_t io = { readDecoded, NULL, seekDecoded, closeDecoded };
+    FILE *file = NULL;
+    if (ready && startDecoder(d) == 0) {
+        file = fopencookie(d, "r", io);
+    }
+    if (file == NULL) {
+        freeDecoder(d);
+        errno = ENOMEM;
+    }
+    return file;
+}
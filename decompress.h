@@ -0,0 +1,35 @@
+/*
+ * decompress.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for compressed traces. A trace is
+ * opened through openTrace, which recognizes gzip and zstd input by its
+ * magic bytes and hands back a stream that decompresses as it is read, so
+ * archived traces are replayed without being unpacked to disk first.
+ */
+
+ #ifndef DECOMPRESS_H
+ #define DECOMPRESS_H
+
+ #include <stdio.h>
+
+ // Trace formats
+ #define TRACE_PLAIN 0
+ #define TRACE_GZIP 1
+ #define TRACE_ZSTD 2
+
+ #ifndef DECODE_CHUNK
+ #define DECODE_CHUNK 65536 // compressed bytes read, and decoded bytes passed on, at a time
+ #endif
+
+ #ifndef DECODE_THREAD
+ #define DECODE_THREAD 1 // decode on a thread of its own when more than one CPU is online
+ #endif
+
+ // function prototypes
+ int traceFormat(FILE *file);
+ FILE *openTrace(const char *path);
+
+ #endif
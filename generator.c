@@ -0,0 +1,389 @@
+/*
+ * generator.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the open-loop arrival
+ * generator. Arrival times are drawn in continuous time and rounded down
+ * to ticks, so several processes may arrive on the same tick. Bursts are
+ * a two-state Markov-modulated Poisson process and diurnal load is drawn
+ * by thinning a Poisson process at the peak rate. Each process gets its
+ * own program of instructions, made into tasks only as they are run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#include "generator.h"
+
+/*
+ * Function: nextUniform
+ *
+ * Returns a random number in (0, 1] from a xorshift* generator
+ */
+static double nextUniform(Generator *gen) {
+    gen->rng ^= gen->rng >> 12;
+    gen->rng ^= gen->rng << 25;
+    gen->rng ^= gen->rng >> 27;
+    return ((gen->rng * 2685821657736338717ULL >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Function: nextInRange
+ *
+ * Returns a random integer in range r
+ */
+static int nextInRange(Generator *gen, GenRange r) {
+    int span = r.max - r.min + 1;
+    int k = (int)(nextUniform(gen) * span);
+    return r.min + (k < span ? k : span - 1);
+}
+
+/*
+ * Function: nextGap
+ *
+ * Returns an exponentially distributed gap for the given rate
+ */
+static double nextGap(Generator *gen, double rate) {
+    return -log(nextUniform(gen)) / rate;
+}
+
+/*
+ * Function: parseRange
+ *
+ * Parses a range of the form min-max or a single value. Returns 0 on
+ * success, -1 if the range is invalid.
+ */
+static int parseRange(const char *text, GenRange *r) {
+    char extra;
+    if (sscanf(text, "%d-%d%c", &r->min, &r->max, &extra) == 2) {
+        return r->min >= 0 && r->min <= r->max ? 0 : -1;
+    }
+    if (sscanf(text, "%d%c", &r->min, &extra) == 1) {
+        r->max = r->min;
+        return r->min >= 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+/*
+ * Function: parseNumber
+ *
+ * Parses a non-negative number. Returns 0 on success, -1 otherwise.
+ */
+static int parseNumber(const char *text, double *value) {
+    char extra;
+    return sscanf(text, "%lf%c", value, &extra) == 1 && *value >= 0 ? 0 : -1;
+}
+
+/*
+ * Function: parseGeneratorSpec
+ *
+ * Parses a specification of the form model,key=value,... where model is
+ * poisson, mmpp or diurnal. Returns 0 on success, -1 if it is invalid.
+ */
+int parseGeneratorSpec(const char *text, GeneratorSpec *spec) {
+    spec->model = ARRIVALS_POISSON;
+    spec->rate = 0.1;
+    spec->burstRate = -1;
+    spec->burstLength = 100;
+    spec->calmLength = 1000;
+    spec->period = 10000;
+    spec->amplitude = 0.5;
+    spec->count = 0;
+    spec->until = 0;
+    spec->seed = 1;
+    spec->firstPid = 1;
+    spec->priority = (GenRange){ 0, 99 };
+    spec->tasks = (GenRange){ 1, 8 };
+    spec->exe = (GenRange){ 1, 10 };
+    spec->io = (GenRange){ 1, 10 };
+    spec->ioShare = 0.3;
+
+    char *copy = strdup(text);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    int status = 0;
+    double value;
+    char *save = NULL;
+    char *item = strtok_r(copy, ",", &save);
+    if (item == NULL) {
+        status = -1;
+    } else if (strcmp(item, "poisson") == 0) {
+        spec->model = ARRIVALS_POISSON;
+    } else if (strcmp(item, "mmpp") == 0) {
+        spec->model = ARRIVALS_MMPP;
+    } else if (strcmp(item, "diurnal") == 0) {
+        spec->model = ARRIVALS_DIURNAL;
+    } else {
+        status = -1;
+    }
+
+    while (status == 0 && (item = strtok_r(NULL, ",", &save)) != NULL) {
+        char *arg = strchr(item, '=');
+        if (arg == NULL) {
+            status = -1;
+            break;
+        }
+        *arg++ = '\0';
+
+        if (strcmp(item, "priority") == 0) {
+            status = parseRange(arg, &spec->priority);
+        } else if (strcmp(item, "tasks") == 0) {
+            status = parseRange(arg, &spec->tasks);
+        } else if (strcmp(item, "exe") == 0) {
+            status = parseRange(arg, &spec->exe);
+        } else if (strcmp(item, "io") == 0) {
+            status = parseRange(arg, &spec->io);
+        } else if (parseNumber(arg, &value) != 0) {
+            status = -1;
+        } else if (strcmp(item, "rate") == 0) {
+            spec->rate = value;
+        } else if (strcmp(item, "burst") == 0) {
+            spec->burstRate = value;
+        } else if (strcmp(item, "on") == 0) {
+            spec->burstLength = value;
+        } else if (strcmp(item, "off") == 0) {
+            spec->calmLength = value;
+        } else if (strcmp(item, "period") == 0) {
+            spec->period = value;
+        } else if (strcmp(item, "amplitude") == 0) {
+            spec->amplitude = value;
+        } else if (strcmp(item, "count") == 0) {
+            spec->count = (long)value;
+        } else if (strcmp(item, "until") == 0) {
+            spec->until = (Ticks)value;
+        } else if (strcmp(item, "seed") == 0) {
+            spec->seed = (unsigned long)value;
+        } else if (strcmp(item, "pid") == 0) {
+            spec->firstPid = (int)value;
+        } else if (strcmp(item, "iofrac") == 0) {
+            spec->ioShare = value;
+        } else {
+            status = -1;
+        }
+    }
+    free(copy);
+
+    // bursts default to ten times the calm rate
+    if (spec->burstRate < 0) {
+        spec->burstRate = 10 * spec->rate;
+    }
+    if (spec->ioShare > 1 || spec->amplitude > 1 || spec->period <= 0 ||
+        spec->burstLength <= 0 || spec->calmLength <= 0) {
+        status = -1;
+    }
+    if (spec->model == ARRIVALS_MMPP ? spec->rate <= 0 && spec->burstRate <= 0 : spec->rate <= 0) {
+        status = -1;
+    }
+    return status;
+}
+
+/*
+ * Function: drawArrival
+ *
+ * Moves the generator to its next arrival time, or marks it done when the
+ * count or the time limit is reached
+ */
+static void drawArrival(Generator *gen) {
+    GeneratorSpec *spec = &gen->spec;
+
+    switch (spec->model) {
+        case ARRIVALS_POISSON:
+            gen->next += nextGap(gen, spec->rate);
+            break;
+        case ARRIVALS_MMPP:
+            // the gap is memoryless, so a state change simply restarts it
+            for (;;) {
+                double rate = gen->burst ? spec->burstRate : spec->rate;
+                double at = rate > 0 ? gen->next + nextGap(gen, rate) : gen->switchTime;
+                if (at < gen->switchTime) {
+                    gen->next = at;
+                    break;
+                }
+                gen->next = gen->switchTime;
+                gen->burst = !gen->burst;
+                gen->switchTime += nextGap(gen, 1.0 / (gen->burst ? spec->burstLength : spec->calmLength));
+            }
+            break;
+        case ARRIVALS_DIURNAL: {
+            // thin a Poisson process at the peak rate down to the curve
+            double peak = spec->rate * (1 + spec->amplitude);
+            for (;;) {
+                gen->next += nextGap(gen, peak);
+                double rate = spec->rate * (1 + spec->amplitude * sin(2 * M_PI * gen->next / spec->period));
+                if (nextUniform(gen) * peak <= rate) {
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    if ((spec->count > 0 && gen->created >= spec->count) ||
+        (spec->until > 0 && gen->next > spec->until) || gen->next >= (double)LLONG_MAX) {
+        gen->done = 1;
+    }
+}
+
+/*
+ * Function: createGenerator
+ *
+ * Creates a generator for spec and draws its first arrival, or returns
+ * NULL if allocation fails
+ */
+Generator *createGenerator(const GeneratorSpec *spec) {
+    Generator *gen = (Generator *)malloc(sizeof(Generator));
+    if (!gen) {
+        return NULL;
+    }
+
+    gen->spec = *spec;
+    gen->rng = spec->seed * 0x9E3779B97F4A7C15ULL + 1;  // never zero
+    gen->next = 0;
+    gen->burst = 0;
+    gen->nextPid = spec->firstPid;
+    gen->done = 0;
+    gen->created = 0;
+    gen->retired = 0;
+    gen->switchTime = nextGap(gen, 1.0 / spec->calmLength);
+    drawArrival(gen);
+
+    return gen;
+}
+
+/*
+ * Function: attachGenerator
+ *
+ * Makes an engine with no processes take its arrivals from gen. The run
+ * starts at the first arrival and, as arrivals can leave the engine with
+ * nothing to run, idle ticks are let pass.
+ */
+void attachGenerator(Simulation *sim, Generator *gen) {
+    sim->generator = gen;
+    sim->idleTicks = 1;
+    if (!gen->done) {
+        sim->stats->runtime = sim->stats->startTime = (Ticks)gen->next;
+    }
+}
+
+/*
+ * Function: createArrival
+ *
+ * Creates the process arriving now, with a fresh program drawn from the
+ * instruction mix, and adds it to the lowest level. Returns 0 on success,
+ * -1 if allocation fails.
+ */
+static int createArrival(Generator *gen, Simulation *sim) {
+    GeneratorSpec *spec = &gen->spec;
+    int entry = sim->levels - 1;
+
+    int count = nextInRange(gen, spec->tasks);
+    Program *prog = createProgram(count + 1);
+    Process *p = createProcess();
+    if (prog == NULL || p == NULL) {
+        releaseProgram(prog);
+        freeProcess(p);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        int io = nextUniform(gen) <= spec->ioShare;
+        prog->instructions[i].type = io ? 'i' : 'e';
+        prog->instructions[i].time = nextInRange(gen, io ? spec->io : spec->exe);
+    }
+    prog->instructions[count].type = 't';
+    prog->instructions[count].time = 0;
+
+    p->pid = gen->nextPid++;
+    p->priority = nextInRange(gen, spec->priority);
+    p->arrival = (Ticks)gen->next;
+    p->quantum = sim->level[entry].quantum;
+    attachProgram(p, prog);
+    releaseProgram(prog); // the process holds the only reference
+
+    if (enqueueProcess(sim->level[entry].queue, p) != 0) {
+        freeProcess(p);
+        return -1;
+    }
+    adoptProcess(sim, p);
+    gen->created++;
+    return 0;
+}
+
+/*
+ * Function: advanceGenerator
+ *
+ * Frees the completed processes whose tasks are all gone and adds every
+ * process that has arrived by the current time. When the engine has run
+ * dry, the clock jumps to the next arrival. Returns 0 on success, -1 if
+ * allocation fails.
+ */
+int advanceGenerator(Generator *gen, Simulation *sim) {
+    Stats *stats = sim->stats;
+
+    pNode *n = sim->exitQueue->head;
+    while (n != NULL) {
+        Process *p = n->process;
+        n = n->next;
+        if (p->tasksOut <= 0) {
+            retireProcess(sim, p);
+            gen->retired++;
+        }
+    }
+    if (sim->progress) {
+        sim->progress->retired = gen->retired;
+    }
+
+    if (gen->done) {
+        return 0;
+    }
+    if (allQueuesEmpty(sim) && gen->next > stats->runtime) {
+        stats->runtime = (Ticks)gen->next;
+    }
+
+    int added = 0;
+    while (!gen->done && gen->next < (double)stats->runtime + 1) {
+        if (createArrival(gen, sim) != 0) {
+            return -1;
+        }
+        added = 1;
+        drawArrival(gen);
+    }
+    if (added) {
+        refreshLevels(sim);
+    }
+    return 0;
+}
+
+/*
+ * Function: printGeneratorStats
+ *
+ * Prints the final statistics of a generated run. Completed processes are
+ * freed as the run goes, so there is no per-process summary.
+ */
+void printGeneratorStats(Generator *gen, Simulation *sim) {
+    Stats *stats = sim->stats;
+    long completed = gen->retired + sim->exitQueue->size;
+
+    printf("Start/End Time: %lld, %lld\n", stats->startTime, stats->runtime);
+    printf("Processes generated: %ld\n", gen->created);
+    printf("Processes completed: %ld\n", completed);
+    printf("Instructions completed: %lld\n", stats->instructions);
+    printf("Average ready time: %.2f\n", completed > 0 ? (double)stats->totalWait / completed : 0.0);
+    printf("Max ready time: %lld\n", stats->maxWait);
+    printf("Min ready time: %lld\n", completed > 0 ? stats->minWait : 0);
+}
+
+/*
+ * Function: freeGenerator
+ *
+ * Frees a generator. Its processes belong to the engine.
+ */
+void freeGenerator(Generator *gen) {
+    free(gen);
+}
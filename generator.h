@@ -0,0 +1,73 @@
+/*
+ * generator.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for the open-loop arrival generator.
+ * Instead of parsing a trace, the engine is fed processes drawn from a
+ * seeded arrival process and instruction mix as simulated time reaches
+ * them, and completed processes are freed as it goes, so memory stays
+ * bounded by the processes in flight however long the run is.
+ */
+
+ #ifndef GENERATOR_H
+ #define GENERATOR_H
+
+ #include "Simulation.h"
+
+ // Arrival processes
+ typedef enum ArrivalModel {
+     ARRIVALS_POISSON,          // constant rate
+     ARRIVALS_MMPP,             // two-state Markov-modulated bursts
+     ARRIVALS_DIURNAL           // rate following a sine over a period
+ } ArrivalModel;
+
+ // Struct for an inclusive range of integers
+ typedef struct GenRange {
+     int min;                   // smallest value
+     int max;                   // largest value
+ } GenRange;
+
+ // Struct for a generator specification
+ typedef struct GeneratorSpec {
+     ArrivalModel model;        // arrival process
+     double rate;               // arrivals per tick (between bursts for mmpp, mean for diurnal)
+     double burstRate;          // arrivals per tick during a burst (mmpp)
+     double burstLength;        // mean ticks a burst lasts (mmpp)
+     double calmLength;         // mean ticks between bursts (mmpp)
+     double period;             // ticks per cycle (diurnal)
+     double amplitude;          // relative swing of the rate, 0 to 1 (diurnal)
+     long count;                // processes to generate, 0 = no limit
+     Ticks until;               // no arrivals after this time, 0 = no limit
+     unsigned long seed;        // random seed
+     int firstPid;              // pid of the first process
+     GenRange priority;         // process priorities
+     GenRange tasks;            // instructions per process, before terminate
+     GenRange exe;              // execution times
+     GenRange io;               // I/O times
+     double ioShare;            // probability an instruction is I/O
+ } GeneratorSpec;
+
+ // Struct for the state of a running generator
+ typedef struct Generator {
+     GeneratorSpec spec;        // specification
+     unsigned long long rng;    // random state
+     double next;               // time of the next arrival
+     int burst;                 // 1 while in a burst (mmpp)
+     double switchTime;         // time of the next burst state change (mmpp)
+     int nextPid;               // pid of the next process
+     int done;                  // 1 once no arrivals remain
+     long created;              // processes created so far
+     long retired;              // completed processes freed so far
+ } Generator;
+
+ // function prototypes
+ int parseGeneratorSpec(const char *text, GeneratorSpec *spec);
+ Generator *createGenerator(const GeneratorSpec *spec);
+ void attachGenerator(Simulation *sim, Generator *gen);
+ int advanceGenerator(Generator *gen, Simulation *sim);
+ void printGeneratorStats(Generator *gen, Simulation *sim);
+ void freeGenerator(Generator *gen);
+
+ #endif
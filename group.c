@@ -0,0 +1,730 @@
+/*
+ * group.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of fair-share groups. Every group
+ * keeps its subgroups in a min-heap on virtual time, the CPU ticks used by
+ * a subgroup and everything below it divided by its weight, so the group
+ * furthest behind its share is at the top. A tick of CPU is charged to the
+ * group of the running process and each group above it, each moving down
+ * its parent's heap as its virtual time grows.
+ *
+ * Every group keeps lists of its process nodes and ready task nodes at each
+ * level of the engine, in queue order, linked and unlinked as the level
+ * queues change, with a count of the nodes of the group and its subgroups.
+ * A pick walks down from the root taking the subgroup with a runnable task
+ * and the least virtual time at every step. The heap is searched from the
+ * top and never below a runnable group or one no earlier than the best
+ * found, a group with nothing queued at the level is passed over at once,
+ * and only a group's own lists are looked at to find its runnable task, so
+ * a pick only visits the groups ahead of the one chosen. A group that had
+ * nothing to run while its siblings used the CPU starts again from the
+ * virtual time of the last subgroup chosen, rather than from where it
+ * stopped, so idling does not bank CPU for later.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "group.h"
+#include "parser.h"
+
+/*
+ * Function: initGroup
+ *
+ * Sets up a group with no subgroups under parent
+ */
+static void initGroup(Group *g, GroupTree *tree, Group *parent, char *name) {
+    memset(g, 0, sizeof(Group));
+    g->name = name;
+    g->weight = GROUP_WEIGHT;
+    g->parent = parent;
+    g->tree = tree;
+    g->order = tree->count++;
+    if (tree->last != NULL) {
+        tree->last->next = g;
+    }
+    tree->last = g;
+}
+
+/*
+ * Function: siftUp
+ *
+ * Moves the subgroup in slot i of g's heap up to its place
+ */
+static void siftUp(Group *g, int i) {
+    Group *child = g->heap[i];
+    while (i > 0) {
+        int up = (i - 1) / 2;
+        if (g->heap[up]->vtime <= child->vtime) break;
+        g->heap[i] = g->heap[up];
+        g->heap[i]->slot = i;
+        i = up;
+    }
+    g->heap[i] = child;
+    child->slot = i;
+}
+
+/*
+ * Function: siftDown
+ *
+ * Moves the subgroup in slot i of g's heap down to its place
+ */
+static void siftDown(Group *g, int i) {
+    Group *child = g->heap[i];
+    for (;;) {
+        int least = 2 * i + 1;
+        if (least >= g->count) break;
+        if (least + 1 < g->count && g->heap[least + 1]->vtime < g->heap[least]->vtime) {
+            least++;
+        }
+        if (child->vtime <= g->heap[least]->vtime) break;
+        g->heap[i] = g->heap[least];
+        g->heap[i]->slot = i;
+        i = least;
+    }
+    g->heap[i] = child;
+    child->slot = i;
+}
+
+/*
+ * Function: addSubgroup
+ *
+ * Creates a subgroup of g with the given name. Returns NULL if
+ * allocation fails.
+ */
+static Group *addSubgroup(Group *g, const char *name, size_t length) {
+    if (g->count == g->capacity) {
+        int capacity = g->capacity ? 2 * g->capacity : 4;
+        Group **heap = (Group **)realloc(g->heap, capacity * sizeof(Group *));
+        if (heap == NULL) {
+            return NULL;
+        }
+        g->heap = heap;
+        g->capacity = capacity;
+    }
+
+    Group *child = (Group *)malloc(sizeof(Group));
+    char *copy = (char *)malloc(length + 1);
+    if (child == NULL || copy == NULL) {
+        free(child);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+    initGroup(child, g->tree, g, copy);
+
+    // a new group joins at the virtual time its siblings have reached
+    child->vtime = g->floor;
+    g->heap[g->count] = child;
+    siftUp(g, g->count++);
+    return child;
+}
+
+/*
+ * Function: createGroups
+ *
+ * Creates an empty hierarchy held once by the caller, or returns NULL if
+ * allocation fails
+ */
+GroupTree *createGroups() {
+    GroupTree *tree = (GroupTree *)calloc(1, sizeof(GroupTree));
+    if (tree == NULL) {
+        return NULL;
+    }
+    initGroup(&tree->root, tree, NULL, "");
+    tree->refs = 1;
+
+    // processes of a grouped trace that name no group share one of their own
+    tree->fallback = addSubgroup(&tree->root, "(none)", 6);
+    if (tree->fallback == NULL) {
+        free(tree->root.heap);
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+/*
+ * Function: holdGroups
+ *
+ * Takes one more hold on a hierarchy and returns it
+ */
+GroupTree *holdGroups(GroupTree *tree) {
+    if (tree != NULL) {
+        __sync_fetch_and_add(&tree->refs, 1);
+    }
+    return tree;
+}
+
+/*
+ * Function: releaseGroups
+ *
+ * Drops one hold on a hierarchy, freeing it when the last is dropped
+ */
+void releaseGroups(GroupTree *tree) {
+    if (tree == NULL || __sync_sub_and_fetch(&tree->refs, 1) > 0) return;
+
+    Group *g = tree->root.next;
+    free(tree->root.heap);
+    while (g != NULL) {
+        Group *next = g->next;
+        free(g->heap);
+        free(g->name);
+        free(g);
+        g = next;
+    }
+    free(tree);
+}
+
+/*
+ * Function: placeProcess
+ *
+ * Places process p in the group at path, creating the groups along it
+ * that do not exist yet. Each component of the path is a name, optionally
+ * followed by =<weight>. Returns a parser status code, with the reason
+ * for a failure in message.
+ */
+int placeProcess(GroupTree *tree, Process *p, const char *path, const char **message) {
+    Group *g = &tree->root;
+
+    if (p->group != NULL) {
+        *message = "Process in more than one group";
+        return PARSE_ERROR;
+    }
+
+    while (*path == '/') path++;
+    if (*path == '\0') {
+        *message = "Error reading group";
+        return PARSE_ERROR;
+    }
+
+    while (*path != '\0') {
+        // a name is letters, digits, '_', '-' and '.'
+        size_t length = strspn(path, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-.");
+        const char *end = path + length;
+        int weight = 0;
+        if (length == 0 || (*end != '\0' && *end != '/' && *end != '=')) {
+            *message = "Error reading group";
+            return PARSE_ERROR;
+        }
+        if (*end == '=') {
+            char *after;
+            long value = strtol(end + 1, &after, 10);
+            if (after == end + 1 || (*after != '\0' && *after != '/') || value < 1 || value > GROUP_MAX_WEIGHT) {
+                *message = "Invalid group weight";
+                return PARSE_ERROR;
+            }
+            weight = (int)value;
+            end = after;
+        }
+
+        Group *child = NULL;
+        for (int i = 0; i < g->count; i++) {
+            if (g->heap[i] != tree->fallback && strlen(g->heap[i]->name) == length &&
+                strncmp(g->heap[i]->name, path, length) == 0) {
+                child = g->heap[i];
+                break;
+            }
+        }
+        if (child == NULL) {
+            // cgroups only run processes in leaves, and so do groups
+            if (g->members > 0) {
+                *message = "Subgroup of a group with processes";
+                return PARSE_ERROR;
+            }
+            if ((child = addSubgroup(g, path, length)) == NULL) {
+                *message = "Memory allocation failed";
+                return PARSE_NOMEM;
+            }
+        }
+        if (weight > 0) {
+            if (child->weighted && child->weight != weight) {
+                *message = "Conflicting group weight";
+                return PARSE_ERROR;
+            }
+            child->weight = weight;
+            child->weighted = 1;
+        }
+
+        g = child;
+        path = end;
+        while (*path == '/') path++;
+    }
+
+    if (g->count > 0) {
+        *message = "Process in a group with subgroups";
+        return PARSE_ERROR;
+    }
+    g->members++;
+    p->group = g;
+    holdGroups(tree);
+    return PARSE_OK;
+}
+
+/*
+ * Function: placeUngrouped
+ *
+ * Places the processes of q that are in no group in the hierarchy's group
+ * for them, once a trace has been read
+ */
+void placeUngrouped(GroupTree *tree, pQueue *q) {
+    for (pNode *n = q->head; n != NULL; n = n->next) {
+        placeUngroupedProcess(tree, n->process);
+    }
+}
+
+/*
+ * Function: placeUngroupedProcess
+ *
+ * Places process p in the hierarchy's group for processes in no group, if
+ * it is in none. A node of p already at a level of the engine joins the
+ * group's list there.
+ */
+void placeUngroupedProcess(GroupTree *tree, Process *p) {
+    if (p->group != NULL) {
+        return;
+    }
+    tree->fallback->members++;
+    p->group = tree->fallback;
+    holdGroups(tree);
+    for (pNode *n = p->nodes; n != NULL; n = n->sibling) {
+        linkGroupProcess(n);
+    }
+}
+
+/*
+ * Function: findGroups
+ *
+ * Returns the hierarchy of the first process of q placed in a group, or
+ * NULL if no process of q is
+ */
+GroupTree *findGroups(pQueue *q) {
+    for (pNode *n = q ? q->head : NULL; n != NULL; n = n->next) {
+        if (n->process->group != NULL) {
+            return n->process->group->tree;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: chargeGroup
+ *
+ * Charges a tick of CPU used by process p to its group and every group
+ * above it
+ */
+void chargeGroup(GroupTree *tree, Process *p) {
+    Group *g = p->group != NULL ? p->group : tree->fallback;
+    for (; g->parent != NULL; g = g->parent) {
+        g->cpu++;
+        g->vtime += GROUP_UNIT / g->weight;
+        siftDown(g->parent, g->slot);
+    }
+    g->cpu++;
+}
+
+/*
+ * Function: countQueued
+ *
+ * Adds delta nodes at a level to group g and every group above it
+ */
+static void countQueued(Group *g, int level, int delta) {
+    for (; g != NULL; g = g->parent) {
+        g->level[level].queued += delta;
+    }
+}
+
+/*
+ * Function: attachGroupQueue
+ *
+ * Makes q the queue of an engine level, adding the nodes already in it to
+ * their groups' lists in queue order
+ */
+void attachGroupQueue(pQueue *q, int level) {
+    q->level = level;
+    for (pNode *n = q->head; n != NULL; n = n->next) {
+        Group *g = n->process->group;
+        if (g == NULL) {
+            continue;
+        }
+        GroupLevel *l = &g->level[level];
+        n->groupPrev = l->tail;
+        n->groupNext = NULL;
+        if (l->tail != NULL) {
+            l->tail->groupNext = n;
+        } else {
+            l->head = n;
+        }
+        l->tail = n;
+        countQueued(g, level, 1);
+    }
+}
+
+/*
+ * Function: linkGroupProcess
+ *
+ * Adds a node just linked into a level queue to its group's list there,
+ * behind the nearest node of the group ahead of it. A node added at
+ * either end of the queue goes straight to that end of the list; one
+ * added by priority looks back no further than the insertion walked.
+ */
+void linkGroupProcess(pNode *node) {
+    Group *g = node->process->group;
+    if (g == NULL || node->queue == NULL || node->queue->level < 0) {
+        return;
+    }
+    GroupLevel *l = &g->level[node->queue->level];
+
+    pNode *before = NULL;
+    if (node->next == NULL) {
+        before = l->tail;
+    } else if (node->prev != NULL) {
+        for (before = node->prev; before != NULL && before->process->group != g; before = before->prev);
+    }
+
+    node->groupPrev = before;
+    node->groupNext = before != NULL ? before->groupNext : l->head;
+    if (node->groupNext != NULL) {
+        node->groupNext->groupPrev = node;
+    } else {
+        l->tail = node;
+    }
+    if (before != NULL) {
+        before->groupNext = node;
+    } else {
+        l->head = node;
+    }
+    countQueued(g, node->queue->level, 1);
+}
+
+/*
+ * Function: unlinkGroupProcess
+ *
+ * Takes a node about to leave a level queue out of its group's list there
+ */
+void unlinkGroupProcess(pNode *node) {
+    Group *g = node->process->group;
+    if (g == NULL || node->queue == NULL || node->queue->level < 0) {
+        return;
+    }
+    GroupLevel *l = &g->level[node->queue->level];
+
+    if (node->groupPrev != NULL) {
+        node->groupPrev->groupNext = node->groupNext;
+    } else {
+        l->head = node->groupNext;
+    }
+    if (node->groupNext != NULL) {
+        node->groupNext->groupPrev = node->groupPrev;
+    } else {
+        l->tail = node->groupPrev;
+    }
+    node->groupNext = node->groupPrev = NULL;
+    countQueued(g, node->queue->level, -1);
+}
+
+/*
+ * Function: linkGroupTask
+ *
+ * Adds a task node just linked into ready queue q to its group's list of
+ * ready tasks there, as linkGroupProcess does for process nodes
+ */
+void linkGroupTask(tQueue *q, tNode *node) {
+    Group *g = node->task->parent != NULL ? node->task->parent->group : NULL;
+    if (g == NULL || q->level < 0) {
+        return;
+    }
+    GroupLevel *l = &g->level[q->level];
+
+    tNode *before = NULL;
+    if (node->next == NULL) {
+        before = l->readyTail;
+    } else if (node->prev != NULL) {
+        for (before = node->prev; before != NULL && before->task->parent->group != g; before = before->prev);
+    }
+
+    node->groupPrev = before;
+    node->groupNext = before != NULL ? before->groupNext : l->readyHead;
+    if (node->groupNext != NULL) {
+        node->groupNext->groupPrev = node;
+    } else {
+        l->readyTail = node;
+    }
+    if (before != NULL) {
+        before->groupNext = node;
+    } else {
+        l->readyHead = node;
+    }
+    countQueued(g, q->level, 1);
+}
+
+/*
+ * Function: unlinkGroupTask
+ *
+ * Takes a task node about to leave ready queue q out of its group's list
+ */
+void unlinkGroupTask(tQueue *q, tNode *node) {
+    Group *g = node->task->parent != NULL ? node->task->parent->group : NULL;
+    if (g == NULL || q->level < 0) {
+        return;
+    }
+    GroupLevel *l = &g->level[q->level];
+
+    if (node->groupPrev != NULL) {
+        node->groupPrev->groupNext = node->groupNext;
+    } else {
+        l->readyHead = node->groupNext;
+    }
+    if (node->groupNext != NULL) {
+        node->groupNext->groupPrev = node->groupPrev;
+    } else {
+        l->readyTail = node->groupPrev;
+    }
+    node->groupNext = node->groupPrev = NULL;
+    countQueued(g, q->level, -1);
+}
+
+/*
+ * Function: canRun
+ *
+ * Returns 1 if process p can start a task at runtime, under the same
+ * conditions getNextTask applies
+ */
+static inline int canRun(Process *p, Ticks runtime) {
+    return p->arrival <= runtime && p->taskRunning == 0 && hasTask(p);
+}
+
+/*
+ * Function: hasRunnable
+ *
+ * Returns 1 if group g or a group below it has a ready task or a process
+ * that can run at level, remembering the answer for the rest of the pick.
+ * A group with nothing queued at the level is answered at once, and a
+ * group with processes only looks at its own list.
+ */
+static int hasRunnable(GroupTree *tree, Group *g, int level, Ticks runtime) {
+    if (g->mark == tree->pick) {
+        return g->runnable;
+    }
+    g->mark = tree->pick;
+    g->runnable = 0;
+    g->first = NULL;
+
+    GroupLevel *l = &g->level[level];
+    if (l->queued == 0) {
+        return 0;
+    }
+    if (l->readyHead != NULL) {
+        return g->runnable = 1;
+    }
+    for (pNode *n = l->head; n != NULL; n = n->groupNext) {
+        if (canRun(n->process, runtime)) {
+            g->first = n;
+            return g->runnable = 1;
+        }
+    }
+    for (int i = 0; i < g->count; i++) {
+        if (hasRunnable(tree, g->heap[i], level, runtime)) {
+            return g->runnable = 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: earliestRunnable
+ *
+ * Searches the part of g's heap below slot i for a subgroup with a
+ * runnable task and less virtual time than best, and returns the earliest
+ * found (or best). Slots below a runnable subgroup are never earlier than
+ * it, and neither are those below a subgroup no earlier than best.
+ */
+static Group *earliestRunnable(GroupTree *tree, Group *g, int i, int level, Ticks runtime, Group *best) {
+    if (i >= g->count) {
+        return best;
+    }
+    Group *child = g->heap[i];
+    if (best != NULL && child->vtime >= best->vtime) {
+        return best;
+    }
+    if (hasRunnable(tree, child, level, runtime)) {
+        return child;
+    }
+    best = earliestRunnable(tree, g, 2 * i + 1, level, runtime, best);
+    return earliestRunnable(tree, g, 2 * i + 2, level, runtime, best);
+}
+
+/*
+ * Function: takeGroupTask
+ *
+ * Takes the next task of group g at a level with processes q and ready
+ * tasks ready as getNextTask takes it from the whole level: the first
+ * ready task of the group, else the first runnable process of the group
+ */
+static Task *takeGroupTask(Group *g, tQueue *ready, int level) {
+    GroupLevel *l = &g->level[level];
+    if (l->readyHead != NULL) {
+        Task *t = l->readyHead->task;
+        removeTask(ready, t);
+        return t;
+    }
+    return g->first != NULL ? takeTask(g->first->process) : NULL;
+}
+
+/*
+ * Function: takeGroupTaskPreemptive
+ *
+ * Takes the next task of group g at a level with processes q and ready
+ * tasks ready as getNextTaskPreemptive takes it from the whole level,
+ * with the group's own nodes in place of the queues' neighbours
+ */
+static Task *takeGroupTaskPreemptive(Group *g, pQueue *q, tQueue *ready, int level, Ticks runtime) {
+    GroupLevel *l = &g->level[level];
+    if (l->readyHead != NULL) {
+        Task *currentTask = l->readyHead->task;
+        tNode *next = l->readyHead->groupNext;
+        if (next == NULL) {
+            removeTask(ready, currentTask);
+            return currentTask;
+        } else if (readyRank(currentTask, ready->aging) < readyRank(next->task, ready->aging)) {
+            requeueTask(ready, currentTask); // back in its place by priority
+            currentTask = l->readyHead->task;
+            removeTask(ready, currentTask);
+            return currentTask;
+        } else {
+            // the task is dropped, as it always has been, so free it
+            removeTask(ready, currentTask);
+            freeTask(currentTask);
+        }
+    }
+
+    for (pNode *current = l->head; current != NULL; current = current->groupNext) {
+        Process *p = current->process;
+        Process *nextProcess = current->groupNext != NULL ? current->groupNext->process : NULL;
+        if (!canRun(p, runtime)) {
+            continue;
+        }
+        if (nextProcess != NULL && canRun(nextProcess, runtime) &&
+            processRank(p, q->aging) >= processRank(nextProcess, q->aging)) {
+            p = nextProcess;
+        }
+        Task *t = takeTask(p);
+        if (t != NULL) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: getNextGroupTask
+ *
+ * Returns the next task to be executed at a level with processes q and
+ * ready tasks ready, taken from the group furthest behind its share.
+ * Within a group the task is chosen as getNextTask, or with preemption
+ * getNextTaskPreemptive, chooses it, over the group's own nodes.
+ */
+Task *getNextGroupTask(GroupTree *tree, pQueue *q, tQueue *ready, Ticks runtime, int preemption) {
+    int level = q->level;
+    if (level < 0) {
+        return NULL;
+    }
+    tree->pick++;
+
+    Group *g = &tree->root;
+    while (g->count > 0) {
+        Group *child = earliestRunnable(tree, g, 0, level, runtime, NULL);
+        if (child == NULL) {
+            return NULL;
+        }
+
+        // a group that sat idle takes up where its siblings are
+        if (child->vtime < g->floor) {
+            child->vtime = g->floor;
+            siftDown(g, child->slot);
+        }
+        g->floor = child->vtime;
+        g = child;
+    }
+
+    Task *t = preemption ? takeGroupTaskPreemptive(g, q, ready, level, runtime)
+                         : takeGroupTask(g, ready, level);
+    if (t != NULL) {
+        t->parent->taskRunning = 1;
+    }
+    return t;
+}
+
+/*
+ * Function: printPath
+ *
+ * Prints the path of group g from the root
+ */
+static void printPath(Group *g) {
+    if (g->parent == NULL) {
+        return;
+    }
+    printPath(g->parent);
+    printf("/%s", g->name);
+}
+
+/*
+ * Function: printGroupStats
+ *
+ * Prints the CPU share and ready time of every group holding completed
+ * processes, in the order the trace named them. The target share is the
+ * group's weight over the weights of its siblings holding completed
+ * processes, through every group above it.
+ */
+void printGroupStats(GroupTree *tree, pQueue *exitQueue) {
+    // the totals are over processes that completed, as printStats gives
+    long *processes = (long *)calloc(tree->count, sizeof(long));
+    Ticks *wait = (Ticks *)calloc(tree->count, sizeof(Ticks));
+    double *target = (double *)calloc(tree->count, sizeof(double));
+    if (processes == NULL || wait == NULL || target == NULL) {
+        free(processes);
+        free(wait);
+        free(target);
+        return;
+    }
+
+    for (pNode *n = exitQueue->head; n != NULL; n = n->next) {
+        Process *p = n->process;
+        for (Group *g = p->group != NULL ? p->group : tree->fallback; g != NULL; g = g->parent) {
+            processes[g->order]++;
+            wait[g->order] += p->ready;
+        }
+    }
+
+    // parents come before their subgroups in creation order
+    target[0] = 1.0;
+    for (Group *g = tree->root.next; g != NULL; g = g->next) {
+        long total = 0;
+        for (Group *s = tree->root.next; s != NULL; s = s->next) {
+            if (s->parent == g->parent && processes[s->order] > 0) {
+                total += s->weight;
+            }
+        }
+        target[g->order] = total > 0 ? target[g->parent->order] * g->weight / total : 0.0;
+    }
+
+    Ticks used = tree->root.cpu > 0 ? tree->root.cpu : 1;
+    for (Group *g = tree->root.next; g != NULL; g = g->next) {
+        if (processes[g->order] == 0) {
+            continue;
+        }
+        printf("G");
+        printPath(g);
+        printf(" weight:%d processes:%ld cpu:%lld share:%.2f%% target:%.2f%% time_waiting:%lld average_waiting:%.2f\n",
+               g->weight, processes[g->order], g->cpu, 100.0 * g->cpu / used, 100.0 * target[g->order],
+               wait[g->order], (double)wait[g->order] / processes[g->order]);
+    }
+
+    free(processes);
+    free(wait);
+    free(target);
+}
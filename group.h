@@ -0,0 +1,93 @@
+/*
+ * group.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for fair-share groups. A trace can
+ * place each process in a group of a hierarchy, as cgroups do, with a
+ * weight for every group. When a trace uses groups, the next task of a
+ * level is taken from the group furthest behind its weighted share of the
+ * CPU at every step down the hierarchy, and within that group as the
+ * engine takes it without groups. The report gives the CPU share and ready
+ * time of each group.
+ */
+
+ #ifndef GROUP_H
+ #define GROUP_H
+
+ #include <stdio.h>
+ #include "Simulation.h"
+ #include "queue.h"
+
+ #ifndef GROUP_WEIGHT
+ #define GROUP_WEIGHT 100 // weight of a group the trace gives none
+ #endif
+
+ #define GROUP_MAX_WEIGHT 10000 // largest weight a trace may give
+ #define GROUP_UNIT (1LL << 24) // virtual time of a tick of CPU at weight 1
+ #define GROUP_PATH 256 // longest group path, including the terminator
+ #define GROUP_SCAN "255" // scanf width for a group path
+
+ struct GroupTree;
+
+ // Struct for the nodes of a group queued at one level of the engine
+ typedef struct GroupLevel {
+     pNode *head;               // first process node of the group, in queue order
+     pNode *tail;               // last process node of the group
+     tNode *readyHead;          // first ready task node of the group, in queue order
+     tNode *readyTail;          // last ready task node of the group
+     long queued;               // nodes of the group and its subgroups at the level
+ } GroupLevel;
+
+ // Struct for one group of the hierarchy
+ typedef struct Group {
+     char *name;                // last component of the path, "" for the root
+     int weight;                // share of the CPU relative to its siblings
+     int weighted;              // 1 once the trace gave the weight
+     int members;               // processes placed directly in the group
+     struct Group *parent;      // enclosing group, NULL for the root
+     struct GroupTree *tree;    // hierarchy the group belongs to
+     struct Group **heap;       // subgroups, a min-heap on virtual time
+     int count;                 // number of subgroups
+     int capacity;              // slots allocated in heap
+     int slot;                  // index in the parent's heap
+     int order;                 // position in creation order, 0 for the root
+     Ticks vtime;               // CPU ticks used, scaled by GROUP_UNIT / weight
+     Ticks floor;               // virtual time of the subgroup last chosen
+     Ticks cpu;                 // CPU ticks used by the group and its subgroups
+     unsigned long mark;        // last pick that checked the group for a runnable task
+     int runnable;              // 1 if it had one in that pick
+     pNode *first;              // first runnable process node of the group in that pick
+     struct Group *next;        // next group in creation order
+     GroupLevel level[MAX_LEVELS]; // nodes of the group queued at each level
+ } Group;
+
+ // Struct for a group hierarchy, shared by the processes placed in it
+ typedef struct GroupTree {
+     Group root;                // the whole CPU
+     Group *fallback;           // group of processes the trace placed in none
+     Group *last;               // group created last
+     int count;                 // number of groups, the root included
+     unsigned long pick;        // number of picks made
+     int refs;                  // number of holders of the hierarchy
+ } GroupTree;
+
+ // function prototypes
+ GroupTree *createGroups();
+ GroupTree *holdGroups(GroupTree *tree);
+ void releaseGroups(GroupTree *tree);
+ int placeProcess(GroupTree *tree, Process *p, const char *path, const char **message);
+ void placeUngrouped(GroupTree *tree, pQueue *q);
+ void placeUngroupedProcess(GroupTree *tree, Process *p);
+ GroupTree *findGroups(pQueue *q);
+ void attachGroupQueue(pQueue *q, int level);
+ void linkGroupProcess(pNode *node);
+ void unlinkGroupProcess(pNode *node);
+ void linkGroupTask(tQueue *q, tNode *node);
+ void unlinkGroupTask(tQueue *q, tNode *node);
+ void chargeGroup(GroupTree *tree, Process *p);
+ Task *getNextGroupTask(GroupTree *tree, pQueue *q, tQueue *ready, Ticks runtime, int preemption);
+ void printGroupStats(GroupTree *tree, pQueue *exitQueue);
+
+ #endif
@@ -0,0 +1,586 @@
+/*
+ * import.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of scheduler trace imports. Only
+ * the tasks alive at a point of the trace are held in a table keyed by
+ * pid, so memory follows the live tasks and the instructions derived so
+ * far, never the number of events. Each process is queued when its task
+ * is first seen, which keeps the queue in arrival order, and its
+ * instructions are built up as a program, one per burst. The engine lets
+ * go of the program as soon as the process has run its last burst, so a
+ * run does not hold the bursts of every task it has finished.
+ *
+ * Time a task spends on a CPU counts towards an execution burst until it
+ * blocks; being preempted (a switch out in state R) only leaves it waiting
+ * for a CPU, which the simulation decides for itself. A blocked task
+ * becomes an I/O burst lasting until it is woken, or until it runs again
+ * if the wake-up was not traced. A task ends when it exits or the trace
+ * ends. Times are converted to ticks at the event boundaries, so rounding
+ * never adds up over many short bursts, and bursts rounding to nothing
+ * merge into their neighbours.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "import.h"
+
+// States of a traced task
+#define TASK_RUNNING 0
+#define TASK_READY 1
+#define TASK_BLOCKED 2
+#define TASK_DEAD 3
+
+// Struct for a traced task being turned into a process
+typedef struct ImportTask {
+    int pid;                   // traced pid, 0 for a free slot
+    int state;                 // TASK_* state
+    long long since;           // time the state began, in nanoseconds
+    Ticks exe;                 // ticks on a CPU since the task last blocked
+    Process *process;          // process the task becomes
+    Program *program;          // instructions so far
+} ImportTask;
+
+// Struct for the tasks alive at a point of the trace
+typedef struct TaskTable {
+    ImportTask *slots;         // open addressing by pid
+    int capacity;              // slots, a power of two
+    int count;                 // slots in use
+} TaskTable;
+
+// Struct for the import in progress
+typedef struct Importer {
+    TaskTable table;           // live tasks
+    pQueue *queue;             // processes in arrival order
+    long long tick;            // nanoseconds per tick
+    long long origin;          // time of the first event
+    long long last;            // time of the latest event
+    int quantumB;              // quantum of the lowest level
+    ImportStats *stats;        // counters
+} Importer;
+
+// Struct for one scheduler event of the trace
+typedef struct SchedEvent {
+    char kind;                 // 's' = switch, 'w' = wakeup, 'x' = exit
+    long long time;            // nanoseconds
+    int pid;                   // woken or exiting task, or the task switched out
+    int prio;                  // its kernel priority
+    char state;                // state the switched out task was left in
+    int next;                  // task switched in
+    int nextPrio;              // its kernel priority
+} SchedEvent;
+
+/*
+ * Function: importFail
+ *
+ * Records a failure at line in err, if given, and returns status
+ */
+static int importFail(ParseError *err, long long line, int status, const char *message) {
+    if (err != NULL) {
+        err->line = (int)line;
+        err->message = message;
+    }
+    return status;
+}
+
+/*
+ * Function: slotOf
+ *
+ * Returns the slot of pid in the table, or the free slot it would take
+ */
+static ImportTask *slotOf(TaskTable *t, int pid) {
+    unsigned int i = ((unsigned int)pid * 2654435761u) & (t->capacity - 1);
+    while (t->slots[i].pid != 0 && t->slots[i].pid != pid) {
+        i = (i + 1) & (t->capacity - 1);
+    }
+    return &t->slots[i];
+}
+
+/*
+ * Function: growTable
+ *
+ * Doubles the slots of the table. Returns 0 on success, -1 if allocation
+ * fails.
+ */
+static int growTable(TaskTable *t) {
+    ImportTask *old = t->slots;
+    int capacity = t->capacity;
+    ImportTask *slots = (ImportTask *)calloc(2 * capacity, sizeof(ImportTask));
+    if (slots == NULL) {
+        return -1;
+    }
+    t->slots = slots;
+    t->capacity = 2 * capacity;
+    for (int i = 0; i < capacity; i++) {
+        if (old[i].pid != 0) {
+            *slotOf(t, old[i].pid) = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+/*
+ * Function: removeSlot
+ *
+ * Frees the slot of a task, moving back the tasks after it that probed
+ * past it so that lookups still find them
+ */
+static void removeSlot(TaskTable *t, ImportTask *task) {
+    unsigned int mask = t->capacity - 1;
+    unsigned int hole = (unsigned int)(task - t->slots);
+    unsigned int i = hole;
+    t->slots[hole].pid = 0;
+    t->count--;
+
+    for (;;) {
+        i = (i + 1) & mask;
+        if (t->slots[i].pid == 0) {
+            return;
+        }
+        unsigned int home = ((unsigned int)t->slots[i].pid * 2654435761u) & mask;
+        // the task may fill the hole unless its home lies between them
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            t->slots[hole] = t->slots[i];
+            t->slots[i].pid = 0;
+            hole = i;
+        }
+    }
+}
+
+/*
+ * Function: ticksAt
+ *
+ * Returns the tick of a trace time
+ */
+static Ticks ticksAt(const Importer *im, long long time) {
+    return (time - im->origin) / im->tick;
+}
+
+/*
+ * Function: addInstruction
+ *
+ * Appends an instruction to a task's program, adding the time to the last
+ * one instead if it is of the same type. Returns 0 on success, -1 if
+ * allocation fails.
+ */
+static int addInstruction(Program *prog, char type, Ticks time) {
+    int last = prog->count - 1;
+    if (last >= 0 && type != 't' && prog->instructions[last].type == type) {
+        return setProgramTime(prog, last, programTime(prog, last) + time);
+    }
+    if (prog->count == prog->capacity && growProgram(prog) != 0) {
+        return -1;
+    }
+    prog->instructions[prog->count].type = type;
+    if (setProgramTime(prog, prog->count, time) != 0) {
+        return -1;
+    }
+    prog->count++;
+    return 0;
+}
+
+/*
+ * Function: endBurst
+ *
+ * Appends the CPU time a task has gathered as an execution burst. Returns
+ * 0 on success, -1 if allocation fails.
+ */
+static int endBurst(ImportTask *task) {
+    Ticks exe = task->exe;
+    task->exe = 0;
+    return exe > 0 ? addInstruction(task->program, 'e', exe) : 0;
+}
+
+/*
+ * Function: addTask
+ *
+ * Starts the process of a task first seen at time. Returns the task, or
+ * NULL if allocation fails.
+ */
+static ImportTask *addTask(Importer *im, int pid, int prio, int state, long long time) {
+    if (2 * (im->table.count + 1) > im->table.capacity && growTable(&im->table) != 0) {
+        return NULL;
+    }
+
+    Process *p = createProcess();
+    Program *prog = createProgram(4);
+    if (p == NULL || prog == NULL || enqueueProcess(im->queue, p) != 0) {
+        freeProcess(p);
+        releaseProgram(prog);
+        return NULL;
+    }
+    p->pid = pid;
+    p->priority = IMPORT_PRIO - prio;
+    p->arrival = ticksAt(im, time);
+    p->quantum = im->quantumB;
+    p->endQueue = "B";
+    prog->count = 0;
+
+    ImportTask *task = slotOf(&im->table, pid);
+    task->pid = pid;
+    task->state = state;
+    task->since = time;
+    task->exe = 0;
+    task->process = p;
+    task->program = prog;
+    im->table.count++;
+    return task;
+}
+
+/*
+ * Function: finishTask
+ *
+ * Completes the process of a task with its terminate and hands it its
+ * program; a task that ran for less than a tick is dropped instead. The
+ * task keeps its slot. Returns 0 on success, -1 if allocation fails.
+ */
+static int finishTask(Importer *im, ImportTask *task) {
+    Program *prog = task->program;
+    int status = endBurst(task);
+    task->program = NULL;
+
+    int ran = 0;
+    for (int i = 0; i < prog->count && !ran; i++) {
+        ran = prog->instructions[i].type == 'e';
+    }
+    if (status != 0 || !ran) {
+        // the process leaves the queue, which holds it nowhere else
+        unlinkProcess(task->process);
+        freeProcess(task->process);
+        releaseProgram(prog);
+        im->stats->idle += status == 0;
+        return status;
+    }
+
+    // trailing I/O would only keep the process from ending
+    if (prog->instructions[prog->count - 1].type == 'i') {
+        prog->count--;
+    }
+    if (addInstruction(prog, 't', 0) != 0) {
+        unlinkProcess(task->process);
+        freeProcess(task->process);
+        releaseProgram(prog);
+        return -1;
+    }
+
+    // the program is complete, so give back what it will not grow into
+    Instruction *instructions = (Instruction *)realloc(prog->instructions, prog->count * sizeof(Instruction));
+    if (instructions != NULL) {
+        prog->instructions = instructions;
+        prog->capacity = prog->count;
+    }
+    attachProgram(task->process, prog);
+    releaseProgram(prog);
+    im->stats->tasks++;
+    return 0;
+}
+
+/*
+ * Function: liveTask
+ *
+ * Returns the task running as pid, ending the one before it if it exited
+ * and its pid has been reused, and starting it in state if it is new.
+ * Returns NULL if allocation fails.
+ */
+static ImportTask *liveTask(Importer *im, int pid, int prio, int state, long long time) {
+    ImportTask *task = slotOf(&im->table, pid);
+    if (task->pid == pid && task->state == TASK_DEAD) {
+        removeSlot(&im->table, task);
+        task = slotOf(&im->table, pid);
+    }
+    return task->pid == pid ? task : addTask(im, pid, prio, state, time);
+}
+
+/*
+ * Function: wakeTask
+ *
+ * Ends the blocked interval of a task at time as an I/O burst
+ */
+static int wakeTask(Importer *im, ImportTask *task, long long time) {
+    if (task->state != TASK_BLOCKED) {
+        return 0;
+    }
+    Ticks io = ticksAt(im, time) - ticksAt(im, task->since);
+    task->state = TASK_READY;
+    task->since = time;
+    if (io > 0) {
+        // nothing ran in between, so the burst before it is complete
+        if (endBurst(task) != 0) return -1;
+        return addInstruction(task->program, 'i', io);
+    }
+    return 0;
+}
+
+/*
+ * Function: applyEvent
+ *
+ * Updates the tasks an event concerns. Returns 0 on success, -1 if
+ * allocation fails.
+ */
+static int applyEvent(Importer *im, const SchedEvent *ev) {
+    ImportTask *task;
+
+    if (ev->kind == 's') {
+        if (ev->pid != 0) {
+            task = slotOf(&im->table, ev->pid);
+            if (task->pid == ev->pid && task->state == TASK_DEAD) {
+                // the last switch away from a task that has exited
+                removeSlot(&im->table, task);
+            } else {
+                if ((task = liveTask(im, ev->pid, ev->prio, TASK_RUNNING, ev->time)) == NULL) return -1;
+                if (task->state == TASK_RUNNING) {
+                    task->exe += ticksAt(im, ev->time) - ticksAt(im, task->since);
+                }
+                task->since = ev->time;
+                task->state = ev->state == 'R' ? TASK_READY : TASK_BLOCKED;
+            }
+        }
+        if (ev->next != 0) {
+            if ((task = liveTask(im, ev->next, ev->nextPrio, TASK_READY, ev->time)) == NULL) return -1;
+            if (wakeTask(im, task, ev->time) != 0) return -1;
+            task->state = TASK_RUNNING;
+            task->since = ev->time;
+        }
+        return 0;
+    }
+
+    if (ev->kind == 'w') {
+        if ((task = liveTask(im, ev->pid, ev->prio, TASK_READY, ev->time)) == NULL) return -1;
+        return wakeTask(im, task, ev->time);
+    }
+
+    // an exiting task still runs until it is switched away from
+    task = slotOf(&im->table, ev->pid);
+    if (task->pid != ev->pid || task->state == TASK_DEAD) {
+        return 0;
+    }
+    if (task->state == TASK_RUNNING) {
+        task->exe += ticksAt(im, ev->time) - ticksAt(im, task->since);
+    }
+    task->state = TASK_DEAD;
+    return finishTask(im, task);
+}
+
+/*
+ * Function: readTime
+ *
+ * Reads the timestamp ending just before end, in seconds with a fraction
+ * as both tracers print it, into nanoseconds. Returns 0 on success, -1 if
+ * there is none.
+ */
+static int readTime(const char *line, const char *end, long long *time) {
+    // the timestamp is followed by a colon, and perf may put the event's subsystem after it
+    if (end - line >= 6 && strncmp(end - 6, "sched:", 6) == 0) end -= 6;
+    while (end > line && end[-1] == ' ') end--;
+    if (end == line || end[-1] != ':') return -1;
+    end--;
+
+    const char *start = end;
+    while (start > line && (isdigit((unsigned char)start[-1]) || start[-1] == '.')) start--;
+    long long seconds = 0, fraction = 0;
+    int digits = 0, point = 0;
+    for (const char *c = start; c < end; c++) {
+        if (*c == '.') {
+            if (point++) return -1;
+        } else if (!point) {
+            seconds = seconds * 10 + (*c - '0');
+        } else if (digits < 9) {
+            fraction = fraction * 10 + (*c - '0');
+            digits++;
+        }
+    }
+    if (start == end || !point) return -1;
+    for (; digits < 9; digits++) fraction *= 10;
+    *time = seconds * 1000000000LL + fraction;
+    return 0;
+}
+
+/*
+ * Function: readField
+ *
+ * Reads the integer after key in text. Returns 0 on success, -1 if the key
+ * is missing.
+ */
+static int readField(const char *text, const char *key, int *value) {
+    const char *at = strstr(text, key);
+    if (at == NULL) return -1;
+    *value = atoi(at + strlen(key));
+    return 0;
+}
+
+/*
+ * Function: readTaskRef
+ *
+ * Reads a task written as comm:pid [prio], the form newer perf versions
+ * print, from text up to end. Returns a pointer past the closing bracket,
+ * or NULL if there is none.
+ */
+static const char *readTaskRef(const char *text, const char *end, int *pid, int *prio) {
+    const char *open = NULL;
+    for (const char *c = text; c < end; c++) {
+        if (*c == '[') open = c;
+    }
+    if (open == NULL) return NULL;
+
+    const char *c = open;
+    while (c > text && c[-1] == ' ') c--;
+    const char *digits = c;
+    while (digits > text && isdigit((unsigned char)digits[-1])) digits--;
+    if (digits == c || digits == text || digits[-1] != ':') return NULL;
+    *pid = atoi(digits);
+    *prio = atoi(open + 1);
+    const char *close = strchr(open, ']');
+    return close != NULL && close < end ? close + 1 : NULL;
+}
+
+/*
+ * Function: readEvent
+ *
+ * Reads a scheduler event from a line of either tracer's output. Returns
+ * 1 if the line holds one, 0 if it holds no event of interest, -1 if it
+ * holds one that cannot be read.
+ */
+static int readEvent(const char *line, SchedEvent *ev) {
+    const char *at, *fields;
+    memset(ev, 0, sizeof(SchedEvent));
+
+    if ((at = strstr(line, "sched_switch:")) != NULL) {
+        ev->kind = 's';
+        fields = at + strlen("sched_switch:");
+    } else if ((at = strstr(line, "sched_wakeup_new:")) != NULL) {
+        ev->kind = 'w';
+        fields = at + strlen("sched_wakeup_new:");
+    } else if ((at = strstr(line, "sched_wakeup:")) != NULL || (at = strstr(line, "sched_waking:")) != NULL) {
+        // both names are the same length
+        ev->kind = 'w';
+        fields = at + strlen("sched_wakeup:");
+    } else if ((at = strstr(line, "sched_process_exit:")) != NULL) {
+        ev->kind = 'x';
+        fields = at + strlen("sched_process_exit:");
+    } else {
+        return 0;
+    }
+    if (readTime(line, at, &ev->time) != 0) {
+        return -1;
+    }
+
+    if (ev->kind == 's') {
+        const char *state = strstr(fields, "prev_state=");
+        if (state != NULL) {
+            // ftrace and older perf print key=value pairs
+            ev->state = state[strlen("prev_state=")];
+            return readField(fields, "prev_pid=", &ev->pid) == 0 && readField(fields, "prev_prio=", &ev->prio) == 0 &&
+                   readField(fields, "next_pid=", &ev->next) == 0 && readField(fields, "next_prio=", &ev->nextPrio) == 0 ? 1 : -1;
+        }
+        const char *arrow = strstr(fields, "==>");
+        if (arrow == NULL) return -1;
+        const char *after = readTaskRef(fields, arrow, &ev->pid, &ev->prio);
+        if (after == NULL || readTaskRef(arrow, arrow + strlen(arrow), &ev->next, &ev->nextPrio) == NULL) return -1;
+        while (*after == ' ') after++;
+        ev->state = *after;
+        return 1;
+    }
+
+    if (readField(fields, " pid=", &ev->pid) == 0) {
+        return readField(fields, " prio=", &ev->prio) == 0 ? 1 : -1;
+    }
+    return readTaskRef(fields, fields + strlen(fields), &ev->pid, &ev->prio) != NULL ? 1 : -1;
+}
+
+/*
+ * Function: importSchedTrace
+ *
+ * Reads a perf sched script or ftrace text dump from file and queues a
+ * process for every task that ran, in arrival order, timing it in ticks
+ * of the given nanoseconds. Lines without scheduler events are skipped.
+ * Returns a parser status code.
+ */
+int importSchedTrace(FILE *file, long long tick, int quantumB, pQueue *q, ImportStats *stats, ParseError *err) {
+    Importer im;
+    memset(&im, 0, sizeof(Importer));
+    memset(stats, 0, sizeof(ImportStats));
+    im.queue = q;
+    im.tick = tick;
+    im.quantumB = quantumB;
+    im.stats = stats;
+    im.table.capacity = 1024;
+    im.table.slots = (ImportTask *)calloc(im.table.capacity, sizeof(ImportTask));
+    if (im.table.slots == NULL) {
+        return importFail(err, 0, PARSE_NOMEM, "Memory allocation failed");
+    }
+
+    char *line = NULL;
+    size_t size = 0;
+    int status = PARSE_OK;
+    SchedEvent ev;
+    while (status == PARSE_OK && getline(&line, &size, file) > 0) {
+        stats->lines++;
+        int found = readEvent(line, &ev);
+        if (found < 0) {
+            stats->skipped++;
+            continue;
+        }
+        if (found == 0) {
+            continue;
+        }
+
+        // events are printed in time order, up to the odd tie broken across CPUs
+        if (stats->events == 0) {
+            im.origin = im.last = ev.time;
+        } else if (ev.time < im.last) {
+            ev.time = im.last;
+        }
+        im.last = ev.time;
+        stats->events++;
+
+        if (applyEvent(&im, &ev) != 0) {
+            status = importFail(err, stats->lines, PARSE_NOMEM, "Memory allocation failed");
+        }
+    }
+    free(line);
+    if (status == PARSE_OK && ferror(file)) {
+        status = importFail(err, stats->lines, PARSE_ERROR, "Error reading trace");
+    }
+
+    // tasks still alive end with the trace
+    for (int i = 0; i < im.table.capacity; i++) {
+        ImportTask *task = &im.table.slots[i];
+        if (task->pid == 0 || task->state == TASK_DEAD) continue;
+        if (task->state == TASK_RUNNING) {
+            task->exe += ticksAt(&im, im.last) - ticksAt(&im, task->since);
+        }
+        if (finishTask(&im, task) != 0 && status == PARSE_OK) {
+            status = importFail(err, stats->lines, PARSE_NOMEM, "Memory allocation failed");
+        }
+    }
+    free(im.table.slots);
+    return status;
+}
+
+/*
+ * Function: writeImportedTrace
+ *
+ * Writes imported processes to out in the trace format, so that later
+ * runs can parse them without importing again. Returns 0 on success, -1
+ * if writing fails.
+ */
+int writeImportedTrace(FILE *out, pQueue *q) {
+    for (pNode *n = q->head; n != NULL; n = n->next) {
+        Process *p = n->process;
+        fprintf(out, "P%d:%d\narrival_t:%lld\n", p->pid, p->priority, p->arrival);
+        for (int i = 0; p->program != NULL && i < p->program->count; i++) {
+            char type = p->program->instructions[i].type;
+            if (type == 't') {
+                fprintf(out, "terminate\n");
+            } else {
+                fprintf(out, "%s:%lld\n", type == 'e' ? "exe" : "io", programTime(p->program, i));
+            }
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * import.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for importing Linux scheduler traces.
+ * The text output of `perf sched script` or of ftrace with the sched_switch
+ * and sched_wakeup events is read a line at a time, and each task becomes a
+ * process whose CPU bursts and blocked intervals are the ones it had on the
+ * traced host.
+ */
+
+ #ifndef IMPORT_H
+ #define IMPORT_H
+
+ #include <stdio.h>
+ #include "parser.h"
+
+ #ifndef IMPORT_TICK
+ #define IMPORT_TICK 1000 // default microseconds per simulated tick
+ #endif
+
+ #define IMPORT_PRIO 139 // a kernel priority k becomes IMPORT_PRIO - k, so that lower k ranks higher
+
+ // Struct for what an import read
+ typedef struct ImportStats {
+     long long lines;           // lines read
+     long long events;          // scheduler events used
+     long long skipped;         // scheduler event lines that could not be read
+     long tasks;                // tasks turned into processes
+     long idle;                 // tasks dropped for running less than a tick
+ } ImportStats;
+
+ // function prototypes
+ int importSchedTrace(FILE *file, long long tick, int quantumB, pQueue *q, ImportStats *stats, ParseError *err);
+ int writeImportedTrace(FILE *out, pQueue *q);
+
+ #endif
@@ -0,0 +1,491 @@
+/*
+ * index.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of trace indexes. Indexing scans
+ * the trace a line at a time, without creating any processes, and notes
+ * where each block of process records and each template definition
+ * starts and ends, with the extremes of the pids and arrivals in every
+ * block. The index is stored next to the trace as <trace>.idx with the
+ * size and modification time it was built for, and is rebuilt when they
+ * change.
+ *
+ * A ranged run parses every template definition that comes before the
+ * last block it needs, then only the blocks that may hold a process in
+ * the range, and finally drops the processes of those blocks that fall
+ * outside it. Processes keep their own arrival times, so a replay starts
+ * where the range starts.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "index.h"
+
+// Struct for the fixed part of an index file
+typedef struct IndexHeader {
+    char magic[8];             // INDEX_MAGIC, without the terminator
+    long long size;            // size of the trace when indexed
+    long long seconds;         // modification time of the trace, seconds
+    long long nanoseconds;     // and nanoseconds
+    int count;                 // number of blocks that follow the templates
+    int numTemplates;          // number of template spans that follow the header
+} IndexHeader;
+
+/*
+ * Function: initTraceRange
+ *
+ * Sets a range that replays every process
+ */
+void initTraceRange(TraceRange *range) {
+    range->fromArrival = LLONG_MIN;
+    range->toArrival = LLONG_MAX;
+    range->fromPid = INT_MIN;
+    range->toPid = INT_MAX;
+}
+
+/*
+ * Function: isFullRange
+ *
+ * Returns 1 if the range replays every process, 0 otherwise
+ */
+int isFullRange(const TraceRange *range) {
+    return range->fromArrival == LLONG_MIN && range->toArrival == LLONG_MAX &&
+           range->fromPid == INT_MIN && range->toPid == INT_MAX;
+}
+
+/*
+ * Function: addRecord
+ *
+ * Adds a record making count processes, the first with the given pid and
+ * arrival and each further one a pid and a stride after the one before,
+ * to the open block, or opens a block for it
+ */
+static void addRecord(IndexBlock *block, long long start, long long end, int line, int pid, Ticks arrival, int count, Ticks stride) {
+    int lastPid = pid + count - 1;
+    Ticks lastArrival = arrival + (count - 1) * stride;
+    if (block->records == 0) {
+        block->start = start;
+        block->line = line;
+        block->minPid = pid;
+        block->maxPid = lastPid;
+        block->minArrival = arrival;
+        block->maxArrival = lastArrival;
+    }
+    block->end = end;
+    block->minPid = pid < block->minPid ? pid : block->minPid;
+    block->maxPid = lastPid > block->maxPid ? lastPid : block->maxPid;
+    block->minArrival = arrival < block->minArrival ? arrival : block->minArrival;
+    block->maxArrival = lastArrival > block->maxArrival ? lastArrival : block->maxArrival;
+    block->records++;
+}
+
+/*
+ * Function: closeBlock
+ *
+ * Appends the open block, if it has any records, to the index and starts
+ * a new one. Returns 0 on success, -1 if the index cannot grow.
+ */
+static int closeBlock(TraceIndex *index, int *capacity, IndexBlock *block) {
+    if (block->records == 0) {
+        return 0;
+    }
+    if (index->count == *capacity) {
+        int grown = *capacity ? 2 * *capacity : 256;
+        IndexBlock *blocks = (IndexBlock *)realloc(index->blocks, grown * sizeof(IndexBlock));
+        if (blocks == NULL) {
+            return -1;
+        }
+        index->blocks = blocks;
+        *capacity = grown;
+    }
+    index->blocks[index->count++] = *block;
+    memset(block, 0, sizeof(IndexBlock));
+    return 0;
+}
+
+/*
+ * Function: addTemplate
+ *
+ * Appends a template span to the index. Returns 0 on success, -1 if the
+ * index cannot grow.
+ */
+static int addTemplate(TraceIndex *index, int *capacity, const ParseSpan *span) {
+    if (index->numTemplates == *capacity) {
+        int grown = *capacity ? 2 * *capacity : 16;
+        ParseSpan *templates = (ParseSpan *)realloc(index->templates, grown * sizeof(ParseSpan));
+        if (templates == NULL) {
+            return -1;
+        }
+        index->templates = templates;
+        *capacity = grown;
+    }
+    index->templates[index->numTemplates++] = *span;
+    return 0;
+}
+
+/*
+ * Function: readUse
+ *
+ * Reads the instance count and stride of a use line
+ */
+static void readUse(const char *text, int *instances, Ticks *stride) {
+    const char *rest = strpbrk(text, " \t");
+    int n;
+    Ticks s;
+    *instances = 1;
+    *stride = 0;
+    while (rest != NULL) {
+        rest += strspn(rest, " \t\r\n");
+        if (sscanf(rest, "x%d", &n) == 1 && n > 0) {
+            *instances = n;
+        } else if (sscanf(rest, "stride:%lld", &s) == 1 && s >= 0) {
+            *stride = s;
+        }
+        rest = strpbrk(rest, " \t");
+    }
+}
+
+/*
+ * Function: buildTraceIndex
+ *
+ * Indexes the trace open as file, whose status is st, following the same
+ * rules as the parser: a process record is closed by its terminate or use
+ * line, or by the end of the file, and is dropped if another P line comes
+ * first. Lines between the records of a block are parsed with it, just as
+ * a full parse would. Returns 0 on success, -1 if the trace is malformed (the parser
+ * then reports where) or memory runs out.
+ */
+int buildTraceIndex(FILE *file, const struct stat *st, TraceIndex *index) {
+    memset(index, 0, sizeof(TraceIndex));
+    index->size = st->st_size;
+    index->mtime = st->st_mtim;
+    if (fseeko(file, 0, SEEK_SET) != 0) {
+        return -1;
+    }
+
+    int capacity = 0, templateCapacity = 0;
+    IndexBlock block;
+    ParseSpan definition;
+    memset(&block, 0, sizeof(block));
+
+    // the record being read
+    long long start = 0;
+    int startLine = 0, pid = 0;
+    Ticks arrival = 0;
+
+    int inRecord = 0, inTemplate = 0, failed = 0;
+    long long offset = 0;
+    int line = 1;
+    char *text = NULL;
+    size_t size = 0;
+    ssize_t length;
+
+    while (!failed && (length = getline(&text, &size, file)) > 0) {
+        long long next = offset + length;
+        int instances;
+        Ticks stride;
+        switch (text[0]) {
+            case 'P':
+                failed = inTemplate || sscanf(text, "P%d:%*d", &pid) != 1;
+                start = offset;
+                startLine = line;
+                arrival = 0;
+                inRecord = 1;
+                break;
+            case 'a':
+                failed = !inRecord;
+                if (!failed) {
+                    sscanf(text, "arrival_t:%lld", &arrival);
+                }
+                break;
+            case 'e':
+            case 'i':
+                failed = !inRecord && !inTemplate;
+                break;
+            case 'j':
+                // blocks never hold a template, which is parsed on its own
+                failed = inRecord || inTemplate || closeBlock(index, &capacity, &block) != 0;
+                definition.start = offset;
+                definition.line = line;
+                inTemplate = 1;
+                break;
+            case 't':
+                if (inTemplate) {
+                    definition.end = next;
+                    failed = addTemplate(index, &templateCapacity, &definition) != 0;
+                    inTemplate = 0;
+                } else if (inRecord) {
+                    addRecord(&block, start, next, startLine, pid, arrival, 1, 0);
+                    inRecord = 0;
+                } else {
+                    failed = 1;
+                }
+                break;
+            case 'u':
+                failed = !inRecord;
+                if (!failed) {
+                    readUse(text, &instances, &stride);
+                    addRecord(&block, start, next, startLine, pid, arrival, instances, stride);
+                    inRecord = 0;
+                }
+                break;
+        }
+        if (!failed && block.records == INDEX_BLOCK) {
+            failed = closeBlock(index, &capacity, &block) != 0;
+        }
+        offset = next;
+        line++;
+    }
+    free(text);
+
+    // an unterminated process at the end of the file still runs
+    if (!failed && inRecord) {
+        addRecord(&block, start, offset, startLine, pid, arrival, 1, 0);
+    }
+    if (!failed) {
+        failed = closeBlock(index, &capacity, &block) != 0;
+    }
+    if (failed || inTemplate || ferror(file)) {
+        freeTraceIndex(index);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: readIndex
+ *
+ * Reads the index file at path into index if it was built for a trace of
+ * the given status. Returns 0 on success, -1 if it is missing, stale or
+ * damaged.
+ */
+static int readIndex(const char *path, const struct stat *st, TraceIndex *index) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        return -1;
+    }
+
+    IndexHeader header;
+    memset(index, 0, sizeof(TraceIndex));
+    int ok = fread(&header, sizeof(header), 1, in) == 1 &&
+             memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+             header.size == (long long)st->st_size &&
+             header.seconds == (long long)st->st_mtim.tv_sec &&
+             header.nanoseconds == (long long)st->st_mtim.tv_nsec &&
+             header.count >= 0 && header.numTemplates >= 0;
+    if (ok) {
+        index->size = header.size;
+        index->mtime = st->st_mtim;
+        index->count = header.count;
+        index->numTemplates = header.numTemplates;
+        index->blocks = (IndexBlock *)malloc((header.count + 1) * sizeof(IndexBlock));
+        index->templates = (ParseSpan *)malloc((header.numTemplates + 1) * sizeof(ParseSpan));
+        ok = index->blocks != NULL && index->templates != NULL &&
+             fread(index->templates, sizeof(ParseSpan), header.numTemplates, in) == (size_t)header.numTemplates &&
+             fread(index->blocks, sizeof(IndexBlock), header.count, in) == (size_t)header.count;
+    }
+    fclose(in);
+
+    // every span must lie within the trace
+    for (int i = 0; ok && i < index->count; i++) {
+        ok = index->blocks[i].start >= 0 && index->blocks[i].start <= index->blocks[i].end && index->blocks[i].end <= index->size;
+    }
+    for (int i = 0; ok && i < index->numTemplates; i++) {
+        ok = index->templates[i].start >= 0 && index->templates[i].start <= index->templates[i].end && index->templates[i].end <= index->size;
+    }
+    if (!ok) {
+        freeTraceIndex(index);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: writeIndex
+ *
+ * Stores index at path, through a temporary file renamed into place so
+ * that a concurrent run never reads half an index. Returns 0 on success,
+ * -1 on failure.
+ */
+static int writeIndex(const char *path, const TraceIndex *index) {
+    char temp[4096];
+    if (snprintf(temp, sizeof(temp), "%s.XXXXXX", path) >= (int)sizeof(temp)) {
+        return -1;
+    }
+    int fd = mkstemp(temp);
+    if (fd < 0) {
+        return -1;
+    }
+    FILE *out = fdopen(fd, "wb");
+    if (out == NULL) {
+        close(fd);
+        unlink(temp);
+        return -1;
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.size = index->size;
+    header.seconds = index->mtime.tv_sec;
+    header.nanoseconds = index->mtime.tv_nsec;
+    header.count = index->count;
+    header.numTemplates = index->numTemplates;
+    int ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+             fwrite(index->templates, sizeof(ParseSpan), index->numTemplates, out) == (size_t)index->numTemplates &&
+             fwrite(index->blocks, sizeof(IndexBlock), index->count, out) == (size_t)index->count;
+    fchmod(fd, 0644);
+    if (fclose(out) != 0 || !ok || rename(temp, path) != 0) {
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: openTraceIndex
+ *
+ * Loads the index of the trace at path, open as file, building and
+ * storing it first if it is missing or stale. An index that cannot be
+ * stored is still used. Returns 0 on success, -1 if the trace cannot be
+ * indexed.
+ */
+int openTraceIndex(const char *path, FILE *file, TraceIndex *index) {
+    struct stat st;
+    char name[4096];
+    if (fstat(fileno(file), &st) != 0 || !S_ISREG(st.st_mode) ||
+        snprintf(name, sizeof(name), "%s%s", path, INDEX_SUFFIX) >= (int)sizeof(name)) {
+        return -1;
+    }
+    if (readIndex(name, &st, index) == 0) {
+        return 0;
+    }
+    if (buildTraceIndex(file, &st, index) != 0) {
+        return -1;
+    }
+    writeIndex(name, index);
+    return 0;
+}
+
+/*
+ * Function: freeTraceIndex
+ *
+ * Frees the blocks and templates of an index
+ */
+void freeTraceIndex(TraceIndex *index) {
+    free(index->blocks);
+    free(index->templates);
+    index->blocks = NULL;
+    index->templates = NULL;
+    index->count = 0;
+    index->numTemplates = 0;
+}
+
+/*
+ * Function: addSpan
+ *
+ * Appends a byte range to spans, joining it to the last one when they
+ * touch
+ */
+static void addSpan(ParseSpan *spans, int *count, long long start, long long end, int line) {
+    if (*count > 0 && spans[*count - 1].end == start) {
+        spans[*count - 1].end = end;
+        return;
+    }
+    spans[*count].start = start;
+    spans[*count].end = end;
+    spans[*count].line = line;
+    (*count)++;
+}
+
+/*
+ * Function: keepSelected
+ *
+ * Moves the processes of from that lie in the range to q and frees the
+ * rest. Returns a parser status code.
+ */
+static int keepSelected(pQueue *from, const TraceRange *range, pQueue *q, ParseError *err) {
+    int status = PARSE_OK;
+    Process *p;
+    while ((p = dequeueProcess(from)) != NULL) {
+        if (status == PARSE_OK && p->arrival >= range->fromArrival && p->arrival <= range->toArrival &&
+            p->pid >= range->fromPid && p->pid <= range->toPid) {
+            if (enqueueProcess(q, p) == 0) {
+                continue;
+            }
+            if (err != NULL) {
+                err->line = 0;
+                err->message = "Memory allocation failed";
+            }
+            status = PARSE_NOMEM;
+        }
+        freeProcess(p);
+    }
+    return status;
+}
+
+/*
+ * Function: parseTraceRange
+ *
+ * Parses the processes of the trace at path, open as file, that lie in
+ * the range into q, in file order. With an index only the blocks that
+ * may hold them are read; a trace that cannot be indexed is parsed whole.
+ * Returns a parser status code.
+ */
+int parseTraceRange(const char *path, FILE *file, const TraceRange *range, int quantumB, pQueue *q, ParseError *err) {
+    pQueue *parsed = createProcessQueue();
+    if (parsed == NULL) {
+        if (err != NULL) {
+            err->line = 0;
+            err->message = "Memory allocation failed";
+        }
+        return PARSE_NOMEM;
+    }
+
+    int status;
+    TraceIndex index;
+    if (openTraceIndex(path, file, &index) != 0) {
+        // a malformed trace fails here with the parser's own error
+        rewind(file);
+        status = parseProcesses(file, quantumB, parsed, err);
+    } else {
+        ParseSpan *spans = (ParseSpan *)malloc((index.count + index.numTemplates + 1) * sizeof(ParseSpan));
+        int count = 0, next = 0;
+        status = spans != NULL ? PARSE_OK : PARSE_NOMEM;
+        for (int i = 0; spans != NULL && i < index.count; i++) {
+            IndexBlock *b = &index.blocks[i];
+            if (b->minArrival > range->toArrival || b->maxArrival < range->fromArrival ||
+                b->minPid > range->toPid || b->maxPid < range->fromPid) {
+                continue;
+            }
+            // the templates defined before a block may be used by it
+            for (; next < index.numTemplates && index.templates[next].start < b->start; next++) {
+                addSpan(spans, &count, index.templates[next].start, index.templates[next].end, index.templates[next].line);
+            }
+            addSpan(spans, &count, b->start, b->end, b->line);
+        }
+        if (status == PARSE_OK) {
+            status = parseSpans(file, spans, count, quantumB, parsed, err);
+        } else if (err != NULL) {
+            err->line = 0;
+            err->message = "Memory allocation failed";
+        }
+        free(spans);
+        freeTraceIndex(&index);
+    }
+
+    if (status == PARSE_OK) {
+        status = keepSelected(parsed, range, q, err);
+    }
+    Process *p;
+    while ((p = dequeueProcess(parsed)) != NULL) {
+        freeProcess(p);
+    }
+    freeProcessQueue(parsed);
+    return status;
+}
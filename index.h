@@ -0,0 +1,66 @@
+/*
+ * index.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for trace indexes: a sidecar file,
+ * built once per trace, mapping blocks of process records to their byte
+ * ranges, pids and arrival times, so that a range of processes can be
+ * replayed by parsing only the blocks that hold them.
+ */
+
+ #ifndef INDEX_H
+ #define INDEX_H
+
+ #include <stdio.h>
+ #include <sys/stat.h>
+ #include "parser.h"
+
+ #define INDEX_SUFFIX ".idx" // appended to the trace path to name its index
+ #define INDEX_MAGIC "MLFQIDX1" // first bytes of an index file, with the format version
+
+ #ifndef INDEX_BLOCK
+ #define INDEX_BLOCK 64 // process records per index entry
+ #endif
+
+ // Struct for a block of consecutive process records, each a P line
+ // through its terminate or use line
+ typedef struct IndexBlock {
+     long long start;           // offset of the first P line
+     long long end;             // offset just past the last record
+     Ticks minArrival;          // earliest arrival of a process of the block
+     Ticks maxArrival;          // latest arrival
+     int minPid;                // lowest pid
+     int maxPid;                // highest pid
+     int line;                  // line number of the first P line
+     int records;               // records in the block
+ } IndexBlock;
+
+ // Struct for the index of a trace
+ typedef struct TraceIndex {
+     long long size;            // size of the trace when indexed
+     struct timespec mtime;     // modification time of the trace when indexed
+     IndexBlock *blocks;        // blocks in file order, none holding a template definition
+     int count;                 // number of blocks
+     ParseSpan *templates;      // template definitions in file order
+     int numTemplates;          // number of template definitions
+ } TraceIndex;
+
+ // Struct for the processes a ranged run replays; bounds are inclusive
+ typedef struct TraceRange {
+     Ticks fromArrival;         // earliest arrival replayed
+     Ticks toArrival;           // latest arrival replayed
+     int fromPid;               // lowest pid replayed
+     int toPid;                 // highest pid replayed
+ } TraceRange;
+
+ // function prototypes
+ void initTraceRange(TraceRange *range);
+ int isFullRange(const TraceRange *range);
+ int buildTraceIndex(FILE *file, const struct stat *st, TraceIndex *index);
+ int openTraceIndex(const char *path, FILE *file, TraceIndex *index);
+ void freeTraceIndex(TraceIndex *index);
+ int parseTraceRange(const char *path, FILE *file, const TraceRange *range, int quantumB, pQueue *q, ParseError *err);
+
+ #endif
@@ -10,125 +10,579 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "parser.h"
+#include "group.h"
 
+// Struct for a named instruction template
+typedef struct Template {
+    char name[TEMPLATE_NAME];  // name given by the job line
+    Program *program;          // instructions of the template
+} Template;
 
-// file parser function
-pQueue *ParseFile(FILE* file, int quantumB) {
+// Struct for the templates of one parse
+typedef struct Templates {
+    Template *items;           // templates in definition order
+    int count;                 // number of templates
+    int capacity;              // capacity of items
+    int open;                  // 1 while the last template is being defined
+    GroupTree *groups;         // fair-share groups named so far, NULL until the first
+} Templates;
+
+/*
+ * Function: parseFail
+ *
+ * Records a parse failure and returns its status code
+ */
+static int parseFail(ParseError *err, int line, int status, const char *message) {
+    if (err != NULL) {
+        err->line = line;
+        err->message = message;
+    }
+    return status;
+}
+
+/*
+ * Function: readFailure
+ *
+ * Reports a parse of file that failed because the file could not be read,
+ * such as a damaged compressed trace, as a read error rather than as the
+ * record it cut short. Returns the parser status code.
+ */
+static int readFailure(FILE *file, int status, ParseError *err) {
+    if (status == PARSE_ERROR && ferror(file)) {
+        return parseFail(err, err != NULL ? err->line : 0, PARSE_ERROR, "Error reading trace");
+    }
+    return status;
+}
+
+/*
+ * Function: addParsedTask
+ *
+ * Creates a task of the given type for process p and reads its time
+ * using format (if any). Returns a parser status code.
+ */
+static int addParsedTask(FILE *file, Process *p, char type, const char *format, int line, ParseError *err, const char *message) {
+    if (p == NULL) {
+        return parseFail(err, line, PARSE_ERROR, "Instruction outside of a process");
+    }
+
+    // create task
+    Task *t = createTask();
+    if (t == NULL) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+    t->type = type;
+
+    // assign task time
+    if (format != NULL && fscanf(file, format, &(t->time)) != 1) {
+        freeTask(t);
+        return parseFail(err, line, PARSE_ERROR, message);
+    }
 
-    // create process and task pointers
+    // assign parent process
+    t->parent = p;
+
+    // add task to process
+    if (enqueueTask(p->tasks, t) != 0) {
+        freeTask(t);
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+
+    return PARSE_OK;
+}
+
+/*
+ * Function: beginTemplate
+ *
+ * Starts the definition of a template named on a job line. Returns a
+ * parser status code.
+ */
+static int beginTemplate(FILE *file, Templates *tpl, int line, ParseError *err) {
+    char name[TEMPLATE_NAME];
+    if (fscanf(file, "job:%" TEMPLATE_SCAN "s", name) != 1) {
+        return parseFail(err, line, PARSE_ERROR, "Error reading template name");
+    }
+    for (int i = 0; i < tpl->count; i++) {
+        if (strcmp(tpl->items[i].name, name) == 0) {
+            return parseFail(err, line, PARSE_ERROR, "Duplicate template");
+        }
+    }
+
+    if (tpl->count == tpl->capacity) {
+        int capacity = tpl->capacity ? 2 * tpl->capacity : 8;
+        Template *items = (Template *)realloc(tpl->items, capacity * sizeof(Template));
+        if (items == NULL) {
+            return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+        }
+        tpl->items = items;
+        tpl->capacity = capacity;
+    }
+
+    Template *t = &tpl->items[tpl->count];
+    if ((t->program = createProgram(8)) == NULL) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+    t->program->count = 0;
+    strcpy(t->name, name);
+    tpl->count++;
+    tpl->open = 1;
+    return PARSE_OK;
+}
+
+/*
+ * Function: addTemplateInstruction
+ *
+ * Appends an instruction of the given type to the template being
+ * defined, reading its time using format (if any). A terminate
+ * instruction completes the template. Returns a parser status code.
+ */
+static int addTemplateInstruction(FILE *file, Templates *tpl, char type, const char *format, int line, ParseError *err, const char *message) {
+    Program *prog = tpl->items[tpl->count - 1].program;
+
+    if (prog->count == prog->capacity && growProgram(prog) != 0) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+
+    Ticks time = 0;
+    if (format != NULL && fscanf(file, format, &time) != 1) {
+        return parseFail(err, line, PARSE_ERROR, message);
+    }
+    prog->instructions[prog->count].type = type;
+    if (setProgramTime(prog, prog->count, time) != 0) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+    prog->count++;
+
+    if (type == 't') {
+        tpl->open = 0;
+    }
+    return PARSE_OK;
+}
+
+/*
+ * Function: addParsedGroup
+ *
+ * Reads a group line and places process p in the group it names, creating
+ * the hierarchy of the parse on its first group. Returns a parser status
+ * code.
+ */
+static int addParsedGroup(FILE *file, Process *p, Templates *tpl, int line, ParseError *err) {
+    char path[GROUP_PATH];
+    const char *message = NULL;
+
+    if (p == NULL) {
+        return parseFail(err, line, PARSE_ERROR, "Group outside of a process");
+    }
+    if (fscanf(file, "group:%" GROUP_SCAN "s", path) != 1) {
+        return parseFail(err, line, PARSE_ERROR, "Error reading group");
+    }
+    if (tpl->groups == NULL && (tpl->groups = createGroups()) == NULL) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+
+    int status = placeProcess(tpl->groups, p, path, &message);
+    return status == PARSE_OK ? PARSE_OK : parseFail(err, line, status, message);
+}
+
+/*
+ * Function: instanceTemplate
+ *
+ * Reads a use line and queues process p, running the named template,
+ * followed by any further instances the line asks for. Instance k gets
+ * pid p->pid + k and arrives k * stride after p. The rest of the line is
+ * consumed. Returns a parser status code; p is owned by q on success and
+ * left to the caller otherwise.
+ */
+static int instanceTemplate(FILE *file, Process *p, Templates *tpl, pQueue *q, int line, ParseError *err) {
+    char name[TEMPLATE_NAME];
+    char rest[256];
+    int c, len = 0;
+
+    if (p == NULL) {
+        return parseFail(err, line, PARSE_ERROR, "Template used outside of a process");
+    }
+    if (!isEmptyT(p->tasks) || p->program != NULL) {
+        return parseFail(err, line, PARSE_ERROR, "Template used by a process with instructions");
+    }
+    if (fscanf(file, "use:%" TEMPLATE_SCAN "s", name) != 1) {
+        return parseFail(err, line, PARSE_ERROR, "Error reading template name");
+    }
+
+    // the options are read from the rest of the line only
+    while ((c = fgetc(file)) != '\n' && c != EOF) {
+        if (len < (int)sizeof(rest) - 1) rest[len++] = (char)c;
+    }
+    rest[len] = '\0';
+
+    Program *prog = NULL;
+    for (int i = 0; i < tpl->count; i++) {
+        if (strcmp(tpl->items[i].name, name) == 0 && !(tpl->open && i == tpl->count - 1)) {
+            prog = tpl->items[i].program;
+        }
+    }
+    if (prog == NULL) {
+        return parseFail(err, line, PARSE_ERROR, "Unknown template");
+    }
+
+    int instances = 1;
+    Ticks stride = 0;
+    char *save = NULL;
+    for (char *opt = strtok_r(rest, " \t\r", &save); opt != NULL; opt = strtok_r(NULL, " \t\r", &save)) {
+        if (sscanf(opt, "x%d", &instances) == 1 && instances > 0) continue;
+        if (sscanf(opt, "stride:%lld", &stride) == 1 && stride >= 0) continue;
+        return parseFail(err, line, PARSE_ERROR, "Error reading template options");
+    }
+
+    // the first instance is the process itself
+    attachProgram(p, prog);
+    if (enqueueProcess(q, p) != 0) {
+        return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+    }
+    p->endQueue = "B";
+
+    for (int k = 1; k < instances; k++) {
+        Process *copy = createProcess();
+        if (copy == NULL) {
+            return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+        }
+        copy->pid = p->pid + k;
+        copy->priority = p->priority;
+        copy->arrival = p->arrival + k * stride;
+        copy->quantum = p->quantum;
+        copy->deadline = p->deadline;
+        attachProgram(copy, prog);
+        if (p->group != NULL) {
+            copy->group = p->group;
+            copy->group->members++;
+            holdGroups(copy->group->tree);
+        }
+        if (enqueueProcess(q, copy) != 0) {
+            freeProcess(copy);
+            return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+        }
+        copy->endQueue = "B";
+    }
+
+    return PARSE_OK;
+}
+
+/*
+ * Function: flushSink
+ *
+ * Hands every process in q to the sink, in order. Returns a parser status
+ * code; a process the sink refuses is freed.
+ */
+static int flushSink(pQueue *q, const ParseSink *sink, int line, ParseError *err) {
+    Process *p;
+    while ((p = dequeueProcess(q)) != NULL) {
+        if (sink->emit(p, sink->arg) != 0) {
+            freeProcess(p);
+            return parseFail(err, line, PARSE_ERROR, "Reading stopped");
+        }
+    }
+    return PARSE_OK;
+}
+
+/*
+ * Function: parseLines
+ *
+ * Reads processes and templates from file into q, numbering lines from
+ * line. With a sink, the processes of each completed record are handed
+ * to it as the next line is read, instead of staying in q. Returns a
+ * parser status code.
+ */
+static int parseLines(FILE* file, int quantumB, pQueue *q, ParseError *err, Templates *tpl, int line, const ParseSink *sink) {
+
+    // create process pointer
     Process *p = NULL;
-    Task *t = NULL;
 
     // create a character to read from file
-    char c;
-
-    // create process queue
-    pQueue *q = createProcessQueue();
+    int c;
+    int status;
 
     // read file until end of file
     while ((c = fgetc(file)) != EOF) {
 
         ungetc(c, file);
 
+        if (sink != NULL && q->head != NULL && (status = flushSink(q, sink, line, err)) != PARSE_OK) {
+            freeProcess(p);
+            return status;
+        }
+
         switch(c) {
             case 'P':
+                if (tpl->open) {
+                    return parseFail(err, line, PARSE_ERROR, "Process inside a template");
+                }
+
+                // an unterminated process is discarded by the next one
+                freeProcess(p);
+
                 // create process
                 p = createProcess();
+                if (p == NULL) {
+                    return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+                }
                 p->quantum = quantumB;
 
                 // assign process pid and priority
                 if (fscanf(file, "P%d:%d", &(p->pid), &(p->priority)) != 2) {
-                    fprintf(stderr, "Error reading process\n");
-                    exit(EXIT_FAILURE);
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_ERROR, "Error reading process");
                 }
 
                 break;
             case 'a':
                 // assign arrival time
-                if (fscanf(file, "arrival_t:%d", &(p->arrival)) != 1) {
-                    fprintf(stderr, "Error reading arrival time\n");
-                    exit(EXIT_FAILURE);
+                if (p == NULL) {
+                    return parseFail(err, line, PARSE_ERROR, "Arrival time outside of a process");
+                }
+                if (fscanf(file, "arrival_t:%lld", &(p->arrival)) != 1) {
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_ERROR, "Error reading arrival time");
                 }
 
                 break;
-            case 'i':
-                // create io task
-                t = createTask();
-                t->type = 'i';
-
-                if (fscanf(file, "io:%d", &(t->time)) != 1) {
-                    fprintf(stderr, "Error reading io time\n");
-                    exit(EXIT_FAILURE);
+            case 'd':
+                // assign deadline, relative to arrival
+                if (p == NULL) {
+                    return parseFail(err, line, PARSE_ERROR, "Deadline outside of a process");
+                }
+                if (fscanf(file, "deadline:%lld", &(p->deadline)) != 1) {
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_ERROR, "Error reading deadline");
+                }
+                if (p->deadline <= 0) {
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_ERROR, "Invalid deadline");
                 }
 
-                // assign parent process
-                t->parent = p;
+                break;
+            case 'g':
+                // place the process in a fair-share group
+                status = addParsedGroup(file, p, tpl, line, err);
+                if (status != PARSE_OK) {
+                    freeProcess(p);
+                    return status;
+                }
 
-                // add task to process
-                if (t != NULL) {
-                    enqueueTask(p->tasks, t);
-                    t = NULL;
+                break;
+            case 'i':
+                // create io task
+                status = tpl->open ? addTemplateInstruction(file, tpl, 'i', "io:%lld", line, err, "Error reading io time") :
+                                     addParsedTask(file, p, 'i', "io:%lld", line, err, "Error reading io time");
+                if (status != PARSE_OK) {
+                    freeProcess(p);
+                    return status;
                 }
 
                 break;
             case 'e':
                 // create exe task
-                t = createTask();
-                t->type = 'e';
-
-                // assign exe time
-                if (fscanf(file, "exe:%d", &(t->time)) != 1) {
-                    fprintf(stderr, "Error reading exe time\n");
-                    exit(EXIT_FAILURE);
-                }
-
-                // assign parent process
-                t->parent = p;
-
-                // add task to process
-                if (t != NULL) {
-                    enqueueTask(p->tasks, t);
-                    t = NULL;
+                status = tpl->open ? addTemplateInstruction(file, tpl, 'e', "exe:%lld", line, err, "Error reading exe time") :
+                                     addParsedTask(file, p, 'e', "exe:%lld", line, err, "Error reading exe time");
+                if (status != PARSE_OK) {
+                    freeProcess(p);
+                    return status;
                 }
 
                 break;
             case 't':
-                // create terminate task
-                t = createTask();
-                t->type = 't';
-                t->parent = p;
+                // a terminate ends the template being defined
+                if (tpl->open) {
+                    status = addTemplateInstruction(file, tpl, 't', NULL, line, err, NULL);
+                    if (status != PARSE_OK) {
+                        return status;
+                    }
+                    break;
+                }
 
-                // add task to process
-                if (t != NULL) {
-                    enqueueTask(p->tasks, t);
-                    t = NULL;
+                // create terminate task
+                status = addParsedTask(file, p, 't', NULL, line, err, NULL);
+                if (status != PARSE_OK) {
+                    freeProcess(p);
+                    return status;
                 }
 
                 // add process to queue B
-                if (p != NULL) {
-                    enqueueProcess(q, p);
-                    p->endQueue = "B";
-                    p = NULL; // reset process
+                if (enqueueProcess(q, p) != 0) {
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
                 }
+                p->endQueue = "B";
+                p = NULL; // reset process
 
                 // consume the rest of the line
-                while ((c = fgetc(file)) != '\n' && !(feof(file)));
+                while ((c = fgetc(file)) != '\n' && c != EOF);
+                line++;
+
+                continue;
+            case 'j':
+                // start a template
+                if (p != NULL || tpl->open) {
+                    freeProcess(p);
+                    return parseFail(err, line, PARSE_ERROR, "Template inside a process");
+                }
+                status = beginTemplate(file, tpl, line, err);
+                if (status != PARSE_OK) {
+                    return status;
+                }
+
+                break;
+            case 'u':
+                // instance a template, which completes the process
+                status = instanceTemplate(file, p, tpl, q, line, err);
+                if (status != PARSE_OK) {
+                    if (p == NULL || p->nodes == NULL) freeProcess(p);
+                    return status;
+                }
+                p = NULL; // reset process
+                line++;
 
                 continue;
         }
 
         // move to the next line
         while ((c = fgetc(file)) != '\n' && c != EOF);
+        line++;
+    }
+
+    // a trace that cannot be read to the end fails, even between records
+    if (ferror(file)) {
+        freeProcess(p);
+        return parseFail(err, line, PARSE_ERROR, "Error reading trace");
+    }
+
+    if (tpl->open) {
+        return parseFail(err, line, PARSE_ERROR, "Template without terminate");
     }
 
     // ensure uncaught processes are added to the queue
     if (p != NULL) {
-        enqueueProcess(q, p);
+        if (enqueueProcess(q, p) != 0) {
+            freeProcess(p);
+            return parseFail(err, line, PARSE_NOMEM, "Memory allocation failed");
+        }
         p->endQueue = "B";
         p = NULL;
     }
 
+    return PARSE_OK;
+}
+
+// process parser function
+int parseProcesses(FILE* file, int quantumB, pQueue *q, ParseError *err) {
+    Templates tpl = { NULL, 0, 0, 0, NULL };
+
+    int status = readFailure(file, parseLines(file, quantumB, q, err, &tpl, 1, NULL), err);
+
+    // in a trace with groups, the processes that name none share one
+    if (status == PARSE_OK && tpl.groups != NULL) {
+        placeUngrouped(tpl.groups, q);
+    }
+
+    // instanced processes hold their own references to the programs
+    for (int i = 0; i < tpl.count; i++) {
+        releaseProgram(tpl.items[i].program);
+    }
+    free(tpl.items);
+    releaseGroups(tpl.groups);
+    return status;
+}
+
+/*
+ * Function: parseSpans
+ *
+ * Reads processes and templates from the given byte ranges of file into
+ * q, in order, as if they were one file. Templates defined in one span
+ * can be used in later ones. Returns a parser status code.
+ */
+int parseSpans(FILE* file, const ParseSpan *spans, int count, int quantumB, pQueue *q, ParseError *err) {
+    Templates tpl = { NULL, 0, 0, 0, NULL };
+    int status = PARSE_OK;
+
+    for (int i = 0; status == PARSE_OK && i < count; i++) {
+        size_t size = (size_t)(spans[i].end - spans[i].start);
+        char *buffer = (char *)malloc(size + 1);
+        if (buffer == NULL) {
+            status = parseFail(err, spans[i].line, PARSE_NOMEM, "Memory allocation failed");
+            break;
+        }
+
+        // each span is parsed from memory, so nothing past its end is read
+        FILE *span = NULL;
+        if (fseeko(file, spans[i].start, SEEK_SET) != 0 || fread(buffer, 1, size, file) != size) {
+            status = parseFail(err, spans[i].line, PARSE_ERROR, "Error reading trace");
+        } else if (size > 0 && (span = fmemopen(buffer, size, "r")) == NULL) {
+            status = parseFail(err, spans[i].line, PARSE_NOMEM, "Memory allocation failed");
+        } else if (span != NULL) {
+            status = parseLines(span, quantumB, q, err, &tpl, spans[i].line, NULL);
+            fclose(span);
+        }
+        free(buffer);
+    }
+    if (status == PARSE_OK && tpl.groups != NULL) {
+        placeUngrouped(tpl.groups, q);
+    }
+
+    for (int i = 0; i < tpl.count; i++) {
+        releaseProgram(tpl.items[i].program);
+    }
+    free(tpl.items);
+    releaseGroups(tpl.groups);
+    return status;
+}
+
+/*
+ * Function: parseProcessStream
+ *
+ * Reads processes and templates from file, handing each process to the
+ * sink as soon as its record is complete, so a consumer can start on the
+ * first processes while the rest are read. Returns a parser status code.
+ */
+int parseProcessStream(FILE* file, int quantumB, const ParseSink *sink, ParseError *err) {
+    pQueue *q = createProcessQueue();
+    if (q == NULL) {
+        return parseFail(err, 0, PARSE_NOMEM, "Memory allocation failed");
+    }
+    Templates tpl = { NULL, 0, 0, 0, NULL };
+
+    int status = readFailure(file, parseLines(file, quantumB, q, err, &tpl, 1, sink), err);
+    if (status == PARSE_OK) {
+        status = flushSink(q, sink, 0, err);
+    }
+
+    Process *p;
+    while ((p = dequeueProcess(q)) != NULL) {
+        freeProcess(p);
+    }
+    freeProcessQueue(q);
+    for (int i = 0; i < tpl.count; i++) {
+        releaseProgram(tpl.items[i].program);
+    }
+    free(tpl.items);
+    releaseGroups(tpl.groups);
+    return status;
+}
+
+// file parser function
+pQueue *ParseFile(FILE* file, int quantumB) {
+
+    // create process queue
+    pQueue *q = createProcessQueue();
+    if (q == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ParseError err;
+    if (parseProcesses(file, quantumB, q, &err) != PARSE_OK) {
+        fprintf(stderr, "%s\n", err.message);
+        exit(EXIT_FAILURE);
+    }
+
     return q;
 }
@@ -14,7 +14,38 @@
  //#include "process.h"
  #include "queue.h"
 
+ // Parser status codes
+ #define PARSE_OK 0
+ #define PARSE_ERROR -1
+ #define PARSE_NOMEM -2
+
+ // Longest template name, including the terminator
+ #define TEMPLATE_NAME 64
+ #define TEMPLATE_SCAN "63" // scanf width for a template name
+
+ // Struct for reporting a parse failure
+ typedef struct ParseError {
+     int line;                  // line number of the failure
+     const char *message;       // description of the failure
+ } ParseError;
+
+ // Struct for a byte range of a trace
+ typedef struct ParseSpan {
+     long long start;           // offset of the first byte
+     long long end;             // offset just past the last byte
+     int line;                  // line number of the first byte
+ } ParseSpan;
+
+ // Struct for a consumer of parsed processes
+ typedef struct ParseSink {
+     int (*emit)(Process *p, void *arg); // takes p and returns 0, or returns -1 to stop the parse
+     void *arg;                 // passed to emit
+ } ParseSink;
+
  // Function prototypes
+ int parseProcesses(FILE* file, int quantumB, pQueue *q, ParseError *err);
+ int parseProcessStream(FILE* file, int quantumB, const ParseSink *sink, ParseError *err);
+ int parseSpans(FILE* file, const ParseSpan *spans, int count, int quantumB, pQueue *q, ParseError *err);
  pQueue *ParseFile(FILE* file, int quantumB);
 
  #endif
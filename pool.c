@@ -0,0 +1,126 @@
+/*
+ * pool.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the object pools. Each kind of
+ * object has its own free list, threaded through the freed objects
+ * themselves, and at most POOL_LIMIT freed objects of a kind are kept
+ * before memory is handed back to the allocator.
+ */
+
+#include <stdlib.h>
+
+#include "pool.h"
+#include "queue.h"
+
+// Struct for a freed object on a free list
+typedef struct PoolEntry {
+    struct PoolEntry *next;    // next freed object of the same kind
+} PoolEntry;
+
+// size of each kind of object
+static const size_t poolSizes[POOL_KINDS] = {
+    sizeof(Task), sizeof(tNode), sizeof(tQueue),
+    sizeof(Process), sizeof(pNode), sizeof(pQueue)
+};
+
+static __thread PoolEntry *freeLists[POOL_KINDS];  // freed objects by kind
+static __thread int freeCounts[POOL_KINDS];        // length of each free list
+static __thread long liveCounts[POOL_KINDS];       // live objects by kind
+static __thread long currentBytes;                 // bytes in live objects
+static __thread long peakBytes;                    // highest currentBytes
+static __thread long pooledBytes;                  // bytes on the free lists
+
+/*
+ * Function: poolAlloc
+ *
+ * Returns an object of the given kind, reusing a freed one if there is
+ * one, or NULL if allocation fails. The object is not initialized.
+ */
+void *poolAlloc(PoolKind kind) {
+    size_t size = poolSizes[kind];
+    PoolEntry *e = freeLists[kind];
+    if (e != NULL) {
+        freeLists[kind] = e->next;
+        freeCounts[kind]--;
+        pooledBytes -= size;
+    } else if ((e = (PoolEntry *)malloc(size)) == NULL) {
+        return NULL;
+    }
+
+    liveCounts[kind]++;
+    currentBytes += size;
+    if (currentBytes > peakBytes) {
+        peakBytes = currentBytes;
+    }
+    return e;
+}
+
+/*
+ * Function: poolFree
+ *
+ * Returns an object obtained from poolAlloc to its free list, or to the
+ * allocator once the free list is full
+ */
+void poolFree(PoolKind kind, void *object) {
+    if (object == NULL) return;
+
+    size_t size = poolSizes[kind];
+    liveCounts[kind]--;
+    currentBytes -= size;
+
+    if (freeCounts[kind] >= POOL_LIMIT) {
+        free(object);
+        return;
+    }
+    PoolEntry *e = (PoolEntry *)object;
+    e->next = freeLists[kind];
+    freeLists[kind] = e;
+    freeCounts[kind]++;
+    pooledBytes += size;
+}
+
+/*
+ * Function: poolTrim
+ *
+ * Hands every freed object of the calling thread back to the allocator
+ */
+void poolTrim(void) {
+    for (int k = 0; k < POOL_KINDS; k++) {
+        while (freeLists[k] != NULL) {
+            PoolEntry *e = freeLists[k];
+            freeLists[k] = e->next;
+            free(e);
+        }
+        freeCounts[k] = 0;
+    }
+    pooledBytes = 0;
+}
+
+/*
+ * Function: memoryUsage
+ *
+ * Fills usage with the memory accounting of the calling thread
+ */
+void memoryUsage(MemoryUsage *usage) {
+    usage->current = currentBytes;
+    usage->peak = peakBytes;
+    usage->pooled = pooledBytes;
+    usage->tasks = liveCounts[POOL_TASK];
+    usage->nodes = liveCounts[POOL_TASK_NODE] + liveCounts[POOL_PROCESS_NODE];
+    usage->processes = liveCounts[POOL_PROCESS];
+}
+
+/*
+ * Function: printMemoryUsage
+ *
+ * Prints the memory accounting of the calling thread
+ */
+void printMemoryUsage(FILE *f) {
+    MemoryUsage u;
+    memoryUsage(&u);
+    fprintf(f, "Memory: current %ld bytes, peak %ld bytes, pooled %ld bytes\n", u.current, u.peak, u.pooled);
+    fprintf(f, "Live objects: %ld tasks, %ld nodes, %ld processes\n", u.tasks, u.nodes, u.processes);
+}
@@ -0,0 +1,51 @@
+/*
+ * pool.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for the object pools behind tasks,
+ * processes, queues and queue nodes. Freed objects are kept on a per-kind
+ * free list for reuse, so a long run recycles the same memory instead of
+ * growing with the number of instructions executed. Pools and counters are
+ * per thread, so engines on separate threads never share them.
+ */
+
+ #ifndef POOL_H
+ #define POOL_H
+
+ #include <stdio.h>
+
+ #ifndef POOL_LIMIT
+ #define POOL_LIMIT 4096 // freed objects of each kind kept for reuse
+ #endif
+
+ // Kinds of pooled objects
+ typedef enum PoolKind {
+     POOL_TASK,                 // Task
+     POOL_TASK_NODE,            // tNode
+     POOL_TASK_QUEUE,           // tQueue
+     POOL_PROCESS,              // Process
+     POOL_PROCESS_NODE,         // pNode
+     POOL_PROCESS_QUEUE,        // pQueue
+     POOL_KINDS                 // number of kinds
+ } PoolKind;
+
+ // Struct for the memory accounting of the calling thread
+ typedef struct MemoryUsage {
+     long current;              // bytes held by live objects
+     long peak;                 // highest value of current
+     long pooled;               // bytes of freed objects kept for reuse
+     long tasks;                // live tasks
+     long nodes;                // live task and process nodes
+     long processes;            // live processes
+ } MemoryUsage;
+
+ // function prototypes
+ void *poolAlloc(PoolKind kind);
+ void poolFree(PoolKind kind, void *object);
+ void poolTrim(void);
+ void memoryUsage(MemoryUsage *usage);
+ void printMemoryUsage(FILE *f);
+
+ #endif
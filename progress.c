@@ -0,0 +1,149 @@
+/*
+ * progress.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the progress reporter. Reports
+ * go to stderr and/or a POSIX shared-memory block that another process can
+ * map read-only and poll while the simulation runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "progress.h"
+
+/*
+ * Function: elapsedSince
+ *
+ * Returns the number of seconds between two monotonic timestamps
+ */
+static double elapsedSince(struct timespec *from, struct timespec *to) {
+    return (double)(to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/*
+ * Function: createProgress
+ *
+ * Creates a progress reporter that checks the clock every interval
+ * iterations and reports at most once per period seconds
+ */
+Progress *createProgress(long interval, double period) {
+    Progress *pr = (Progress *)malloc(sizeof(Progress));
+    if (!pr) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pr->interval = interval > 0 ? interval : 1;   // iterations per clock check
+    pr->countdown = pr->interval;                   // iterations until next check
+    pr->iterations = 0;                             // iterations so far
+    pr->period = period;                            // seconds between reports
+    pr->toStderr = 1;                               // report to stderr
+    pr->lastRuntime = 0;                            // runtime at last report
+    pr->lastIterations = 0;                         // iterations at last report
+    pr->retired = 0;                                // completed processes already freed
+    pr->block = NULL;                               // shared-memory block
+
+    clock_gettime(CLOCK_MONOTONIC, &pr->start);
+    pr->last = pr->start;
+
+    return pr;
+}
+
+/*
+ * Function: attachProgressBlock
+ *
+ * Creates (or reuses) the named shared-memory object and maps the stats
+ * block into it. Returns 0 on success, -1 on failure.
+ */
+int attachProgressBlock(Progress *pr, const char *name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open");
+        return -1;
+    }
+
+    if (ftruncate(fd, sizeof(ProgressBlock)) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+
+    void *mem = mmap(NULL, sizeof(ProgressBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the object alive
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    pr->block = (ProgressBlock *)mem;
+    pr->block->seq = 0;
+    return 0;
+}
+
+/*
+ * Function: progressCheck
+ *
+ * Reads the clock and, once the report period has passed, publishes the
+ * current simulated time, completions, queue depths and throughput
+ */
+void progressCheck(Progress *pr, Ticks runtime, pQueue *exitQueue, pQueue *queueA, pQueue *queueB, tQueue *ioQueue) {
+    pr->iterations += pr->interval - pr->countdown;
+    pr->countdown = pr->interval;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    double window = elapsedSince(&pr->last, &now);
+    if (window < pr->period) {
+        return;
+    }
+
+    double ticksPerSec = (runtime - pr->lastRuntime) / window;
+    double itersPerSec = (pr->iterations - pr->lastIterations) / window;
+    double elapsed = elapsedSince(&pr->start, &now);
+
+    if (pr->toStderr) {
+        fprintf(stderr, "[progress] %.1fs time:%lld completed:%ld queueA:%d queueB:%d io:%d ticks/s:%.0f iter/s:%.0f\n",
+                elapsed, runtime, pr->retired + exitQueue->size, queueA->size, queueB->size, ioQueue->size, ticksPerSec, itersPerSec);
+    }
+
+    if (pr->block) {
+        ProgressBlock *b = pr->block;
+        b->seq++; // odd: readers retry
+        __sync_synchronize();
+        b->runtime = runtime;
+        b->iterations = pr->iterations;
+        b->completed = pr->retired + exitQueue->size;
+        b->queueA = queueA->size;
+        b->queueB = queueB->size;
+        b->ioQueue = ioQueue->size;
+        b->ticksPerSec = ticksPerSec;
+        b->elapsed = elapsed;
+        __sync_synchronize();
+        b->seq++; // even: block is consistent
+    }
+
+    pr->last = now;
+    pr->lastRuntime = runtime;
+    pr->lastIterations = pr->iterations;
+}
+
+/*
+ * Function: freeProgress
+ *
+ * Unmaps the shared-memory block (if any) and frees the reporter
+ */
+void freeProgress(Progress *pr) {
+    if (!pr) return;
+
+    if (pr->block) {
+        munmap(pr->block, sizeof(ProgressBlock));
+    }
+    free(pr);
+}
@@ -0,0 +1,64 @@
+/*
+ * progress.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definition of the optional progress reporter.
+ * The reporter counts loop iterations and only reads the monotonic clock
+ * once every N iterations, so leaving it enabled costs one decrement and
+ * one branch per simulated tick.
+ */
+
+ #ifndef PROGRESS_H
+ #define PROGRESS_H
+
+ #include <time.h>
+ #include "queue.h"
+
+ // Struct for the shared-memory stats block polled by external tools
+ typedef struct ProgressBlock {
+     volatile unsigned long seq;    // odd while an update is in progress
+     long runtime;                  // current simulated time
+     long iterations;               // scheduler loop iterations so far
+     long completed;                // number of processes completed
+     long queueA;                   // depth of the highest level (queue A)
+     long queueB;                   // depth of the lowest level (queue B)
+     long ioQueue;                  // depth of the I/O queue
+     double ticksPerSec;            // simulated ticks per wall-clock second
+     double elapsed;                // wall-clock seconds since start
+ } ProgressBlock;
+
+ // Struct for the progress reporter
+ typedef struct Progress {
+     long interval;                 // iterations between clock checks
+     long countdown;                // iterations left until next clock check
+     long iterations;               // scheduler loop iterations so far
+     double period;                 // seconds between reports
+     int toStderr;                  // flag for reporting to stderr
+     struct timespec start;         // wall-clock time at start of run
+     struct timespec last;          // wall-clock time of last report
+     Ticks lastRuntime;             // simulated time at last report
+     long lastIterations;           // iterations at last report
+     long retired;                  // completed processes no longer in the exit queue
+     ProgressBlock *block;          // optional shared-memory stats block
+ } Progress;
+
+ // function prototypes
+ Progress *createProgress(long interval, double period);
+ int attachProgressBlock(Progress *pr, const char *name);
+ void progressCheck(Progress *pr, Ticks runtime, pQueue *exitQueue, pQueue *queueA, pQueue *queueB, tQueue *ioQueue);
+ void freeProgress(Progress *pr);
+
+ /*
+  * Function: progressTick
+  *
+  * Counts one scheduler iteration and checks the clock every interval
+  */
+ static inline void progressTick(Progress *pr, Ticks runtime, pQueue *exitQueue, pQueue *queueA, pQueue *queueB, tQueue *ioQueue) {
+     if (pr && --pr->countdown <= 0) {
+         progressCheck(pr, runtime, exitQueue, queueA, queueB, ioQueue);
+     }
+ }
+
+ #endif
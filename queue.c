@@ -9,8 +9,40 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "queue.h"
+#include "pool.h"
+#include "group.h"
+#include "deadline.h"
+
+/*
+ * Function: readyRank
+ *
+ * Returns the value a ready queue is ordered by, larger first. With aging
+ * a waiting task gains a point of priority for every aging ticks in the
+ * queue, so its priority at time now is its parent's priority scaled by
+ * aging plus now - readySince. All the tasks of a queue wait together and
+ * gain alike, so the rank leaves out now and the queue's order holds
+ * without re-sorting. Without aging this is the plain priority.
+ */
+Ticks readyRank(const Task *t, int aging) {
+    return aging > 0 ? (Ticks)t->parent->priority * aging - t->readySince : t->parent->priority;
+}
+
+/*
+ * Function: processRank
+ *
+ * Returns the value two processes are compared by when one of them is to
+ * start its next task, smaller first. With aging a process moves ahead by
+ * a point for every aging ticks of ready time, computed when the two are
+ * compared, since processes wait at different rates (not while a task of
+ * theirs runs). The result is scaled by aging so no division is needed.
+ * Without aging this is the plain priority.
+ */
+Ticks processRank(const Process *p, int aging) {
+    return aging > 0 ? (Ticks)p->priority * aging - p->ready : p->priority;
+}
 
 /************************************************************
  * Task & Task Queue Functions
@@ -22,52 +54,124 @@
   * Creates a new queue to hold tasks
   */
 tQueue *createTaskQueue() {
-    tQueue *q = (tQueue *)malloc(sizeof(tQueue));
+    tQueue *q = (tQueue *)poolAlloc(POOL_TASK_QUEUE);
     if (!q) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     q->head = NULL;
     q->tail = NULL;
     q->size = 0;
+    q->aging = 0;
+    q->level = -1;
+    q->deadlines = NULL;
     return q;
 }
 
 /*
  * Function: createTask
  *
- * Creates a new task object
+ * Creates a new task object, or returns NULL if allocation fails
  */
 Task *createTask() {
-    Task *t = (Task *)malloc(sizeof(Task));
+    Task *t = (Task *)poolAlloc(POOL_TASK);
     if (!t) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
     t->type = 'x';          // task type (io, exe, terminate)
     t->time = 0;            // time required for task
+    t->wait = 0;            // ready/wait time
     t->completed = 0;       // flag for task completion
     t->interrupts = 0;      // number of times task was interrupted
     t->parent = NULL;       // pointer to parent process
+    t->node = NULL;         // node holding the task
+    t->deadlineSlot = -1;   // not in a deadline heap
+    t->readySince = 0;      // time the task entered its ready queue
 
     return t;
 }
 
+/*
+ * Function: freeTask
+ *
+ * Returns a task that is no longer in any queue to its pool
+ */
+void freeTask(Task *t) {
+    if (t != NULL && t->parent != NULL) {
+        t->parent->tasksOut--;
+    }
+    poolFree(POOL_TASK, t);
+}
+
+/*
+ * Function: freeTaskQueue
+ *
+ * Frees a task queue along with every task still in it
+ */
+void freeTaskQueue(tQueue *q) {
+    if (q == NULL) return;
+
+    Task *t;
+    while ((t = dequeueTask(q)) != NULL) {
+        freeTask(t);
+    }
+    poolFree(POOL_TASK_QUEUE, q);
+}
+
+/*
+ * Function: allocTaskNode
+ *
+ * Allocates a node for a task about to join q, with room for it in the
+ * queue's deadline heap if it keeps one. Returns NULL if allocation fails.
+ */
+static tNode *allocTaskNode(tQueue *q) {
+    if (q->deadlines != NULL && reserveReadyDeadline(q->deadlines) != 0) {
+        return NULL;
+    }
+    return (tNode *)poolAlloc(POOL_TASK_NODE);
+}
+
+/*
+ * Function: trackTaskNode
+ *
+ * Adds a node just linked into q to what a level keeps alongside its
+ * ready queue: the list of the task's group and the deadline heap
+ */
+static inline void trackTaskNode(tQueue *q, tNode *node) {
+    linkGroupTask(q, node);
+    if (q->deadlines != NULL) {
+        pushReadyDeadline(q->deadlines, node->task);
+    }
+}
+
+/*
+ * Function: untrackTaskNode
+ *
+ * Takes a node about to leave q out of what trackTaskNode added it to
+ */
+static inline void untrackTaskNode(tQueue *q, tNode *node) {
+    unlinkGroupTask(q, node);
+    if (q->deadlines != NULL) {
+        removeReadyDeadline(q->deadlines, node->task);
+    }
+}
+
 /*
  * Function: enqueueTask
  *
- * Adds a task to the end of the queue
+ * Adds a task to the end of the queue. Returns 0 on success, -1 if the
+ * node cannot be allocated.
  */
-void enqueueTask(tQueue *q, Task *t) {
-    tNode *newNode = (tNode *)malloc(sizeof(tNode));
+int enqueueTask(tQueue *q, Task *t) {
+    tNode *newNode = allocTaskNode(q);
     if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     newNode->task = t;
     newNode->next = NULL;
+    newNode->prev = q->tail;
+    t->node = newNode;
 
     if (q->head == NULL) {
         q->head = newNode;
@@ -78,45 +182,50 @@ void enqueueTask(tQueue *q, Task *t) {
     }
 
     q->size++;
+    trackTaskNode(q, newNode);
+    return 0;
 }
 
 /*
  * Function: frontloadTask
  *
- * Adds a task to the front of the queue
+ * Adds a task to the front of the queue. Returns 0 on success, -1 if the
+ * node cannot be allocated.
  */
-void frontloadTask(tQueue *q, Task *t) {
-    tNode *newNode = (tNode *)malloc(sizeof(tNode));
+int frontloadTask(tQueue *q, Task *t) {
+    tNode *newNode = allocTaskNode(q);
     if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     newNode->task = t;
     newNode->next = q->head;
-    q->head = newNode;
+    newNode->prev = NULL;
+    t->node = newNode;
 
-    if (q->tail == NULL) {
+    if (q->head == NULL) {
         q->tail = newNode;
+    } else {
+        q->head->prev = newNode;
     }
+    q->head = newNode;
 
     q->size++;
+    trackTaskNode(q, newNode);
+    return 0;
 }
 
 /*
- * Function: priorityEnqueueTask
+ * Function: insertTaskNode
  *
- * Adds a task to the queue based on the priority of the parent process
+ * Links an existing node into the queue based on the priority of the
+ * parent process
  */
-void priorityEnqueueTask(tQueue *q, Task *t) {
-    tNode *newNode = (tNode *)malloc(sizeof(tNode));
-    if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-
-    newNode->task = t;
+static void insertTaskNode(tQueue *q, tNode *newNode) {
+    Task *t = newNode->task;
     newNode->next = NULL;
+    newNode->prev = NULL;
+    t->node = newNode;
 
     // if the queue is empty, add the task to the head
     if (q->head == NULL) {
@@ -126,86 +235,143 @@ void priorityEnqueueTask(tQueue *q, Task *t) {
         tNode *current = q->head;
         tNode *prev = NULL;
         // otherwise, add the task based on the priority of the parent process
-        while (current != NULL && current->task->parent->priority > t->parent->priority) {
+        Ticks rank = readyRank(t, q->aging);
+        while (current != NULL && readyRank(current->task, q->aging) > rank) {
             prev = current;
             current = current->next;
         }
 
         if (prev == NULL) {
             newNode->next = q->head;
+            q->head->prev = newNode;
             q->head = newNode;
         } else if (current == NULL) {
+            newNode->prev = q->tail;
             q->tail->next = newNode;
             q->tail = newNode;
         } else {
             prev->next = newNode;
+            newNode->prev = prev;
             newNode->next = current;
+            current->prev = newNode;
         }
     }
 
     q->size++;
+    trackTaskNode(q, newNode);
 }
 
 /*
- * Function: dequeueTask
+ * Function: priorityEnqueueTask
  *
- * Removes the first task from the queue
+ * Adds a task to the queue based on the priority of the parent process.
+ * Returns 0 on success, -1 if the node cannot be allocated.
  */
-Task *dequeueTask(tQueue *q) {
+int priorityEnqueueTask(tQueue *q, Task *t) {
+    tNode *newNode = allocTaskNode(q);
+    if (!newNode) {
+        return -1;
+    }
+
+    newNode->task = t;
+    insertTaskNode(q, newNode);
+    return 0;
+}
+
+/*
+ * Function: popTaskNode
+ *
+ * Unlinks the first node from the queue without freeing it
+ */
+static tNode *popTaskNode(tQueue *q) {
     if (q->head == NULL) {
         return NULL;
     }
 
     tNode *temp = q->head;
-    Task *t = temp->task;
-
+    untrackTaskNode(q, temp);
     q->head = q->head->next;
-    free(temp);
-
+    if (q->head == NULL) {
+        q->tail = NULL;
+    } else {
+        q->head->prev = NULL;
+    }
+    temp->task->node = NULL;
     q->size -= 1;
 
-    return t;
+    return temp;
 }
 
 /*
- * Function: removeTask
- *
- * Removes a specific task from the queue
+ * Function: unlinkTaskNode
  *
+ * Unlinks a node from anywhere in the queue without freeing it
  */
-void removeTask(tQueue *q, Task *t) {
-    if (q->head == NULL) {
-        return;
+static void unlinkTaskNode(tQueue *q, tNode *node) {
+    untrackTaskNode(q, node);
+    if (node->prev == NULL) {
+        q->head = node->next;
+    } else {
+        node->prev->next = node->next;
+    }
+
+    if (node->next == NULL) {
+        q->tail = node->prev;
+    } else {
+        node->next->prev = node->prev;
     }
 
-    tNode *current = q->head;
-    tNode *prev = NULL;
+    node->task->node = NULL;
+    q->size -= 1;
+}
 
-    // Find the task in the queue
-    while (current != NULL && current->task != t) {
-        prev = current;
-        current = current->next;
+/*
+ * Function: dequeueTask
+ *
+ * Removes the first task from the queue
+ */
+Task *dequeueTask(tQueue *q) {
+    tNode *temp = popTaskNode(q);
+    if (temp == NULL) {
+        return NULL;
     }
 
+    Task *t = temp->task;
+    poolFree(POOL_TASK_NODE, temp);
+
+    return t;
+}
+
+/*
+ * Function: removeTask
+ *
+ * Removes a specific task from the queue it is linked into, which must be
+ * q, in constant time through the task's node handle
+ */
+void removeTask(tQueue *q, Task *t) {
+    tNode *current = t->node;
     if (current == NULL) {
         return;
     }
 
-    // Remove the task from the queue
-    if (prev == NULL) {
-        q->head = current->next;
-    } else {
-        prev->next = current->next;
-    }
+    unlinkTaskNode(q, current);
+    poolFree(POOL_TASK_NODE, current);
+}
 
-    if (current == q->tail) {
-        q->tail = prev;
+/*
+ * Function: requeueTask
+ *
+ * Moves a task of the queue to its place by the priority of its parent
+ * process, reusing its node
+ */
+void requeueTask(tQueue *q, Task *t) {
+    tNode *node = t->node;
+    if (node == NULL) {
+        return;
     }
 
-    // Free the memory allocated for the task
-    free(current);
-
-    q->size -= 1;
+    unlinkTaskNode(q, node);
+    insertTaskNode(q, node);
 }
 
 /*
@@ -230,36 +396,23 @@ void *peekTask(tQueue *q) {
 void updateIOTasks(tQueue *q) {
     if (!q) return; // Safety check for null queue
 
-    tNode *prev = NULL;
     for (tNode *current = q->head; current != NULL; ) {
         Task *t = current->task;
         // Decrement time if task not yet completed
         if (t->time > 0) {
             t->time--;
-            prev = current;
             current = current->next; // Move to the next node
         } else { // Task is complete
-            t->completed = 1;
             t->parent->taskRunning = 0;
             t->parent->currentTask++;
 
-            // Detach the current node from the queue
-            if (prev == NULL) {
-                q->head = current->next; // Current node is the head
-                if (q->head == NULL) { // If the queue is now empty
-                    q->tail = NULL;
-                }
-            } else { // Current node is not the head
-                prev->next = current->next;
-                if (current->next == NULL) {
-                    q->tail = prev;
-                }
-            }
-
-            // Prepare to free the current node and move to the next
+            // Detach the current node and move to the next before freeing
+            // the node and the finished task
             tNode *remove = current;
-            current = current->next; // Update node before freeing
-            free(remove); // Free the node
+            current = current->next;
+            unlinkTaskNode(q, remove);
+            poolFree(POOL_TASK_NODE, remove);
+            freeTask(t);
         }
     }
 }
@@ -270,7 +423,7 @@ void updateIOTasks(tQueue *q) {
  * Returns the next task to be executed based on the current runtime
  * and whether a process is currently running
  */
-Task *getNextTask(pQueue *q, tQueue *ready, int runtime) {
+Task *getNextTask(pQueue *q, tQueue *ready, Ticks runtime) {
     // Check if there are any tasks in the ready queue
     if (!isEmptyT(ready)) {
         Task *nextTask = dequeueTask(ready);
@@ -285,8 +438,8 @@ Task *getNextTask(pQueue *q, tQueue *ready, int runtime) {
     while (current != NULL) {
         Process *p = current->process;
         // Ensure the process has arrived and has tasks to run
-        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
-            Task *t = dequeueTask(p->tasks);
+        if (p->arrival <= runtime && p->taskRunning == 0 && hasTask(p)) {
+            Task *t = takeTask(p);
             if (t) { // If a task is found, return it
                 t->parent->taskRunning = 1; // Set the process to running
 
@@ -306,14 +459,16 @@ Task *getNextTask(pQueue *q, tQueue *ready, int runtime) {
  * Checks if a task should be preempted based on the current runtime
  * and the tasks in the process queue
  */
-int preemptionCheck (pQueue *q, tQueue *ready, Task *t, int runtime) {
+int preemptionCheck (pQueue *q, tQueue *ready, Task *t, Ticks runtime) {
     pNode *current = q->head;
     while (current != NULL) {
         Process *p = current->process;
         // Ensure the process has arrived and has tasks to run
-        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
+        if (p->arrival <= runtime && p->taskRunning == 0 && hasTask(p)) {
             Task *nextTask = peekTask(ready);
-            if (nextTask && nextTask->parent->priority > t->parent->priority) {
+            // the ready task has aged while it waited, the running one has not
+            if (nextTask && (ready->aging > 0 ? readyRank(nextTask, ready->aging) + runtime > (Ticks)t->parent->priority * ready->aging
+                                              : nextTask->parent->priority > t->parent->priority)) {
                 return 1; // should preempt
             }
         }
@@ -328,23 +483,29 @@ int preemptionCheck (pQueue *q, tQueue *ready, Task *t, int runtime) {
  * Returns the next task to be executed based on the current runtime
  * and process priority
  */
-Task *getNextTaskPreemptive(pQueue *q, tQueue *ready, int runtime) {
+Task *getNextTaskPreemptive(pQueue *q, tQueue *ready, Ticks runtime) {
     // Check if there are any tasks in the ready queue
     if (!isEmptyT(ready)) {
-        Task *currentTask = dequeueTask(ready);
+        tNode *node = popTaskNode(ready);
+        Task *currentTask = node->task;
         Task *nextTask = peekTask(ready);
         if (!nextTask) { // If no other tasks in the ready queue
+            poolFree(POOL_TASK_NODE, node);
             if (currentTask) { // return the current task
                 currentTask->parent->taskRunning = 1;
                 return currentTask;
             }
-        } else if (currentTask->parent->priority < nextTask->parent->priority) {
-            priorityEnqueueTask(ready, currentTask);
+        } else if (readyRank(currentTask, ready->aging) < readyRank(nextTask, ready->aging)) {
+            insertTaskNode(ready, node); // re-link the same node by priority
             currentTask = dequeueTask(ready);
             if (currentTask) { // If a task is found, return it
                 currentTask->parent->taskRunning = 1;
                 return currentTask;
             }
+        } else {
+            // the task is dropped, as it always has been, so free it
+            poolFree(POOL_TASK_NODE, node);
+            freeTask(currentTask);
         }
     }
 
@@ -355,23 +516,23 @@ Task *getNextTaskPreemptive(pQueue *q, tQueue *ready, int runtime) {
         Process *nextProcess = (current->next != NULL) ? current->next->process : NULL;
 
         // Ensure the process has arrived and has tasks to run
-        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
-            if (nextProcess && nextProcess->arrival <= runtime && nextProcess->taskRunning == 0 && !isEmptyT(nextProcess->tasks)) {
-                if (p->priority < nextProcess->priority) {
-                    Task *t = dequeueTask(p->tasks);
+        if (p->arrival <= runtime && p->taskRunning == 0 && hasTask(p)) {
+            if (nextProcess && nextProcess->arrival <= runtime && nextProcess->taskRunning == 0 && hasTask(nextProcess)) {
+                if (processRank(p, q->aging) < processRank(nextProcess, q->aging)) {
+                    Task *t = takeTask(p);
                     if (t) {
                         t->parent->taskRunning = 1; // Set the process to running
                         return t;
                     }
                 } else {
-                    Task *t = dequeueTask(nextProcess->tasks);
+                    Task *t = takeTask(nextProcess);
                     if (t) {
                         t->parent->taskRunning = 1; // Set the process to running
                         return t;
                     }
                 }
             } else {
-                Task *t = dequeueTask(p->tasks);
+                Task *t = takeTask(p);
                 if (t) { // If a task is found, return it
                     t->parent->taskRunning = 1; // Set the process to running
                     return t;
@@ -394,6 +555,190 @@ int isEmptyT(tQueue *q) {
     return q && q->head == NULL;
 }
 
+/*
+ * Function: hasTask
+ *
+ * Returns 1 if a process has a queued task or program instruction left
+ */
+int hasTask(Process *p) {
+    return !isEmptyT(p->tasks) || (p->program != NULL && p->programNext < p->program->count);
+}
+
+/*
+ * Function: takeTask
+ *
+ * Removes and returns a process's next task. Queued tasks come first;
+ * after them the next program instruction is made into a task, so tasks
+ * of a templated process exist only once they are scheduled. Once the
+ * last instruction is out the process lets go of its program, so a run
+ * does not keep the instructions of processes that have finished with
+ * them. Returns NULL if there is no task or the task cannot be allocated,
+ * in which case the instruction is kept for the next call.
+ */
+Task *takeTask(Process *p) {
+    if (!isEmptyT(p->tasks)) {
+        p->tasksOut++;
+        return dequeueTask(p->tasks);
+    }
+    if (p->program == NULL || p->programNext >= p->program->count) {
+        return NULL;
+    }
+
+    Task *t = createTask();
+    if (!t) {
+        return NULL;
+    }
+    t->type = p->program->instructions[p->programNext].type;
+    t->time = programTime(p->program, p->programNext);
+    t->parent = p;
+    p->programNext++;
+    p->tasksOut++;
+    if (p->programNext == p->program->count) {
+        releaseProgram(p->program);
+        p->program = NULL;
+        p->programNext = 0;
+    }
+    return t;
+}
+
+/************************************************************
+ * Program Functions
+ ************************************************************/
+
+/*
+ * Function: createProgram
+ *
+ * Creates a program with room for count instructions, held once by the
+ * caller, or returns NULL if allocation fails
+ */
+Program *createProgram(int count) {
+    Program *prog = (Program *)malloc(sizeof(Program));
+    if (!prog) {
+        return NULL;
+    }
+    prog->instructions = (Instruction *)malloc((count > 0 ? count : 1) * sizeof(Instruction));
+    if (!prog->instructions) {
+        free(prog);
+        return NULL;
+    }
+    prog->refs = 1;
+    prog->count = count;
+    prog->capacity = count > 0 ? count : 1;
+    prog->wide = NULL;
+    return prog;
+}
+
+/*
+ * Function: growProgram
+ *
+ * Doubles the room for instructions of a program being built. Returns 0
+ * on success, -1 if allocation fails.
+ */
+int growProgram(Program *prog) {
+    int capacity = 2 * prog->capacity;
+    Instruction *instructions = (Instruction *)realloc(prog->instructions, capacity * sizeof(Instruction));
+    if (!instructions) {
+        return -1;
+    }
+    prog->instructions = instructions;
+    if (prog->wide) {
+        Ticks *wide = (Ticks *)realloc(prog->wide, capacity * sizeof(Ticks));
+        if (!wide) {
+            return -1;
+        }
+        prog->wide = wide;
+    }
+    prog->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Function: programTime
+ *
+ * Returns the time of instruction i of a program
+ */
+Ticks programTime(const Program *prog, int i) {
+    return prog->wide ? prog->wide[i] : prog->instructions[i].time;
+}
+
+/*
+ * Function: setProgramTime
+ *
+ * Sets the time of instruction i of a program being built, instructions
+ * being set in order. Times are kept in the instructions while they all
+ * fit, and only a program with a longer one pays for a separate array of
+ * full times. Returns 0 on success, -1 if allocation fails.
+ */
+int setProgramTime(Program *prog, int i, Ticks time) {
+    if (!prog->wide && time >= -INT_MAX - 1 && time <= INT_MAX) {
+        prog->instructions[i].time = (int)time;
+        return 0;
+    }
+    if (!prog->wide) {
+        if (!(prog->wide = (Ticks *)malloc(prog->capacity * sizeof(Ticks)))) {
+            return -1;
+        }
+        for (int j = 0; j < i; j++) {
+            prog->wide[j] = prog->instructions[j].time;
+        }
+    }
+    prog->wide[i] = time;
+    return 0;
+}
+
+/*
+ * Function: releaseProgram
+ *
+ * Drops one hold on a program, freeing it when the last is dropped
+ */
+void releaseProgram(Program *prog) {
+    // holds may be taken and dropped on several threads at once
+    if (prog == NULL || __sync_sub_and_fetch(&prog->refs, 1) > 0) return;
+
+    free(prog->instructions);
+    free(prog->wide);
+    free(prog);
+}
+
+/*
+ * Function: attachProgram
+ *
+ * Makes a process run a shared program after its queued tasks
+ */
+void attachProgram(Process *p, Program *prog) {
+    releaseProgram(p->program);
+    __sync_fetch_and_add(&prog->refs, 1);
+    p->program = prog;
+    p->programNext = 0;
+}
+
+/*
+ * Function: expandProgram
+ *
+ * Turns the rest of a process's program into queued tasks and drops the
+ * program. Returns 0 on success, -1 if allocation fails.
+ */
+int expandProgram(Process *p) {
+    while (p->program != NULL && p->programNext < p->program->count) {
+        Task *t = createTask();
+        if (!t) {
+            return -1;
+        }
+        t->type = p->program->instructions[p->programNext].type;
+        t->time = programTime(p->program, p->programNext);
+        t->parent = p;
+        if (enqueueTask(p->tasks, t) != 0) {
+            freeTask(t);
+            return -1;
+        }
+        p->programNext++;
+    }
+    releaseProgram(p->program);
+    p->program = NULL;
+    p->programNext = 0;
+    return 0;
+}
+
 /************************************************************
  * Process & Process Queue Functions
  ************************************************************/
@@ -404,27 +749,27 @@ int isEmptyT(tQueue *q) {
   * Creates a new queue to hold processes
   */
 pQueue *createProcessQueue() {
-    pQueue *q = (pQueue *)malloc(sizeof(pQueue));
+    pQueue *q = (pQueue *)poolAlloc(POOL_PROCESS_QUEUE);
     if (q == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     q->head = NULL;
     q->tail = NULL;
     q->size = 0;
+    q->aging = 0;
+    q->level = -1;
     return q;
 }
 
 /*
  * Function: createProcess
  *
- * Creates a new process object
+ * Creates a new process object, or returns NULL if allocation fails
  */
 Process *createProcess() {
-    Process *p = (Process *)malloc(sizeof(Process));
+    Process *p = (Process *)poolAlloc(POOL_PROCESS);
     if (!p) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
     p->pid = 0;                     // process ID
@@ -432,33 +777,109 @@ Process *createProcess() {
     p->arrival = 0;                 // arrival time
     p->runtime = 0;                 // process runtime
     p->tasks = createTaskQueue();   // task queue
+    p->program = NULL;              // shared instructions
+    p->group = NULL;                // fair-share group
+    p->programNext = 0;             // next program instruction
+    p->tasksOut = 0;                // tasks taken and not yet freed
     p->numTasks = 0;                // number of tasks
     p->currentTask = 0;             // current task
     p->completions = 0;             // completions under quantum
     p->interrupts = 0;              // number of times interrupted
     p->ready = 0;                   // wait/ready time
+    p->deadline = 0;                // no deadline
+    p->deadlineSlot = -1;           // not in a deadline heap
     p->taskRunning = 0;             // flag for task running
     p->quantum = 0;                 // quantum time
     p->bursts = 0;                  // number of bursts
     p->endQueue = "B";              // final queue
+    p->nextOwned = NULL;            // next process owned by the engine
+    p->prevOwned = NULL;            // previous process owned by the engine
+    p->nodes = NULL;                // nodes holding the process
+
+    if (p->tasks == NULL) {
+        poolFree(POOL_PROCESS, p);
+        return NULL;
+    }
 
     return p;
 }
 
 /*
- * Function: enqueueProcess
+ * Function: addProcessHandle
  *
- * Adds a process to the end of the queue
+ * Records a node in its process's list of nodes. A process has at most a
+ * few nodes, and its nodes in any one queue are kept in queue order, so the
+ * first one found for a queue is the one nearest the head.
  */
-void enqueueProcess(pQueue *q, Process *p) {
-    pNode *newNode = (pNode *)malloc(sizeof(pNode));
-    if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+static void addProcessHandle(pNode *node, int first) {
+    Process *p = node->process;
+
+    if (first || p->nodes == NULL) {
+        node->sibling = p->nodes;
+        p->nodes = node;
+        return;
     }
 
-    newNode->process = p;
+    pNode *last = p->nodes;
+    while (last->sibling != NULL) {
+        last = last->sibling;
+    }
+    node->sibling = NULL;
+    last->sibling = node;
+}
+
+/*
+ * Function: findProcessNode
+ *
+ * Returns the node nearest the head of q that holds the process, or NULL
+ */
+static pNode *findProcessNode(pQueue *q, Process *p) {
+    pNode *node = p->nodes;
+    while (node != NULL && node->queue != q) {
+        node = node->sibling;
+    }
+    return node;
+}
+
+/*
+ * Function: unlinkProcessNode
+ *
+ * Unlinks a node from anywhere in its queue without freeing it
+ */
+static void unlinkProcessNode(pNode *node) {
+    pQueue *q = node->queue;
+    unlinkGroupProcess(node);
+    if (node->prev == NULL) {
+        q->head = node->next;
+    } else {
+        node->prev->next = node->next;
+    }
+
+    if (node->next == NULL) {
+        q->tail = node->prev;
+    } else {
+        node->next->prev = node->prev;
+    }
+    q->size--;
+
+    // drop the node from its process's list
+    pNode **link = &node->process->nodes;
+    while (*link != node) {
+        link = &(*link)->sibling;
+    }
+    *link = node->sibling;
+    node->queue = NULL;
+}
+
+/*
+ * Function: appendProcessNode
+ *
+ * Links an existing node to the end of the queue
+ */
+static void appendProcessNode(pQueue *q, pNode *newNode) {
     newNode->next = NULL;
+    newNode->prev = q->tail;
+    newNode->queue = q;
 
     if (q->head == NULL) {
         q->head = newNode;
@@ -469,48 +890,72 @@ void enqueueProcess(pQueue *q, Process *p) {
     }
 
     q->size++;
+    addProcessHandle(newNode, 0);
+    linkGroupProcess(newNode);
+}
+
+/*
+ * Function: enqueueProcess
+ *
+ * Adds a process to the end of the queue. Returns 0 on success, -1 if the
+ * node cannot be allocated.
+ */
+int enqueueProcess(pQueue *q, Process *p) {
+    pNode *newNode = (pNode *)poolAlloc(POOL_PROCESS_NODE);
+    if (!newNode) {
+        return -1;
+    }
+
+    newNode->process = p;
+    appendProcessNode(q, newNode);
+    return 0;
 }
 
 /*
  * Function: frontloadProcess
  *
- * Adds a process to the front of the queue
+ * Adds a process to the front of the queue. Returns 0 on success, -1 if
+ * the node cannot be allocated.
  *
  * -- not currently used --
  */
-void frontloadProcess(pQueue *q, Process *p) {
-    pNode *newNode = (pNode *)malloc(sizeof(pNode));
+int frontloadProcess(pQueue *q, Process *p) {
+    pNode *newNode = (pNode *)poolAlloc(POOL_PROCESS_NODE);
     if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     // Add the process to the front of the queue
     newNode->process = p;
     newNode->next = q->head;
-    q->head = newNode;
+    newNode->prev = NULL;
+    newNode->queue = q;
 
-    if (q->tail == NULL) {
+    if (q->head == NULL) {
         q->tail = newNode;
+    } else {
+        q->head->prev = newNode;
     }
+    q->head = newNode;
 
     q->size++;
+    addProcessHandle(newNode, 1);
+    linkGroupProcess(newNode);
+    return 0;
 }
 
 /*
- * Function: priorityEnqueueProcess
+ * Function: insertProcessNode
  *
- * Adds a process to the queue based on priority
+ * Links an existing node into the queue based on priority. The node goes
+ * ahead of any node of equal priority, including other nodes of the same
+ * process.
  */
-void priorityEnqueueProcess(pQueue *q, Process *p) {
-    pNode *newNode = (pNode *)malloc(sizeof(pNode));
-    if (!newNode) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-
-    newNode->process = p;
+static void insertProcessNode(pQueue *q, pNode *newNode) {
+    Process *p = newNode->process;
     newNode->next = NULL;
+    newNode->prev = NULL;
+    newNode->queue = q;
 
     if (q->head == NULL) { // If the queue is empty
         q->head = newNode;
@@ -519,24 +964,48 @@ void priorityEnqueueProcess(pQueue *q, Process *p) {
         pNode *current = q->head;
         pNode *prev = NULL;
 
-        // Find the correct position to insert the new node
+        // Find the correct position to insert the new node; queued processes
+        // do not wait alike, so aging only counts where they are compared
         while (current != NULL && current->process->priority > p->priority) {
             prev = current;
             current = current->next;
         }
         if (prev == NULL) {
             newNode->next = q->head;
+            q->head->prev = newNode;
             q->head = newNode;
         } else if (current == NULL) {
+            newNode->prev = q->tail;
             q->tail->next = newNode;
             q->tail = newNode;
         } else {
             prev->next = newNode;
+            newNode->prev = prev;
             newNode->next = current;
+            current->prev = newNode;
         }
     }
 
     q->size++;
+    addProcessHandle(newNode, 1);
+    linkGroupProcess(newNode);
+}
+
+/*
+ * Function: priorityEnqueueProcess
+ *
+ * Adds a process to the queue based on priority. Returns 0 on success, -1
+ * if the node cannot be allocated.
+ */
+int priorityEnqueueProcess(pQueue *q, Process *p) {
+    pNode *newNode = (pNode *)poolAlloc(POOL_PROCESS_NODE);
+    if (!newNode) {
+        return -1;
+    }
+
+    newNode->process = p;
+    insertProcessNode(q, newNode);
+    return 0;
 }
 
 /*
@@ -551,10 +1020,8 @@ Process *dequeueProcess(pQueue *q) {
 
     pNode *temp = q->head;
     Process *p = temp->process;
-    q->head = q->head->next;
-    free(temp);
-
-    q->size -= 1;
+    unlinkProcessNode(temp);
+    poolFree(POOL_PROCESS_NODE, temp);
 
     return p;
 }
@@ -562,78 +1029,52 @@ Process *dequeueProcess(pQueue *q) {
 /*
  * Function: promoteProcess
  *
- * Removes a process from the queue and re-enqueues it based on priority
+ * Removes a process from one level's queue and re-enqueues it in another
+ * based on priority. The process's node is found through its handles, not
+ * by a search. Returns 0 on success, -1 if the process is not in the queue.
  */
- void promoteProcess(pQueue *queueB, pQueue *queueA, Process *p) {
-    pNode *prev = NULL;
-    pNode *current = queueB->head;
-
-    // Locate the process in the current queue
-    while (current != NULL) {
-        if (current->process == p) {
-            if (prev == NULL) { // Process is at the head of the queue
-                queueB->head = current->next;
-                if (queueB->head == NULL) { // Process is the only one in the queue
-                    queueB->tail = NULL;
-                }
-            } else {
-                prev->next = current->next;
-                if (current->next == NULL) {
-                    queueB->tail = prev; // Process is at the tail of the queue
-                }
-            }
-            queueB->size--;
-
-            // Re-enqueue the process based on priority
-            priorityEnqueueProcess(queueA, p);
-            p->endQueue = "A";
-            free(current); // Free the node, but not the process
-
-            return;
-        }
-        prev = current;
-        current = current->next;
+int promoteProcess(pQueue *from, pQueue *to, Process *p) {
+    pNode *current = findProcessNode(from, p);
+    if (current == NULL) {
+        printf("PROMOTE PROCESS: Process not found in queue.\n");
+        return -1;
     }
-    printf("PROMOTE PROCESS: Process not found in queue.\n");
- }
+
+    // Re-enqueue the process (reusing its node) based on priority
+    unlinkProcessNode(current);
+    insertProcessNode(to, current);
+    return 0;
+}
 
 /*
  * Function: endProcess
  *
- * Removes a process from the queue and enqueues it to the exit queue
+ * Removes a process from the queue and enqueues it to the exit queue. The
+ * process's node is found through its handles, not by a search.
  */
 void endProcess(pQueue *q, pQueue *exit, Process *p) {
-    pNode *prev = NULL;
-    pNode *current = q->head;
+    pNode *current = findProcessNode(q, p);
+    if (current == NULL) {
+        fprintf(stderr, "END PROCESS: Process not found in queue.\n");
+        return;
+    }
 
-    // Locate the process in the current queue
-    while (current != NULL) {
-        if (current->process == p) {
-            if (prev == NULL) { // Process is at the head of the queue
-                q->head = current->next;
-                if (q->head == NULL) { // Process is the only one in the queue
-                    q->tail = NULL;
-                }
-            } else {
-                prev->next = current->next;
-                if (current->next == NULL) {
-                    q->tail = prev; // Process is at the tail of the queue
-                }
-            }
-            q->size--;
+    // Move the process (and its node) to the exit queue
+    unlinkProcessNode(current);
+    appendProcessNode(exit, current);
+}
 
-            // Enqueue the process to the exit queue
-            enqueueProcess(exit, p);
-            free(current); // Free the node, but not the process
-            return;
-        }
-        // Move to the next node
-        prev = current;
-        current = current->next;
+/*
+ * Function: unlinkProcess
+ *
+ * Unlinks and frees every node holding a process, in whichever queues
+ */
+void unlinkProcess(Process *p) {
+    while (p->nodes != NULL) {
+        pNode *node = p->nodes;
+        unlinkProcessNode(node);
+        poolFree(POOL_PROCESS_NODE, node);
     }
-
-    fprintf(stderr, "END PROCESS: Process not found in queue.\n");
-    return;
 }
 
 /*
@@ -654,7 +1095,7 @@ void *peekProcess(pQueue *q) {
  *
  * Updates the wait/ready time for each process in the queue
  */
-void updateProcessQueue(pQueue *q, int runtime) {
+void updateProcessQueue(pQueue *q, Ticks runtime) {
     pNode *current = q->head;
     while (current != NULL) {
         Process *p = current->process;
@@ -666,6 +1107,32 @@ void updateProcessQueue(pQueue *q, int runtime) {
     }
 }
 
+/*
+ * Function: freeProcess
+ *
+ * Frees a process that is no longer in any queue, along with its tasks
+ */
+void freeProcess(Process *p) {
+    if (p == NULL) return;
+
+    freeTaskQueue(p->tasks);
+    releaseProgram(p->program);
+    releaseGroups(p->group != NULL ? p->group->tree : NULL);
+    poolFree(POOL_PROCESS, p);
+}
+
+/*
+ * Function: freeProcessQueue
+ *
+ * Frees a process queue and its nodes, but not the processes
+ */
+void freeProcessQueue(pQueue *q) {
+    if (q == NULL) return;
+
+    while (dequeueProcess(q) != NULL);
+    poolFree(POOL_PROCESS_QUEUE, q);
+}
+
 /*
  * Function: isEmptyP
  *
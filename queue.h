@@ -10,25 +10,53 @@
  #ifndef QUEUE_H
  #define QUEUE_H
 
+ // Simulated time and the counters that grow with it; printed with %lld
+ typedef long long Ticks;
+
  // forward declaration of structs
  struct Task;
  struct Process;
  struct Stats;
  struct tQueue;
  struct pQueue;
+ struct ReadyDeadlines;
  struct tNode;
  struct pNode;
+ struct Group;
+
+ // Struct for one instruction of a template
+ typedef struct Instruction {
+     char type;                 // 'e' = execution, 'i' = I/O, 't' = terminate
+     int time;                  // time to execute or I/O time, unless the program is wide
+ } Instruction;
+
+ // Struct for an immutable instruction sequence shared by processes
+ typedef struct Program {
+     int refs;                  // number of holders of the program
+     int count;                 // number of instructions
+     int capacity;              // instructions allocated
+     Instruction *instructions; // instructions in execution order
+     Ticks *wide;               // every time, once one does not fit an Instruction, else NULL
+ } Program;
 
  // Struct for task node
  typedef struct tNode {
      struct Task *task;         // pointer to a task object
      struct tNode *next;        // pointer to the next node in the queue
+     struct tNode *prev;        // pointer to the previous node in the queue
+     struct tNode *groupNext;   // next node of the same group at the level, when grouped
+     struct tNode *groupPrev;   // previous node of the same group at the level
  } tNode;
 
  // Struct for process node
  typedef struct pNode {
      struct Process *process;   // pointer to a process object
      struct pNode *next;        // pointer to the next node in the queue
+     struct pNode *prev;        // pointer to the previous node in the queue
+     struct pQueue *queue;      // queue the node is linked into
+     struct pNode *sibling;     // next node of the same process
+     struct pNode *groupNext;   // next node of the same group at the level, when grouped
+     struct pNode *groupPrev;   // previous node of the same group at the level
  } pNode;
 
  // Struct for task queue
@@ -36,6 +64,9 @@
      tNode *head;               // pointer to the first node in the queue
      tNode *tail;               // pointer to the last node in the queue
      int size;                  // number of nodes in the queue
+     int aging;                 // ready ticks per point of priority aging, 0 = none
+     int level;                 // engine level the queue serves, -1 for none
+     struct ReadyDeadlines *deadlines; // its tasks with a deadline by deadline, NULL if not kept
  } tQueue;
 
  // Struct for process queue
@@ -43,36 +74,50 @@
      pNode *head;               // pointer to the first node in the queue
      pNode *tail;               // pointer to the last node in the queue
      int size;                  // number of nodes in the queue
+     int aging;                 // ready ticks per point of priority aging, 0 = none
+     int level;                 // engine level the queue serves, -1 for none
  } pQueue;
 
  // Struct for task object
  typedef struct Task {
-     char type;                 // 'e' = execution, 'i' = I/O, 't' = terminate
-     int time;                  // time to execute or I/O time
+     Ticks time;                // time to execute or I/O time
+     struct Process *parent;    // pointer to parent process
+     struct tNode *node;        // node holding the task, NULL if not queued
+     int deadlineSlot;          // index in its ready queue's deadline heap, -1 if not in one
+     Ticks readySince;          // time the task entered its ready queue, for aging
      int wait;                  // ready/wait time --- not used but will seg fault if removed
      int completed;             // 0 = not completed, 1 = completed
      int interrupts;            // number of interrupts
-     struct Process *parent;    // pointer to parent process
+     char type;                 // 'e' = execution, 'i' = I/O, 't' = terminate
  } Task;
 
  // Struct for process object
  typedef struct Process {
      int pid;                   // process id
      int priority;              // process priority
-     int arrival;               // arrival time
-     int runtime;               // total runtime
+     Ticks arrival;             // arrival time
+     Ticks runtime;             // total runtime
+     Ticks ready;               // time process is ready/waiting to execute
+     Ticks deadline;            // ticks after arrival to complete within, 0 = none
+     int deadlineSlot;          // index in the engine's deadline heap, -1 if not in it
 
      tQueue *tasks;             // queue of tasks
+     Program *program;          // shared instructions run after tasks, NULL if none
+     struct Group *group;       // fair-share group, NULL if the trace names none
+     int programNext;           // index of the next program instruction to run
+     int tasksOut;              // tasks taken from the process and not yet freed
      int numTasks;              // number of tasks
      int currentTask;           // index of current task
      int completions;           // number of tasks completed under quantum
 
-     int interrupts;            // number of interrupts
-     int ready;                 // time process is ready/waiting to execute
+     int interrupts;            // number of quantum expiries at the current level
      int taskRunning;           // flag to indicate a task is running
      int quantum;               // quantum time for execution tasks
      int bursts;                // number of bursts for execution tasks
      char *endQueue;            // final queue for process
+     pNode *nodes;              // nodes holding the process, in queue order per queue
+     struct Process *nextOwned; // next process owned by the same engine
+     struct Process *prevOwned; // previous process owned by the same engine
  } Process;
 
 
@@ -80,33 +125,54 @@
   * Function Prototypes -- TASKS
   **************************************************************************/
  Task *createTask();
+ void freeTask(Task *t);
+ void freeTaskQueue(tQueue *q);
  void appendTask(Process *p, Task newTask); // deprecated
  void endTask(Task *t, struct Stats *s); // deprecated
  tQueue *createTaskQueue();
- void enqueueTask(tQueue *q, Task *t);
- void frontloadTask(tQueue *q, Task *t);
- void priorityEnqueueTask(tQueue *q, Task *t);
+ int enqueueTask(tQueue *q, Task *t);
+ int frontloadTask(tQueue *q, Task *t);
+ int priorityEnqueueTask(tQueue *q, Task *t);
  Task *dequeueTask(tQueue *q);
  void removeTask(tQueue *q, Task *t);
+void requeueTask(tQueue *q, Task *t);
  void *peekTask(tQueue *q);
- Task *getNextTask(pQueue *q, tQueue *ready, int runtime);
- int preemptionCheck (pQueue *q, tQueue *ready, Task *t, int runtime);
- Task *getNextTaskPreemptive (pQueue *q, tQueue *ready, int runtime);
+ Ticks readyRank(const Task *t, int aging);
+ Ticks processRank(const Process *p, int aging);
+Task *getNextTask(pQueue *q, tQueue *ready, Ticks runtime);
+ int preemptionCheck (pQueue *q, tQueue *ready, Task *t, Ticks runtime);
+ Task *getNextTaskPreemptive (pQueue *q, tQueue *ready, Ticks runtime);
  void updateIOTasks(tQueue *q);
  int isEmptyT(tQueue *q);
+ Task *takeTask(Process *p);
+ int hasTask(Process *p);
+
+ /**************************************************************************
+  * Function Prototypes -- PROGRAMS
+  **************************************************************************/
+ Program *createProgram(int count);
+ int growProgram(Program *prog);
+ Ticks programTime(const Program *prog, int i);
+ int setProgramTime(Program *prog, int i, Ticks time);
+ void releaseProgram(Program *prog);
+ void attachProgram(Process *p, Program *prog);
+ int expandProgram(Process *p);
 
  /**************************************************************************
   * Function Prototypes -- PROCESSES
   **************************************************************************/
  Process *createProcess();
+ void freeProcess(Process *p);
  pQueue *createProcessQueue();
- void enqueueProcess(pQueue *q, Process *p);
- void frontloadProcess(pQueue *q, Process *p);
- void priorityEnqueueProcess(pQueue *q, Process *p);
+ void freeProcessQueue(pQueue *q);
+ int enqueueProcess(pQueue *q, Process *p);
+ int frontloadProcess(pQueue *q, Process *p);
+ int priorityEnqueueProcess(pQueue *q, Process *p);
  Process *dequeueProcess(pQueue *q);
- void promoteProcess(pQueue *queueB, pQueue *queueA, Process *p);
+ int promoteProcess(pQueue *from, pQueue *to, Process *p);
  void endProcess(pQueue *q, pQueue *exit, Process *p);
- void updateProcessQueue(pQueue *q, int runtime);
+ void unlinkProcess(Process *p);
+ void updateProcessQueue(pQueue *q, Ticks runtime);
  void *peekProcess(pQueue *q);
  int isEmptyP(pQueue *q);
 
@@ -0,0 +1,1086 @@
+/*
+ * reference.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the reference engine: runPreemption and
+ * runNonPreemption as they were before the engine was generalized, with
+ * private copies of the queue operations they used. Only three things
+ * differ from the original: the run stops after a limit of loop
+ * iterations, the results are left in the Reference instead of printed,
+ * and finished or dropped tasks are freed instead of leaked. None of
+ * these changes the schedule.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reference.h"
+#include "pool.h"
+#include "group.h"
+
+/************************************************************
+ * Frozen Queue Operations
+ ************************************************************/
+
+/*
+ * Function: refNode
+ *
+ * Allocates a queue node of the given kind, or exits if allocation fails
+ */
+static void *refNode(PoolKind kind) {
+    void *node = poolAlloc(kind);
+    if (!node) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return node;
+}
+
+/*
+ * Function: refEnqueueTask
+ *
+ * Adds a task to the end of the queue
+ */
+static void refEnqueueTask(tQueue *q, Task *t) {
+    tNode *newNode = (tNode *)refNode(POOL_TASK_NODE);
+    newNode->task = t;
+    newNode->next = NULL;
+
+    if (q->head == NULL) {
+        q->head = newNode;
+        q->tail = newNode;
+    } else {
+        q->tail->next = newNode;
+        q->tail = newNode;
+    }
+
+    q->size++;
+}
+
+/*
+ * Function: refPriorityEnqueueTask
+ *
+ * Adds a task to the queue based on the priority of the parent process
+ */
+static void refPriorityEnqueueTask(tQueue *q, Task *t) {
+    tNode *newNode = (tNode *)refNode(POOL_TASK_NODE);
+    newNode->task = t;
+    newNode->next = NULL;
+
+    // if the queue is empty, add the task to the head
+    if (q->head == NULL) {
+        q->head = newNode;
+        q->tail = newNode;
+    } else {
+        tNode *current = q->head;
+        tNode *prev = NULL;
+        // otherwise, add the task based on the priority of the parent process
+        while (current != NULL && current->task->parent->priority > t->parent->priority) {
+            prev = current;
+            current = current->next;
+        }
+
+        if (prev == NULL) {
+            newNode->next = q->head;
+            q->head = newNode;
+        } else if (current == NULL) {
+            q->tail->next = newNode;
+            q->tail = newNode;
+        } else {
+            prev->next = newNode;
+            newNode->next = current;
+        }
+    }
+
+    q->size++;
+}
+
+/*
+ * Function: refDequeueTask
+ *
+ * Removes the first task from the queue
+ */
+static Task *refDequeueTask(tQueue *q) {
+    if (q->head == NULL) {
+        return NULL;
+    }
+
+    tNode *temp = q->head;
+    Task *t = temp->task;
+
+    q->head = q->head->next;
+    poolFree(POOL_TASK_NODE, temp);
+
+    q->size -= 1;
+
+    return t;
+}
+
+/*
+ * Function: refPeekTask
+ *
+ * Returns the first task in the queue without removing it
+ */
+static Task *refPeekTask(tQueue *q) {
+    if (q->head == NULL) {
+        return NULL;
+    }
+
+    return q->head->task;
+}
+
+/*
+ * Function: refUpdateIOTasks
+ *
+ * Updates the time remaining for each I/O task currently running
+ * and removes any completed tasks from the queue
+ */
+static void refUpdateIOTasks(tQueue *q) {
+    tNode *prev = NULL;
+    for (tNode *current = q->head; current != NULL; ) {
+        Task *t = current->task;
+        // Decrement time if task not yet completed
+        if (t->time > 0) {
+            t->time--;
+            prev = current;
+            current = current->next; // Move to the next node
+        } else { // Task is complete
+            t->parent->taskRunning = 0;
+            t->parent->currentTask++;
+
+            // Detach the current node from the queue
+            if (prev == NULL) {
+                q->head = current->next; // Current node is the head
+                if (q->head == NULL) { // If the queue is now empty
+                    q->tail = NULL;
+                }
+            } else { // Current node is not the head
+                prev->next = current->next;
+                if (current->next == NULL) {
+                    q->tail = prev;
+                }
+            }
+
+            // Prepare to free the current node and move to the next
+            tNode *remove = current;
+            current = current->next; // Update node before freeing
+            poolFree(POOL_TASK_NODE, remove);
+            freeTask(t);
+        }
+    }
+}
+
+/*
+ * Function: refGetNextTask
+ *
+ * Returns the next task to be executed based on the current runtime
+ * and whether a process is currently running
+ */
+static Task *refGetNextTask(pQueue *q, tQueue *ready, Ticks runtime) {
+    // Check if there are any tasks in the ready queue
+    if (!isEmptyT(ready)) {
+        Task *nextTask = refDequeueTask(ready);
+        if (nextTask) { // If a task is found, return it
+            nextTask->parent->taskRunning = 1;
+            return nextTask;
+        }
+    }
+
+    // Check the process queue if no task in ready queue
+    pNode *current = q->head;
+    while (current != NULL) {
+        Process *p = current->process;
+        // Ensure the process has arrived and has tasks to run
+        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
+            Task *t = refDequeueTask(p->tasks);
+            if (t) { // If a task is found, return it
+                t->parent->taskRunning = 1; // Set the process to running
+
+                return t;
+            }
+        }
+        current = current->next;
+    }
+
+    // If no tasks found return NULL
+    return NULL;
+}
+
+/*
+ * Function: refPreemptionCheck
+ *
+ * Checks if a task should be preempted based on the current runtime
+ * and the tasks in the process queue
+ */
+static int refPreemptionCheck(pQueue *q, tQueue *ready, Task *t, Ticks runtime) {
+    pNode *current = q->head;
+    while (current != NULL) {
+        Process *p = current->process;
+        // Ensure the process has arrived and has tasks to run
+        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
+            Task *nextTask = refPeekTask(ready);
+            if (nextTask && nextTask->parent->priority > t->parent->priority) {
+                return 1; // should preempt
+            }
+        }
+        current = current->next;
+    }
+    return 0; // should not preempt
+}
+
+/*
+ * Function: refGetNextTaskPreemptive
+ *
+ * Returns the next task to be executed based on the current runtime
+ * and process priority
+ */
+static Task *refGetNextTaskPreemptive(pQueue *q, tQueue *ready, Ticks runtime) {
+    // Check if there are any tasks in the ready queue
+    if (!isEmptyT(ready)) {
+        Task *currentTask = refDequeueTask(ready);
+        Task *nextTask = refPeekTask(ready);
+        if (!nextTask) { // If no other tasks in the ready queue
+            if (currentTask) { // return the current task
+                currentTask->parent->taskRunning = 1;
+                return currentTask;
+            }
+        } else if (currentTask->parent->priority < nextTask->parent->priority) {
+            refPriorityEnqueueTask(ready, currentTask);
+            currentTask = refDequeueTask(ready);
+            if (currentTask) { // If a task is found, return it
+                currentTask->parent->taskRunning = 1;
+                return currentTask;
+            }
+        } else {
+            // the original drops the task here; it is unreachable, so free it
+            freeTask(currentTask);
+        }
+    }
+
+    // Check the process queue if no task in ready queue
+    pNode *current = q->head;
+    while (current != NULL) {
+        Process *p = current->process;
+        Process *nextProcess = (current->next != NULL) ? current->next->process : NULL;
+
+        // Ensure the process has arrived and has tasks to run
+        if (p->arrival <= runtime && p->taskRunning == 0 && !isEmptyT(p->tasks)) {
+            if (nextProcess && nextProcess->arrival <= runtime && nextProcess->taskRunning == 0 && !isEmptyT(nextProcess->tasks)) {
+                if (p->priority < nextProcess->priority) {
+                    Task *t = refDequeueTask(p->tasks);
+                    if (t) {
+                        t->parent->taskRunning = 1; // Set the process to running
+                        return t;
+                    }
+                } else {
+                    Task *t = refDequeueTask(nextProcess->tasks);
+                    if (t) {
+                        t->parent->taskRunning = 1; // Set the process to running
+                        return t;
+                    }
+                }
+            } else {
+                Task *t = refDequeueTask(p->tasks);
+                if (t) { // If a task is found, return it
+                    t->parent->taskRunning = 1; // Set the process to running
+                    return t;
+                }
+            }
+        }
+        current = current->next;
+    }
+
+    // If no tasks found, return NULL
+    return NULL;
+}
+
+/*
+ * Function: refEnqueueProcess
+ *
+ * Adds a process to the end of the queue
+ */
+static void refEnqueueProcess(pQueue *q, Process *p) {
+    pNode *newNode = (pNode *)refNode(POOL_PROCESS_NODE);
+    newNode->process = p;
+    newNode->next = NULL;
+
+    if (q->head == NULL) {
+        q->head = newNode;
+        q->tail = newNode;
+    } else {
+        q->tail->next = newNode;
+        q->tail = newNode;
+    }
+
+    q->size++;
+}
+
+/*
+ * Function: refPriorityEnqueueProcess
+ *
+ * Adds a process to the queue based on priority
+ */
+static void refPriorityEnqueueProcess(pQueue *q, Process *p) {
+    pNode *newNode = (pNode *)refNode(POOL_PROCESS_NODE);
+    newNode->process = p;
+    newNode->next = NULL;
+
+    if (q->head == NULL) { // If the queue is empty
+        q->head = newNode;
+        q->tail = newNode;
+    } else {
+        pNode *current = q->head;
+        pNode *prev = NULL;
+
+        // Find the correct position to insert the new node
+        while (current != NULL && current->process->priority > p->priority) {
+            prev = current;
+            current = current->next;
+        }
+        if (prev == NULL) {
+            newNode->next = q->head;
+            q->head = newNode;
+        } else if (current == NULL) {
+            q->tail->next = newNode;
+            q->tail = newNode;
+        } else {
+            prev->next = newNode;
+            newNode->next = current;
+        }
+    }
+
+    q->size++;
+}
+
+/*
+ * Function: refDequeueProcess
+ *
+ * Removes a process from the front of the queue
+ */
+static Process *refDequeueProcess(pQueue *q) {
+    if (q->head == NULL) {
+        return NULL;
+    }
+
+    pNode *temp = q->head;
+    Process *p = temp->process;
+    q->head = q->head->next;
+    poolFree(POOL_PROCESS_NODE, temp);
+
+    q->size -= 1;
+
+    return p;
+}
+
+/*
+ * Function: refUnlinkProcess
+ *
+ * Removes the first node of process p from the queue, returning 1 if the
+ * process was found
+ */
+static int refUnlinkProcess(pQueue *q, Process *p) {
+    pNode *prev = NULL;
+    pNode *current = q->head;
+
+    // Locate the process in the current queue
+    while (current != NULL) {
+        if (current->process == p) {
+            if (prev == NULL) { // Process is at the head of the queue
+                q->head = current->next;
+                if (q->head == NULL) { // Process is the only one in the queue
+                    q->tail = NULL;
+                }
+            } else {
+                prev->next = current->next;
+                if (current->next == NULL) {
+                    q->tail = prev; // Process is at the tail of the queue
+                }
+            }
+            q->size--;
+            poolFree(POOL_PROCESS_NODE, current); // Free the node, but not the process
+            return 1;
+        }
+        prev = current;
+        current = current->next;
+    }
+    return 0;
+}
+
+/*
+ * Function: refPromoteProcess
+ *
+ * Removes a process from queue B and re-enqueues it in queue A based on
+ * priority
+ */
+static void refPromoteProcess(pQueue *queueB, pQueue *queueA, Process *p) {
+    if (refUnlinkProcess(queueB, p)) {
+        refPriorityEnqueueProcess(queueA, p);
+        p->endQueue = "A";
+        return;
+    }
+    printf("PROMOTE PROCESS: Process not found in queue.\n");
+}
+
+/*
+ * Function: refEndProcess
+ *
+ * Removes a process from the queue and enqueues it to the exit queue
+ */
+static void refEndProcess(pQueue *q, pQueue *exit, Process *p) {
+    if (refUnlinkProcess(q, p)) {
+        refEnqueueProcess(exit, p);
+        return;
+    }
+    fprintf(stderr, "END PROCESS: Process not found in queue.\n");
+}
+
+/*
+ * Function: refUpdateProcessQueue
+ *
+ * Updates the wait/ready time for each process in the queue
+ */
+static void refUpdateProcessQueue(pQueue *q, Ticks runtime) {
+    pNode *current = q->head;
+    while (current != NULL) {
+        Process *p = current->process;
+        // If the process is not running and has arrived, increment ready time
+        if (p->taskRunning == 0 && p->arrival < runtime) {
+            p->ready++;
+        }
+        current = current->next;
+    }
+}
+
+/*
+ * Function: refAllQueuesEmpty
+ *
+ * Helper function to check if all queues are empty
+ */
+static int refAllQueuesEmpty(Reference *ref) {
+    return isEmptyP(ref->queueB) && isEmptyP(ref->queueA) && isEmptyT(ref->readyQueueA) &&
+           isEmptyT(ref->readyQueueB) && isEmptyT(ref->ioQueue);
+}
+
+/*
+ * Function: refPastLimit
+ *
+ * Counts one loop iteration and returns 1 once the limit is exceeded (a
+ * limit of 0 never stops the run)
+ */
+static int refPastLimit(Reference *ref, long limit) {
+    return ++ref->iterations > limit && limit > 0;
+}
+
+/************************************************************
+ * Frozen Engines
+ ************************************************************/
+
+/*
+ * Function: refRunPreemption
+ *
+ * Runs the simulation for preemption scheduling. Returns 0 once all
+ * queues are empty, 1 if the iteration limit stopped the run.
+ */
+static int refRunPreemption(Reference *ref, int quantumA, int quantumB, long limit) {
+    Stats *stats = ref->stats;
+    pQueue *queueA = ref->queueA, *queueB = ref->queueB, *exitQueue = ref->exitQueue;
+    tQueue *readyQueueA = ref->readyQueueA, *readyQueueB = ref->readyQueueB, *ioQueue = ref->ioQueue;
+    Task *t = NULL;
+    Process *p = NULL;
+    int cpu = 0;
+
+    // main simulation loop for preemption
+    while (!refAllQueuesEmpty(ref)) {
+
+        // prioritize queue A
+        if (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+
+            while (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+                if (refPastLimit(ref, limit)) {
+                    ref->task = cpu ? t : NULL;
+                    return 1;
+                }
+
+                // update I/O tasks to simulate concurrent execution
+                if (!isEmptyT(ioQueue)) {
+                    refUpdateIOTasks(ioQueue);
+                }
+
+                if (cpu == 0) {
+                    // fetch next task and set CPU flag
+                    t = refGetNextTaskPreemptive(queueA, readyQueueA, stats->runtime);
+                    if (t != NULL) {
+                        cpu = 1;
+                        t->parent->taskRunning = 1;
+                    }
+
+                    break;
+                } else {
+                    p = t->parent;
+                    if (refPreemptionCheck(queueB, readyQueueB, t, stats->runtime)) {
+                        t->interrupts++;
+                        p->taskRunning = 0;
+                        refPriorityEnqueueTask(readyQueueB, t);
+                        t = refGetNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
+                    } else {
+                        switch (t->type) {
+                            case 'i':
+                                if (p->quantum > 0) { // if process has quantum left
+                                    p->quantum--;
+                                    if (p->quantum > 0) {
+                                        p->completions++;
+                                    } else { // reset completions
+                                        p->completions = 0;
+                                    }
+                                    stats->instructions++;
+                                    refEnqueueTask(ioQueue, t); // add to I/O queue
+                                } else {
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    p->quantum = quantumA;
+                                    refPriorityEnqueueTask(readyQueueA, t);
+                                }
+                                cpu = 0;
+                                break;
+                            case 'e':
+                                if (t->time == 0) { // task completed
+                                    p->taskRunning = 0;
+                                    p->currentTask++;
+                                    stats->instructions++;
+                                    freeTask(t);
+                                    cpu = 0;
+                                } else if (p->quantum <= 0) { // quantum used up
+                                    p->completions = 0;
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    p->quantum = quantumA;
+                                    refPriorityEnqueueTask(readyQueueA, t);
+                                    cpu = 0;
+                                } else {
+                                    t->time--;
+                                    p->quantum--;
+                                }
+                                break;
+                            default: // 't' - terminate process
+                                if (p->quantum > 0) {
+                                    p->quantum--;
+                                    stats->instructions++;
+                                    stats->runtime++;
+                                    p->taskRunning = 0;
+                                    p->runtime = stats->runtime;
+                                    stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
+                                    stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
+                                    stats->totalWait += p->ready;
+                                    refEndProcess(queueA, exitQueue, p);
+                                    freeTask(t);
+                                } else {
+                                    p->completions = 0;
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    p->quantum = quantumA;
+                                    refPriorityEnqueueTask(readyQueueA, t);
+                                }
+                                cpu = 0;
+                                break;
+                        }
+                    }
+                }
+
+                // update queueA wait/ready times
+                if (!isEmptyP(queueA)) {
+                    refUpdateProcessQueue(queueA, stats->runtime);
+                }
+
+                // update queueB wait/ready times
+                if (!isEmptyP(queueB)) {
+                    refUpdateProcessQueue(queueB, stats->runtime);
+                }
+
+                stats->runtime++;
+            }
+        } else { // if queue A is empty
+
+            while (!isEmptyP(queueB) || !isEmptyT(ioQueue) || !isEmptyT(readyQueueB)) {
+                if (refPastLimit(ref, limit)) {
+                    ref->task = cpu ? t : NULL;
+                    return 1;
+                }
+
+                // update I/O queue to simulate concurrent execution
+                if (!isEmptyT(ioQueue)) {
+                    refUpdateIOTasks(ioQueue);
+                }
+
+                if (cpu == 0) {
+                    // fetch next task and set CPU flag
+                    t = refGetNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
+                    if (t != NULL) {
+                        cpu = 1;
+                        t->parent->taskRunning = 1;
+                    }
+
+                    break;
+                } else {
+                    p = t->parent; // identify parent process
+                    if (refPreemptionCheck(queueB, readyQueueB, t, stats->runtime)) {
+                        t->interrupts++;
+                        p->taskRunning = 0;
+
+                        if (t->interrupts == 3) { // promote to queue A
+                            refPromoteProcess(queueB, queueA, p);
+                            p->quantum = quantumA;
+                            freeTask(t); // the original drops the task here
+                        } else {
+                            refPriorityEnqueueTask(readyQueueB, t);
+                        }
+
+                        t = refGetNextTaskPreemptive(queueB, readyQueueB, stats->runtime);
+                    } else {
+                        switch (t->type) {
+                            case 'i':
+                                if (p->quantum > 0) { // if process has quantum left
+                                    p->quantum--;
+                                    if (p->quantum > 0) {
+                                        p->completions++;
+                                        if (p->completions == 3) { // promote to queue A
+                                            p->quantum = quantumA;
+                                            refPriorityEnqueueProcess(queueA, p);
+                                            p->endQueue = "A";
+                                        }
+                                    } else { // reset completions
+                                        p->completions = 0;
+                                    }
+                                    stats->instructions++;
+                                    refEnqueueTask(ioQueue, t); // add to I/O queue
+                                } else {
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    if (t->interrupts == 3) { // promote to queue A
+                                        p->quantum = quantumA;
+                                        refPromoteProcess(queueB, queueA, p);
+                                        refPriorityEnqueueTask(readyQueueA, t);
+                                    } else { // reset completions
+                                        p->quantum = quantumB;
+                                        p->completions = 0;
+                                        refPriorityEnqueueTask(readyQueueB, t);
+                                    }
+                                }
+                                cpu = 0;
+                                break;
+                            case 'e':
+                                if (t->time == 0) { // task completed
+                                    p->taskRunning = 0;
+                                    p->currentTask++;
+                                    stats->instructions++;
+                                    if (p->quantum > 0) { // if quantum not used up
+                                        p->completions++;
+                                        if (p->completions == 3) { // promote to queue A
+                                            p->quantum = quantumA;
+                                            refPromoteProcess(queueB, queueA, p);
+                                        }
+                                    } else { // reset completions
+                                        p->completions = 0;
+                                    }
+                                    freeTask(t);
+                                    cpu = 0;
+                                } else if (p->quantum == 0) { // quantum used up
+                                    p->completions = 0;
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    if (t->interrupts == 3) { // promote to queue A
+                                        p->quantum = quantumA;
+                                        refPromoteProcess(queueB, queueA, p);
+                                        refPriorityEnqueueTask(readyQueueA, t);
+                                    } else { // put back in ready queue
+                                        p->quantum = quantumB;
+                                        refPriorityEnqueueTask(readyQueueB, t);
+                                    }
+                                    cpu = 0;
+                                } else {
+                                    t->time--;
+                                    p->quantum--;
+                                }
+                                break;
+                            default: // 't' - terminate process
+                                if (p->quantum > 0) {
+                                    p->quantum--;
+                                    stats->instructions++;
+                                    stats->runtime++;
+                                    p->taskRunning = 0;
+                                    p->runtime = stats->runtime;
+                                    stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
+                                    stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
+                                    stats->totalWait += p->ready;
+                                    refEndProcess(queueB, exitQueue, p);
+                                    freeTask(t);
+                                } else {
+                                    p->completions = 0;
+                                    t->interrupts++;
+                                    p->taskRunning = 0;
+                                    p->quantum = quantumB;
+                                    refPriorityEnqueueTask(readyQueueB, t);
+                                }
+                                cpu = 0;
+                                break;
+                        }
+                    }
+                }
+
+                if (!isEmptyP(queueB)) {
+                    refUpdateProcessQueue(queueB, stats->runtime);
+                }
+
+                stats->runtime++;
+            }
+        }
+    }
+
+    ref->task = NULL;
+    return 0;
+}
+
+/*
+ * Function: refRunNonPreemption
+ *
+ * Runs the simulation for non-preemption scheduling. Returns 0 once all
+ * queues are empty, 1 if the iteration limit stopped the run.
+ */
+static int refRunNonPreemption(Reference *ref, int quantumA, int quantumB, long limit) {
+    Stats *stats = ref->stats;
+    pQueue *queueA = ref->queueA, *queueB = ref->queueB, *exitQueue = ref->exitQueue;
+    tQueue *readyQueueA = ref->readyQueueA, *readyQueueB = ref->readyQueueB, *ioQueue = ref->ioQueue;
+    Task *t = NULL;
+    Process *p = NULL;
+    int cpu = 0;
+
+    // main simulation loop for non-preemption
+    while (!refAllQueuesEmpty(ref)) {
+
+        // prioritize queue A
+        if (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+
+            while (!isEmptyP(queueA) || !isEmptyT(readyQueueA)) {
+                if (refPastLimit(ref, limit)) {
+                    ref->task = cpu ? t : NULL;
+                    return 1;
+                }
+
+                // update I/O tasks to simulate concurrent execution
+                if (!isEmptyT(ioQueue)) {
+                    refUpdateIOTasks(ioQueue);
+                }
+
+                if (cpu == 0) {
+                    // fetch next task and set CPU flag
+                    t = refGetNextTask(queueA, readyQueueA, stats->runtime);
+                    if (t != NULL) {
+                        cpu = 1;
+                        t->parent->taskRunning = 1;
+                    }
+
+                    break;
+                } else {
+                    p = t->parent;
+                    switch (t->type) {
+                        case 'i':
+                            if (p->quantum > 0) { // if process has quantum left
+                                p->quantum--;
+                                if (p->quantum > 0) {
+                                    p->completions++;
+                                } else { // reset completions
+                                    p->completions = 0;
+                                }
+                                stats->instructions++;
+                                refEnqueueTask(ioQueue, t); // add to I/O queue
+                            } else {
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                p->quantum = quantumA;
+                                refPriorityEnqueueTask(readyQueueA, t);
+                            }
+                            cpu = 0;
+                            break;
+                        case 'e':
+                            if (t->time == 0) { // task completed
+                                p->taskRunning = 0;
+                                p->currentTask++;
+                                stats->instructions++;
+                                freeTask(t);
+                                cpu = 0;
+                            } else if (p->quantum <= 0) { // quantum used up
+                                p->completions = 0;
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                p->quantum = quantumA;
+                                refPriorityEnqueueTask(readyQueueA, t);
+                                cpu = 0;
+                            } else {
+                                t->time--;
+                                p->quantum--;
+                            }
+                            break;
+                        default: // 't' - terminate process
+                            if (p->quantum > 0) {
+                                p->quantum--;
+                                stats->instructions++;
+                                stats->runtime++;
+                                p->taskRunning = 0;
+                                p->runtime = stats->runtime;
+                                stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
+                                stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
+                                stats->totalWait += p->ready;
+                                refEndProcess(queueA, exitQueue, p);
+                                freeTask(t);
+                            } else {
+                                p->completions = 0;
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                p->quantum = quantumA;
+                                refPriorityEnqueueTask(readyQueueA, t);
+                            }
+                            cpu = 0;
+                            break;
+                    }
+                }
+
+                // update queueA wait/ready times
+                if (!isEmptyP(queueA)) {
+                    refUpdateProcessQueue(queueA, stats->runtime);
+                }
+
+                // update queueB wait/ready times
+                if (!isEmptyP(queueB)) {
+                    refUpdateProcessQueue(queueB, stats->runtime);
+                }
+
+                stats->runtime++;
+            }
+        } else { // if queue A is empty
+
+            while (!isEmptyP(queueB) || !isEmptyT(ioQueue) || !isEmptyT(readyQueueB)) {
+                if (refPastLimit(ref, limit)) {
+                    ref->task = cpu ? t : NULL;
+                    return 1;
+                }
+
+                // update I/O queue to simulate concurrent execution
+                if (!isEmptyT(ioQueue)) {
+                    refUpdateIOTasks(ioQueue);
+                }
+
+                if (cpu == 0) {
+                    // fetch next task and set CPU flag
+                    t = refGetNextTask(queueB, readyQueueB, stats->runtime);
+                    if (t != NULL) {
+                        cpu = 1;
+                        t->parent->taskRunning = 1;
+                    }
+
+                    break;
+                } else {
+                    p = t->parent; // identify parent process
+
+                    switch (t->type) {
+                        case 'i':
+                            if (p->quantum > 0) { // if process has quantum left
+                                p->quantum--;
+                                if (p->quantum > 0) {
+                                    p->completions++;
+                                    if (p->completions == 3) { // promote to queue A
+                                        p->quantum = quantumA;
+                                        refPriorityEnqueueProcess(queueA, p);
+                                        p->endQueue = "A";
+                                    }
+                                } else { // reset completions
+                                    p->completions = 0;
+                                }
+                                stats->instructions++;
+                                refEnqueueTask(ioQueue, t); // add to I/O queue
+                            } else {
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                if (t->interrupts == 3) { // promote to queue A
+                                    p->quantum = quantumA;
+                                    refPromoteProcess(queueB, queueA, p);
+                                    refPriorityEnqueueTask(readyQueueA, t);
+                                } else { // reset completions
+                                    p->quantum = quantumB;
+                                    p->completions = 0;
+                                    refPriorityEnqueueTask(readyQueueB, t);
+                                }
+                            }
+                            cpu = 0;
+                            break;
+                        case 'e':
+                            if (t->time == 0) { // task completed
+                                p->taskRunning = 0;
+                                p->currentTask++;
+                                stats->instructions++;
+                                if (p->quantum > 0) { // if quantum not used up
+                                    p->completions++;
+                                    if (p->completions == 3) { // promote to queue A
+                                        p->quantum = quantumA;
+                                        refPromoteProcess(queueB, queueA, p);
+                                    }
+                                } else { // reset completions
+                                    p->completions = 0;
+                                }
+                                freeTask(t);
+                                cpu = 0;
+                            } else if (p->quantum == 0) { // quantum used up
+                                p->completions = 0;
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                if (t->interrupts == 3) { // promote to queue A
+                                    p->quantum = quantumA;
+                                    refPromoteProcess(queueB, queueA, p);
+                                    refPriorityEnqueueTask(readyQueueA, t);
+                                } else { // put back in ready queue
+                                    p->quantum = quantumB;
+                                    refPriorityEnqueueTask(readyQueueB, t);
+                                }
+                                cpu = 0;
+                            } else {
+                                t->time--;
+                                p->quantum--;
+                            }
+                            break;
+                        default: // 't' - terminate process
+                            if (p->quantum > 0) {
+                                p->quantum--;
+                                stats->instructions++;
+                                stats->runtime++;
+                                p->taskRunning = 0;
+                                p->runtime = stats->runtime;
+                                stats->minWait = stats->minWait < p->ready ? stats->minWait : p->ready;
+                                stats->maxWait = stats->maxWait > p->ready ? stats->maxWait : p->ready;
+                                stats->totalWait += p->ready;
+                                refEndProcess(queueB, exitQueue, p);
+                                freeTask(t);
+                            } else {
+                                p->completions = 0;
+                                t->interrupts++;
+                                p->taskRunning = 0;
+                                p->quantum = quantumB;
+                                refPriorityEnqueueTask(readyQueueB, t);
+                            }
+                            cpu = 0;
+                            break;
+                    }
+                }
+
+                if (!isEmptyP(queueB)) {
+                    refUpdateProcessQueue(queueB, stats->runtime);
+                }
+
+                stats->runtime++;
+            }
+        }
+    }
+
+    ref->task = NULL;
+    return 0;
+}
+
+/*
+ * Function: runReference
+ *
+ * Runs the reference engine over the parsed processes in queueB, taking
+ * ownership of the queue and its processes. The run stops after limit
+ * loop iterations (0 for no limit). Returns 0 once all queues are empty,
+ * 1 if the limit stopped the run, -1 if allocation fails. The Reference
+ * must be released with freeReference in every case.
+ */
+int runReference(Reference *ref, int quantumA, int quantumB, int preemption, pQueue *queueB, long limit) {
+    ref->stats = initializeStats();
+    ref->exitQueue = createProcessQueue();
+    ref->queueA = createProcessQueue();
+    ref->queueB = queueB;
+    ref->readyQueueA = createTaskQueue();
+    ref->readyQueueB = createTaskQueue();
+    ref->ioQueue = createTaskQueue();
+    ref->task = NULL;
+    ref->owned = NULL;
+    ref->iterations = 0;
+
+    // templated processes are expanded up front, as the original engine
+    // only knows queued tasks
+    int expanded = 0;
+    for (pNode *n = queueB ? queueB->head : NULL; n != NULL; n = n->next) {
+        n->process->nextOwned = ref->owned;
+        ref->owned = n->process;
+        expanded |= expandProgram(n->process);
+    }
+    if (expanded != 0 || !ref->stats || !ref->exitQueue || !ref->queueA || !queueB ||
+        !ref->readyQueueA || !ref->readyQueueB || !ref->ioQueue) {
+        return -1;
+    }
+
+    // simulation start time == first process arrival time
+    Process *p = peekProcess(queueB);
+    if (p == NULL) {
+        return 0;
+    }
+    ref->stats->runtime = ref->stats->startTime = p->arrival;
+
+    if (preemption == 1) {
+        return refRunPreemption(ref, quantumA, quantumB, limit);
+    }
+    return refRunNonPreemption(ref, quantumA, quantumB, limit);
+}
+
+/*
+ * Function: refFreeTasks
+ *
+ * Frees a task queue along with every task still in it
+ */
+static void refFreeTasks(tQueue *q) {
+    if (q == NULL) return;
+
+    Task *t;
+    while ((t = refDequeueTask(q)) != NULL) {
+        freeTask(t);
+    }
+    poolFree(POOL_TASK_QUEUE, q);
+}
+
+/*
+ * Function: refFreeProcessNodes
+ *
+ * Frees a process queue and its nodes, but not the processes
+ */
+static void refFreeProcessNodes(pQueue *q) {
+    if (q == NULL) return;
+
+    while (refDequeueProcess(q) != NULL);
+    poolFree(POOL_PROCESS_QUEUE, q);
+}
+
+/*
+ * Function: freeReference
+ *
+ * Frees the queues, statistics, processes and tasks of a reference run
+ */
+void freeReference(Reference *ref) {
+    freeTask(ref->task);
+    refFreeTasks(ref->ioQueue);
+    refFreeTasks(ref->readyQueueA);
+    refFreeTasks(ref->readyQueueB);
+    refFreeProcessNodes(ref->queueA);
+    refFreeProcessNodes(ref->queueB);
+    refFreeProcessNodes(ref->exitQueue);
+
+    while (ref->owned != NULL) {
+        Process *p = ref->owned;
+        ref->owned = p->nextOwned;
+        refFreeTasks(p->tasks);
+        releaseProgram(p->program);
+        releaseGroups(p->group != NULL ? p->group->tree : NULL);
+        poolFree(POOL_PROCESS, p);
+    }
+
+    free(ref->stats);
+    poolTrim();
+}
@@ -0,0 +1,36 @@
+/*
+ * reference.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for the reference engine: the
+ * original two queue tick-by-tick scheduler, frozen together with the
+ * queue operations it was written against. Faster engines are checked
+ * against it, so it must not be changed to match them.
+ */
+
+ #ifndef REFERENCE_H
+ #define REFERENCE_H
+
+ #include "Simulation.h"
+
+ // Struct for the outcome of a reference run
+ typedef struct Reference {
+     Stats *stats;      // final statistics
+     pQueue *exitQueue; // completed processes in completion order
+     pQueue *queueA;    // processes left in queue A
+     pQueue *queueB;    // processes left in queue B
+     tQueue *readyQueueA; // tasks left in ready queue A
+     tQueue *readyQueueB; // tasks left in ready queue B
+     tQueue *ioQueue;   // tasks left performing I/O
+     Task *task;        // task left on the CPU
+     Process *owned;    // every process of the run
+     long iterations;   // scheduler loop iterations
+ } Reference;
+
+ // function prototypes
+ int runReference(Reference *ref, int quantumA, int quantumB, int preemption, pQueue *queueB, long limit);
+ void freeReference(Reference *ref);
+
+ #endif
@@ -0,0 +1,488 @@
+/*
+ * sample.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of approximate runs. The trace is
+ * parsed once into a workload and its processes, in arrival order, are
+ * split into equal strata. A few windows of consecutive processes are
+ * drawn at random from each stratum and simulated on their own, each
+ * after a warm-up of the processes just before it, so that the measured
+ * processes meet queues that are already busy. Windows run in parallel on
+ * worker threads.
+ *
+ * The queues only forget the past when the CPU goes idle, so the warm-up
+ * reaches back to the start of the busy period the window begins in, as
+ * a single queue fed the same CPU work would see it, up to a cap. A trace
+ * that keeps the CPU busy for longer than that is reported, since its
+ * windows start with too little backlog and underestimate ready time.
+ *
+ * The average ready time is estimated stratum by stratum from the window
+ * averages, with a normal 95% confidence interval from their spread. The
+ * end time comes from one more window at the very end of the trace, and
+ * the largest and smallest sampled ready times bound the true extremes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "sample.h"
+#include "workload.h"
+#include "pool.h"
+
+// Struct for one sampled window and what it measured
+typedef struct SampleWindow {
+    int stratum;               // stratum it was drawn from, -1 for the final window
+    int first;                 // first measured process, in arrival order
+    int count;                 // processes measured
+    int warmup;                // processes simulated before first
+    int truncated;             // 1 if the warm-up was cut short of the busy period
+    int status;                // BATCH_DONE, BATCH_LIMIT or BATCH_NOMEM
+    double meanReady;          // average ready time of the measured processes
+    Ticks maxReady;            // largest ready time measured
+    Ticks minReady;            // smallest ready time measured
+    Ticks endTime;             // simulated time the window finished
+    Ticks instructions;        // instructions completed, warm-up included
+    long iterations;           // scheduler loop iterations
+} SampleWindow;
+
+// Struct for the state shared by the worker threads
+typedef struct Sampler {
+    SampleWindow *windows;     // windows to simulate
+    int count;                 // number of windows
+    int next;                  // index of the next window to take
+    Workload *workload;        // parsed trace shared by every window
+    const Branch *config;      // quanta and preemption flag
+    const BatchSettings *settings; // levels, aging and iteration limit
+} Sampler;
+
+/*
+ * Function: parseSampleSpec
+ *
+ * Parses a specification of comma separated key=value settings (strata,
+ * windows, size, warmup, maxwarmup, seed), or "default". Returns 0 on success, -1 if
+ * it is invalid.
+ */
+int parseSampleSpec(const char *text, SampleSpec *spec) {
+    spec->strata = 8;
+    spec->windows = 4;
+    spec->size = 1000;
+    spec->warmup = -1;
+    spec->maxWarmup = -1;
+    spec->seed = 1;
+    if (strcmp(text, "default") == 0) {
+        spec->warmup = spec->size / 2;
+        spec->maxWarmup = spec->size * 10;
+        return 0;
+    }
+
+    char *copy = strdup(text);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    int status = 0;
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); status == 0 && item != NULL; item = strtok_r(NULL, ",", &save)) {
+        char *arg = strchr(item, '=');
+        long value;
+        char extra;
+        if (arg == NULL || sscanf(arg + 1, "%ld%c", &value, &extra) != 1 || value < 0) {
+            status = -1;
+            break;
+        }
+        *arg = '\0';
+
+        if (strcmp(item, "strata") == 0) {
+            spec->strata = (int)value;
+        } else if (strcmp(item, "windows") == 0) {
+            spec->windows = (int)value;
+        } else if (strcmp(item, "size") == 0) {
+            spec->size = (int)value;
+        } else if (strcmp(item, "warmup") == 0) {
+            spec->warmup = (int)value;
+        } else if (strcmp(item, "maxwarmup") == 0) {
+            spec->maxWarmup = (int)value;
+        } else if (strcmp(item, "seed") == 0) {
+            spec->seed = (unsigned long)value;
+        } else {
+            status = -1;
+        }
+    }
+    free(copy);
+
+    // the warm-up defaults to half a window, and may grow to ten
+    if (spec->warmup < 0) {
+        spec->warmup = spec->size / 2;
+    }
+    if (spec->maxWarmup < 0) {
+        spec->maxWarmup = spec->size * 10;
+    }
+    if (spec->maxWarmup < spec->warmup) {
+        spec->maxWarmup = spec->warmup;
+    }
+    if (spec->strata < 1 || spec->windows < 1 || spec->size < 1) {
+        status = -1;
+    }
+    return status;
+}
+
+/*
+ * Function: nextUniform
+ *
+ * Returns a random number in [0, 1) from a xorshift* generator
+ */
+static double nextUniform(unsigned long long *rng) {
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+    return (*rng * 2685821657736338717ULL >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Function: runWindow
+ *
+ * Simulates a window after its warm-up on a fresh instance of the
+ * workload's processes and measures the processes of the window itself
+ */
+static void runWindow(Sampler *s, SampleWindow *win) {
+    Level levels[MAX_LEVELS];
+    int count = batchLevels(levels, s->settings, s->config);
+
+    win->status = BATCH_NOMEM;
+    win->iterations = 0;
+    pQueue *queue = instanceWorkloadRange(s->workload, win->first - win->warmup, win->warmup + win->count, levels[count - 1].quantum);
+    Process **measured = (Process **)malloc(win->count * sizeof(Process *));
+    if (queue == NULL || measured == NULL) {
+        Process *p;
+        while (queue != NULL && (p = dequeueProcess(queue)) != NULL) {
+            freeProcess(p);
+        }
+        freeProcessQueue(queue);
+        free(measured);
+        return;
+    }
+
+    // the measured processes follow the warm-up in the queue
+    int k = 0;
+    for (pNode *n = queue->head; n != NULL; n = n->next, k++) {
+        if (k >= win->warmup) {
+            measured[k - win->warmup] = n->process;
+        }
+    }
+
+    Simulation sim = { 0 };
+    long limit = s->settings->limit > 0 ? s->settings->limit : SAMPLE_LIMIT;
+    long moved = 0;
+    Ticks clock = 0;
+    int status = initializeSimulation(&sim, levels, count, s->config->preemption, queue);
+    if (status == 0) {
+        setAging(&sim, s->settings->aging);
+        while ((status = stepSimulation(&sim)) > 0) {
+            // a window whose clock stops moving is stuck, however long it is given
+            if (sim.stats->runtime != clock) {
+                clock = sim.stats->runtime;
+                moved = win->iterations;
+            }
+            if (++win->iterations >= limit || win->iterations - moved >= SAMPLE_STALL) {
+                break;
+            }
+        }
+    }
+
+    win->status = status < 0 ? BATCH_NOMEM : status > 0 ? BATCH_LIMIT : BATCH_DONE;
+    if (win->status == BATCH_DONE) {
+        Ticks total = 0;
+        win->maxReady = 0;
+        win->minReady = measured[0]->ready;
+        for (int i = 0; i < win->count; i++) {
+            Ticks ready = measured[i]->ready;
+            total += ready;
+            win->maxReady = ready > win->maxReady ? ready : win->maxReady;
+            win->minReady = ready < win->minReady ? ready : win->minReady;
+        }
+        win->meanReady = (double)total / win->count;
+        win->endTime = sim.stats->runtime;
+        win->instructions = sim.stats->instructions;
+    }
+    freeSimulation(&sim);
+    free(measured);
+}
+
+/*
+ * Function: sampleWorker
+ *
+ * Thread body: takes windows until none are left
+ */
+static void *sampleWorker(void *arg) {
+    Sampler *s = (Sampler *)arg;
+    int i;
+    while ((i = __sync_fetch_and_add(&s->next, 1)) < s->count) {
+        runWindow(s, &s->windows[i]);
+    }
+    poolTrim();
+    return NULL;
+}
+
+/*
+ * Function: busyPeriods
+ *
+ * Returns a new array holding, for every process, the first process of
+ * the busy period it arrives in, for one queue serving the workload's
+ * execution time in arrival order. Returns NULL if allocation fails.
+ */
+static int *busyPeriods(const Workload *w) {
+    int *start = (int *)malloc((w->count + 1) * sizeof(int));
+    if (start == NULL) {
+        return NULL;
+    }
+    Ticks backlog = 0;
+    for (int i = 0; i < w->count; i++) {
+        const WorkloadProcess *wp = &w->processes[i];
+        if (i > 0) {
+            backlog -= wp->arrival - w->processes[i - 1].arrival;
+        }
+        start[i] = i > 0 && backlog > 0 ? start[i - 1] : i;
+        backlog = backlog > 0 ? backlog : 0;
+        for (int j = 0; j < wp->program->count; j++) {
+            if (wp->program->instructions[j].type == 'e') {
+                backlog += programTime(wp->program, j);
+            }
+        }
+    }
+    return start;
+}
+
+/*
+ * Function: placeWindows
+ *
+ * Draws the windows of every stratum, adds the final window and sizes
+ * their warm-ups. A sample that would simulate as many processes as the
+ * trace holds is replaced by one window over all of it. Returns the
+ * number of windows.
+ */
+static int placeWindows(SampleWindow *windows, const Workload *w, const int *busy, const SampleSpec *spec, int strata, int size) {
+    int total = w->count;
+    unsigned long long rng = spec->seed * 0x9e3779b97f4a7c15ULL + 1;
+    int n = 0;
+    for (int h = 0; h < strata; h++) {
+        int a = (int)((long long)h * total / strata);
+        int b = (int)((long long)(h + 1) * total / strata);
+        int slots = b - a - size + 1;
+        for (int j = 0; j < spec->windows; j++) {
+            SampleWindow *win = &windows[n++];
+            memset(win, 0, sizeof(SampleWindow));
+            win->stratum = h;
+            win->first = a + (slots > 1 ? (int)(nextUniform(&rng) * slots) : 0);
+            win->count = size < b - a ? size : b - a;
+        }
+    }
+
+    SampleWindow *last = &windows[n++];
+    memset(last, 0, sizeof(SampleWindow));
+    last->stratum = -1;
+    last->count = size < total ? size : total;
+    last->first = total - last->count;
+
+    // warm up from the start of the busy period, within the cap
+    long long simulated = 0;
+    for (int i = 0; i < n; i++) {
+        SampleWindow *win = &windows[i];
+        int want = win->first - (busy != NULL ? busy[win->first] : 0);
+        want = want > spec->warmup ? want : spec->warmup;
+        win->warmup = want < spec->maxWarmup ? want : spec->maxWarmup;
+        win->warmup = win->warmup < win->first ? win->warmup : win->first;
+        win->truncated = busy == NULL || win->warmup < win->first - busy[win->first];
+        simulated += win->warmup + win->count;
+    }
+    if (simulated >= total) {
+        memset(windows, 0, sizeof(SampleWindow));
+        windows[0].count = total;
+        n = 1;
+    }
+    return n;
+}
+
+/*
+ * Function: approximateRun
+ *
+ * Estimates the statistics of running the trace at path under config by
+ * simulating sampled windows of it, and prints them with the cost of the
+ * sample next to what a full run would cost. Returns 0 on success, 1 if
+ * no window finished, -1 if the trace could not be loaded.
+ */
+int approximateRun(const char *path, const Branch *config, const BatchSettings *settings, const SampleSpec *spec) {
+    struct stat st;
+    BatchJob job;
+    memset(&job, 0, sizeof(job));
+    Workload *w = NULL;
+    if (stat(path, &st) != 0) {
+        job.message = "Could not open file";
+    } else {
+        w = loadWorkload(path, &st, &job);
+    }
+    if (w == NULL) {
+        if (job.line > 0) {
+            printf("Error: %s: line %d: %s\n", path, job.line, job.message);
+        } else {
+            printf("Error: %s: %s\n", path, job.message);
+        }
+        return -1;
+    }
+    if (w->count == 0) {
+        printf("Error: %s: no processes\n", path);
+        releaseWorkload(w);
+        return -1;
+    }
+
+    // small traces get fewer strata and smaller windows
+    int total = w->count;
+    int strata = spec->strata < total ? spec->strata : total;
+    int size = spec->size < total / strata ? spec->size : total / strata;
+
+    Sampler s;
+    s.count = strata * spec->windows + 1;
+    s.next = 0;
+    s.windows = (SampleWindow *)malloc(s.count * sizeof(SampleWindow));
+    s.workload = w;
+    s.config = config;
+    s.settings = settings;
+    if (s.windows == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        releaseWorkload(w);
+        return -1;
+    }
+    int *busy = busyPeriods(w);
+    s.count = placeWindows(s.windows, w, busy, spec, strata, size);
+    free(busy);
+
+    struct timespec began, ended;
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    int workers = settings->workers < s.count ? settings->workers : s.count;
+    pthread_t *threads = (pthread_t *)malloc((workers > 0 ? workers : 1) * sizeof(pthread_t));
+    int started = 0;
+    while (threads != NULL && started < workers && pthread_create(&threads[started], NULL, sampleWorker, &s) == 0) {
+        started++;
+    }
+    // without any thread the windows still run, on the calling thread
+    if (started == 0) {
+        sampleWorker(&s);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    clock_gettime(CLOCK_MONOTONIC, &ended);
+    double seconds = (ended.tv_sec - began.tv_sec) + (ended.tv_nsec - began.tv_nsec) / 1e9;
+
+    // pooled spread within strata, for strata with a single finished window
+    double deviations = 0;
+    int freedom = 0, finished = 0, stuck = 0, truncated = 0;
+    Ticks maxReady = 0, minReady = 0, instructions = 0;
+    long long simulated = 0, completedSimulated = 0;
+    long iterations = 0;
+    double *sums = (double *)calloc(strata, sizeof(double));
+    int *counts = (int *)calloc(strata, sizeof(int));
+    for (int i = 0; i < s.count; i++) {
+        SampleWindow *win = &s.windows[i];
+        simulated += win->warmup + win->count;
+        iterations += win->iterations;
+        truncated += win->truncated;
+        if (win->status != BATCH_DONE) {
+            stuck++;
+            continue;
+        }
+        completedSimulated += win->warmup + win->count;
+        instructions += win->instructions;
+        maxReady = finished == 0 || win->maxReady > maxReady ? win->maxReady : maxReady;
+        minReady = finished == 0 || win->minReady < minReady ? win->minReady : minReady;
+        finished++;
+        if (win->stratum >= 0 && sums != NULL && counts != NULL) {
+            sums[win->stratum] += win->meanReady;
+            counts[win->stratum]++;
+        }
+    }
+    for (int i = 0; sums != NULL && counts != NULL && i < s.count; i++) {
+        SampleWindow *win = &s.windows[i];
+        if (win->status == BATCH_DONE && win->stratum >= 0) {
+            double d = win->meanReady - sums[win->stratum] / counts[win->stratum];
+            deviations += d * d;
+        }
+    }
+    for (int h = 0; sums != NULL && counts != NULL && h < strata; h++) {
+        freedom += counts[h] > 0 ? counts[h] - 1 : 0;
+    }
+    double pooled = freedom > 0 ? deviations / freedom : 0;
+
+    // stratified estimate: each stratum weighs as much as its share of processes
+    double estimate = 0, variance = 0, weight = 0;
+    for (int h = 0; sums != NULL && counts != NULL && h < strata; h++) {
+        if (counts[h] == 0) {
+            continue;
+        }
+        double share = (double)((long long)(h + 1) * total / strata - (long long)h * total / strata) / total;
+        double mean = sums[h] / counts[h];
+        double spread = pooled;
+        if (counts[h] > 1) {
+            spread = 0;
+            for (int i = 0; i < s.count; i++) {
+                SampleWindow *win = &s.windows[i];
+                if (win->status == BATCH_DONE && win->stratum == h) {
+                    spread += (win->meanReady - mean) * (win->meanReady - mean);
+                }
+            }
+            spread /= counts[h] - 1;
+        }
+        weight += share;
+        estimate += share * mean;
+        variance += share * share * spread / counts[h];
+    }
+
+    SampleWindow *last = &s.windows[s.count - 1];
+    if (s.count == 1) {
+        printf("Approximate run of %s: the sample would cover the whole trace, so it ran in full\n", path);
+    } else {
+        printf("Approximate run of %s: %d windows of %d processes (%d to %d warm-up) from %d strata, plus the final window\n",
+               path, s.count - 1, size, spec->warmup, spec->maxWarmup, strata);
+    }
+    if (weight > 0) {
+        estimate /= weight;
+        variance /= weight * weight;
+        double margin = 1.96 * sqrt(variance);
+        if (last->status == BATCH_DONE) {
+            printf("Start/End Time: %lld, %lld (end from the final window)\n", w->processes[0].arrival, last->endTime);
+        } else {
+            printf("Start/End Time: %lld, unknown (the final window did not finish)\n", w->processes[0].arrival);
+        }
+        printf("Processes completed: %d (if the full run finishes)\n", total);
+        printf("Instructions completed: %.0f (estimated)\n", completedSimulated > 0 ? (double)instructions / completedSimulated * total : 0.0);
+        printf("Average ready time: %.2f (95%% confidence interval %.2f to %.2f)\n", estimate, estimate - margin, estimate + margin);
+        printf("Max ready time: %lld (largest sampled, the full run's is at least this)\n", maxReady);
+        printf("Min ready time: %lld (smallest sampled, the full run's is at most this)\n", minReady);
+    } else {
+        printf("No sampled window finished\n");
+    }
+    if (truncated > 0) {
+        printf("Warning: %d of %d windows start inside a busy period longer than the warm-up cap; the CPU stays\n"
+               "         backlogged, so the estimates are too low (raise maxwarmup or run the full trace)\n", truncated, s.count);
+    }
+    if (stuck > 0) {
+        printf("Stuck windows: %d of %d, left out of the estimate (the full run may not finish)\n", stuck, s.count);
+    }
+
+    double share = 100.0 * simulated / total;
+    double fullIterations = simulated > 0 ? (double)iterations / simulated * total : 0;
+    printf("Cost: %lld processes simulated (%.2f%% of the trace), %ld iterations in %.3f s; a full run needs about %.0f iterations (%.1f times as many)\n",
+           simulated, share, iterations, seconds, fullIterations, iterations > 0 ? fullIterations / iterations : 0.0);
+
+    free(sums);
+    free(counts);
+    free(s.windows);
+    releaseWorkload(w);
+    return weight > 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+/*
+ * sample.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for approximate runs, which simulate
+ * sampled windows of a trace's arrival stream instead of all of it and
+ * extrapolate the statistics, with confidence intervals, to the full run.
+ */
+
+ #ifndef SAMPLE_H
+ #define SAMPLE_H
+
+ #include "batch.h"
+
+ #ifndef SAMPLE_LIMIT
+ #define SAMPLE_LIMIT 100000000L // default scheduler iterations per window
+ #endif
+
+ #ifndef SAMPLE_STALL
+ #define SAMPLE_STALL 100000L // iterations without the clock moving before a window counts as stuck
+ #endif
+
+ // Struct for the sampling settings
+ typedef struct SampleSpec {
+     int strata;                // arrival order strata, sampled separately
+     int windows;               // windows sampled from each stratum
+     int size;                  // processes measured in each window
+     int warmup;                // fewest processes simulated before each window and not measured
+     int maxWarmup;             // most, when the busy period a window starts in is longer
+     unsigned long seed;        // random seed for the window positions
+ } SampleSpec;
+
+ // function prototypes
+ int parseSampleSpec(const char *text, SampleSpec *spec);
+ int approximateRun(const char *path, const Branch *config, const BatchSettings *settings, const SampleSpec *spec);
+
+ #endif
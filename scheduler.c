@@ -0,0 +1,534 @@
+/*
+ * scheduler.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the libscheduler interface. An
+ * engine collects processes until the first step, then hands them to the
+ * same Simulation engine the command line program uses. Processes added
+ * after the first step join the main queue as online arrivals.
+ */
+
+#include <stdlib.h>
+
+#include "scheduler.h"
+#include "Simulation.h"
+#include "parser.h"
+#include "decompress.h"
+#include "pool.h"
+
+#define PID_TABLE_CAPACITY 64
+
+// Struct for the pid lookup table, open addressing with linear probing
+typedef struct PidTable {
+    Process **slots;   // processes indexed by pid hash
+    int capacity;      // number of slots, a power of two
+    int size;          // number of processes in the table
+} PidTable;
+
+// Struct for an embedded engine
+struct SchedEngine {
+    Simulation sim;    // engine state once the run has started
+    pQueue *pending;   // processes added before the run starts
+    PidTable pids;     // processes by pid for constant time queries
+    Level levels[MAX_LEVELS]; // quantum and promotion rules of each level
+    int numLevels;     // number of levels
+    int aging;         // ready ticks per point of priority aging, 0 = none
+    int preemption;    // flag for preemption
+    int started;       // flag for start of simulation
+    int failed;        // flag for an engine that ran out of memory
+};
+
+/*
+ * Function: pidSlot
+ *
+ * Returns the slot holding pid, or the empty slot where it belongs
+ */
+static int pidSlot(PidTable *table, int pid) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int i = ((unsigned int)pid * 2654435761u) & mask;
+    while (table->slots[i] != NULL && table->slots[i]->pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/*
+ * Function: indexProcess
+ *
+ * Adds a process to the pid table. If several processes share a pid, the
+ * first one added is kept. Returns 0 on success, -1 if memory allocation
+ * failed.
+ */
+static int indexProcess(PidTable *table, Process *p) {
+    // keep the table at most half full
+    if ((table->size + 1) * 2 > table->capacity) {
+        PidTable grown;
+        grown.capacity = table->capacity ? table->capacity * 2 : PID_TABLE_CAPACITY;
+        grown.size = table->size;
+        grown.slots = (Process **)calloc(grown.capacity, sizeof(Process *));
+        if (!grown.slots) {
+            return -1;
+        }
+        for (int i = 0; i < table->capacity; i++) {
+            if (table->slots[i] != NULL) {
+                grown.slots[pidSlot(&grown, table->slots[i]->pid)] = table->slots[i];
+            }
+        }
+        free(table->slots);
+        *table = grown;
+    }
+
+    int i = pidSlot(table, p->pid);
+    if (table->slots[i] == NULL) {
+        table->slots[i] = p;
+        table->size++;
+    }
+    return 0;
+}
+
+/*
+ * Function: startEngine
+ *
+ * Hands the pending processes to the simulation engine
+ */
+static int startEngine(SchedEngine *e) {
+    e->sim.input_file = NULL;
+    e->sim.progress = NULL;
+    e->sim.checkpoint = NULL;
+    e->started = 1;
+
+    // processes start with the quantum of the lowest level
+    pQueue *queue = e->pending;
+    for (pNode *n = queue->head; n != NULL; n = n->next) {
+        n->process->quantum = e->levels[e->numLevels - 1].quantum;
+    }
+
+    e->pending = NULL;
+    if (initializeSimulation(&e->sim, e->levels, e->numLevels, e->preemption, queue) != 0) {
+        e->failed = 1;
+        return SCHED_ERR_NOMEM;
+    }
+    e->sim.idleTicks = 1;
+    setAging(&e->sim, e->aging);
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedCreate
+ *
+ * Creates an engine with the given quanta (each greater than 1) and
+ * preemption flag (0 or 1)
+ */
+int schedCreate(SchedEngine **engine, int quantumA, int quantumB, int preemption) {
+    if (engine == NULL || quantumA < 2 || quantumB < 2 || (preemption != 0 && preemption != 1)) {
+        return SCHED_ERR_INVALID;
+    }
+
+    SchedEngine *e = (SchedEngine *)calloc(1, sizeof(SchedEngine));
+    if (!e) {
+        return SCHED_ERR_NOMEM;
+    }
+
+    e->pending = createProcessQueue();
+    if (!e->pending) {
+        free(e);
+        return SCHED_ERR_NOMEM;
+    }
+    e->numLevels = defaultLevels(e->levels, quantumA, quantumB);
+    e->preemption = preemption;
+
+    *engine = e;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedLoad
+ *
+ * Parses processes in the text workload format from an open file
+ */
+int schedLoad(SchedEngine *engine, FILE *file) {
+    if (engine == NULL || file == NULL) return SCHED_ERR_INVALID;
+    if (engine->started) return SCHED_ERR_STATE;
+
+    pNode *last = engine->pending->tail;
+    int status = parseProcesses(file, engine->levels[engine->numLevels - 1].quantum, engine->pending, NULL);
+
+    // index the processes this call added
+    for (pNode *n = last ? last->next : engine->pending->head; n != NULL; n = n->next) {
+        if (indexProcess(&engine->pids, n->process) != 0) {
+            return SCHED_ERR_NOMEM;
+        }
+    }
+
+    switch (status) {
+        case PARSE_OK:
+            return SCHED_OK;
+        case PARSE_NOMEM:
+            return SCHED_ERR_NOMEM;
+        default:
+            return SCHED_ERR_PARSE;
+    }
+}
+
+/*
+ * Function: schedLoadFile
+ *
+ * Parses processes in the text workload format from a file path
+ */
+int schedLoadFile(SchedEngine *engine, const char *path) {
+    if (engine == NULL || path == NULL) return SCHED_ERR_INVALID;
+
+    FILE *file = openTrace(path);
+    if (file == NULL) {
+        return SCHED_ERR_IO;
+    }
+
+    int status = schedLoad(engine, file);
+    fclose(file);
+    return status;
+}
+
+/*
+ * Function: schedAddProcess
+ *
+ * Adds a process with the given execution ('e') and I/O ('i') instructions.
+ * The terminate instruction is added automatically. Once the simulation has
+ * started the process is an online arrival and its arrival time may not be
+ * earlier than the current time.
+ */
+int schedAddProcess(SchedEngine *engine, int pid, int priority, SchedTime arrival, const SchedInstruction *instructions, int count) {
+    if (engine == NULL || count < 0 || (count > 0 && instructions == NULL)) return SCHED_ERR_INVALID;
+    if (engine->failed) return SCHED_ERR_NOMEM;
+    if (engine->started && arrival < engine->sim.stats->runtime) return SCHED_ERR_INVALID;
+
+    for (int i = 0; i < count; i++) {
+        if ((instructions[i].type != 'e' && instructions[i].type != 'i') || instructions[i].time < 0) {
+            return SCHED_ERR_INVALID;
+        }
+    }
+
+    Process *p = createProcess();
+    if (p == NULL) {
+        return SCHED_ERR_NOMEM;
+    }
+    p->pid = pid;
+    p->priority = priority;
+    p->arrival = arrival;
+    p->quantum = engine->levels[engine->numLevels - 1].quantum;
+
+    // add each instruction followed by the terminate task
+    for (int i = 0; i <= count; i++) {
+        Task *t = createTask();
+        if (t == NULL) {
+            freeProcess(p);
+            return SCHED_ERR_NOMEM;
+        }
+        t->type = i < count ? instructions[i].type : 't';
+        t->time = i < count ? instructions[i].time : 0;
+        t->parent = p;
+
+        if (enqueueTask(p->tasks, t) != 0) {
+            freeTask(t);
+            freeProcess(p);
+            return SCHED_ERR_NOMEM;
+        }
+    }
+
+    Simulation *sim = &engine->sim;
+    pQueue *q = engine->started ? sim->level[sim->levels - 1].queue : engine->pending;
+    if (enqueueProcess(q, p) != 0) {
+        freeProcess(p);
+        return SCHED_ERR_NOMEM;
+    }
+
+    if (engine->started) {
+        // the engine owns the process from here and a finished run resumes
+        adoptProcess(sim, p);
+        refreshLevels(sim);
+        sim->end = 0;
+    }
+    return indexProcess(&engine->pids, p) == 0 ? SCHED_OK : SCHED_ERR_NOMEM;
+}
+
+/*
+ * Function: schedSetLevels
+ *
+ * Replaces the two default levels with count levels, listed from highest
+ * to lowest. Processes enter at the lowest level. Must be called before
+ * the first step.
+ */
+int schedSetLevels(SchedEngine *engine, const SchedLevel *levels, int count) {
+    if (engine == NULL || levels == NULL || count < 1 || count > MAX_LEVELS) return SCHED_ERR_INVALID;
+    if (engine->started) return SCHED_ERR_STATE;
+
+    for (int i = 0; i < count; i++) {
+        if (levels[i].quantum < 2 || levels[i].promote < 0 || levels[i].demote < 0) {
+            return SCHED_ERR_INVALID;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        engine->levels[i].quantum = levels[i].quantum;
+        engine->levels[i].promote = levels[i].promote;
+        engine->levels[i].demote = levels[i].demote;
+    }
+    engine->numLevels = count;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedSetAging
+ *
+ * Makes waiting processes gain a point of priority for every aging ticks
+ * of ready time (0 turns aging off). Must be called before the first step.
+ */
+int schedSetAging(SchedEngine *engine, int aging) {
+    if (engine == NULL || aging < 0) return SCHED_ERR_INVALID;
+    if (engine->started) return SCHED_ERR_STATE;
+
+    engine->aging = aging;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedStep
+ *
+ * Runs up to the given number of scheduler iterations. Returns SCHED_OK if
+ * there is work left and SCHED_DONE once the simulation has finished.
+ */
+int schedStep(SchedEngine *engine, long iterations) {
+    if (engine == NULL || iterations < 0) return SCHED_ERR_INVALID;
+    if (engine->failed) return SCHED_ERR_NOMEM;
+
+    if (!engine->started) {
+        int status = startEngine(engine);
+        if (status != SCHED_OK) return status;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        int status = stepSimulation(&engine->sim);
+        if (status == 0) {
+            return SCHED_DONE;
+        }
+        if (status < 0) {
+            engine->failed = 1;
+            return SCHED_ERR_NOMEM;
+        }
+    }
+    return engine->sim.end ? SCHED_DONE : SCHED_OK;
+}
+
+/*
+ * Function: schedAdvanceUntil
+ *
+ * Runs the simulation until the simulated time reaches time. Returns
+ * SCHED_OK if there is work left and SCHED_DONE if the simulation finished
+ * first.
+ */
+int schedAdvanceUntil(SchedEngine *engine, SchedTime time) {
+    // a step of no iterations starts the engine if needed
+    int status = schedStep(engine, 0);
+    while (status == SCHED_OK && engine->sim.stats->runtime < time) {
+        status = schedStep(engine, 1);
+    }
+    return status;
+}
+
+/*
+ * Function: schedRun
+ *
+ * Runs the simulation to completion
+ */
+int schedRun(SchedEngine *engine) {
+    int status;
+    while ((status = schedStep(engine, PROGRESS_INTERVAL)) == SCHED_OK);
+    return status == SCHED_DONE ? SCHED_OK : status;
+}
+
+/*
+ * Function: schedCurrentTime
+ *
+ * Returns the current simulated time, or the first arrival time if the
+ * simulation has not started
+ */
+SchedTime schedCurrentTime(SchedEngine *engine) {
+    if (engine == NULL) return 0;
+    if (!engine->started) {
+        Process *p = peekProcess(engine->pending);
+        return p ? p->arrival : 0;
+    }
+    return engine->sim.stats ? engine->sim.stats->runtime : 0;
+}
+
+/*
+ * Function: schedRunningTask
+ *
+ * Fills task with the task currently on the CPU. Returns 1 if a task is
+ * running and 0 if the CPU is idle.
+ */
+int schedRunningTask(SchedEngine *engine, SchedTaskInfo *task) {
+    if (engine == NULL || task == NULL) return SCHED_ERR_INVALID;
+    if (engine->failed) return SCHED_ERR_NOMEM;
+    if (!engine->started || engine->sim.CPU == 0 || engine->sim.task == NULL) {
+        return 0;
+    }
+
+    Task *t = engine->sim.task;
+    task->pid = t->parent->pid;
+    task->type = t->type;
+    task->remaining = t->time;
+    return 1;
+}
+
+/*
+ * Function: schedQueueLengths
+ *
+ * Fills lengths with the current size of each queue
+ */
+int schedQueueLengths(SchedEngine *engine, SchedQueueLengths *lengths) {
+    if (engine == NULL || lengths == NULL) return SCHED_ERR_INVALID;
+    if (engine->failed) return SCHED_ERR_NOMEM;
+
+    if (!engine->started) {
+        lengths->queueA = lengths->readyQueueA = lengths->readyQueueB = 0;
+        lengths->ioQueue = lengths->exitQueue = 0;
+        lengths->queueB = engine->pending->size;
+        return SCHED_OK;
+    }
+
+    Simulation *sim = &engine->sim;
+    lengths->queueA = sim->level[0].queue->size;
+    lengths->queueB = sim->level[sim->levels - 1].queue->size;
+    lengths->readyQueueA = sim->level[0].ready->size;
+    lengths->readyQueueB = sim->level[sim->levels - 1].ready->size;
+    lengths->ioQueue = sim->ioQueue->size;
+    lengths->exitQueue = sim->exitQueue->size;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedProcessWait
+ *
+ * Stores the ready/wait time a process has accumulated so far in wait
+ */
+int schedProcessWait(SchedEngine *engine, int pid, SchedTime *wait) {
+    if (engine == NULL || wait == NULL) return SCHED_ERR_INVALID;
+    if (engine->pids.size == 0) return SCHED_ERR_INVALID;
+
+    Process *p = engine->pids.slots[pidSlot(&engine->pids, pid)];
+    if (p == NULL) {
+        return SCHED_ERR_INVALID;
+    }
+    *wait = p->ready;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedMemoryUsage
+ *
+ * Fills usage with the memory held by the engines of the calling thread
+ */
+int schedMemoryUsage(SchedMemoryUsage *usage) {
+    if (usage == NULL) return SCHED_ERR_INVALID;
+
+    MemoryUsage u;
+    memoryUsage(&u);
+    usage->current = u.current;
+    usage->peak = u.peak;
+    usage->pooled = u.pooled;
+    usage->tasks = u.tasks;
+    usage->nodes = u.nodes;
+    usage->processes = u.processes;
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedGetResults
+ *
+ * Fills results with the statistics of the processes completed so far. The
+ * per-process array must be released with schedFreeResults.
+ */
+int schedGetResults(SchedEngine *engine, SchedResults *results) {
+    if (engine == NULL || results == NULL) return SCHED_ERR_INVALID;
+    if (!engine->started) return SCHED_ERR_STATE;
+
+    Stats *stats = engine->sim.stats;
+    pQueue *exitQueue = engine->sim.exitQueue;
+
+    results->startTime = stats->startTime;
+    results->endTime = stats->runtime;
+    results->completed = exitQueue->size;
+    results->instructions = stats->instructions;
+    results->averageWait = exitQueue->size > 0 ? (double)stats->totalWait / exitQueue->size : 0;
+    results->maxWait = stats->maxWait;
+    results->minWait = stats->minWait;
+
+    results->processes = (SchedProcessResult *)malloc((exitQueue->size + 1) * sizeof(SchedProcessResult));
+    if (!results->processes) {
+        return SCHED_ERR_NOMEM;
+    }
+
+    int i = 0;
+    for (pNode *n = exitQueue->head; n != NULL; n = n->next, i++) {
+        Process *p = n->process;
+        results->processes[i].pid = p->pid;
+        results->processes[i].completion = p->runtime;
+        results->processes[i].waiting = p->ready;
+        results->processes[i].terminationQueue = p->endQueue[0];
+    }
+    return SCHED_OK;
+}
+
+/*
+ * Function: schedFreeResults
+ *
+ * Frees the per-process results array
+ */
+void schedFreeResults(SchedResults *results) {
+    if (results == NULL) return;
+
+    free(results->processes);
+    results->processes = NULL;
+}
+
+/*
+ * Function: schedDestroy
+ *
+ * Frees the engine and every process and task it owns
+ */
+void schedDestroy(SchedEngine *engine) {
+    if (engine == NULL) return;
+
+    if (engine->started) {
+        freeSimulation(&engine->sim);
+    } else {
+        Process *p;
+        while ((p = dequeueProcess(engine->pending)) != NULL) {
+            freeProcess(p);
+        }
+        freeProcessQueue(engine->pending);
+        poolTrim();
+    }
+    free(engine->pids.slots);
+    free(engine);
+}
+
+/*
+ * Function: schedStatusString
+ *
+ * Returns a description of a status code
+ */
+const char *schedStatusString(int status) {
+    switch (status) {
+        case SCHED_OK: return "ok";
+        case SCHED_DONE: return "simulation finished";
+        case SCHED_ERR_NOMEM: return "memory allocation failed";
+        case SCHED_ERR_IO: return "could not read workload file";
+        case SCHED_ERR_PARSE: return "malformed workload";
+        case SCHED_ERR_INVALID: return "invalid argument";
+        case SCHED_ERR_STATE: return "invalid call for the engine state";
+        default: return "unknown status";
+    }
+}
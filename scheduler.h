@@ -0,0 +1,122 @@
+/*
+ * scheduler.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the public interface of libscheduler, which embeds the
+ * multilevel feedback queue engine in another program. Every engine is an
+ * independent handle with no shared global state, so separate engines may
+ * be driven from separate threads. Functions return a status code instead
+ * of printing or exiting. An engine can be advanced a little at a time,
+ * queried between steps and fed new arrivals while it runs.
+ */
+
+ #ifndef SCHEDULER_H
+ #define SCHEDULER_H
+
+ #include <stdio.h>
+
+ // Symbols exported from the shared library
+ #ifndef SCHED_API
+ #define SCHED_API __attribute__((visibility("default")))
+ #endif
+
+ // Status codes
+ typedef enum SchedStatus {
+     SCHED_OK = 0,              // success, the simulation has work left
+     SCHED_DONE = 1,            // the simulation has finished
+     SCHED_ERR_NOMEM = -1,      // memory allocation failed
+     SCHED_ERR_IO = -2,         // the workload file could not be read
+     SCHED_ERR_PARSE = -3,      // the workload is malformed
+     SCHED_ERR_INVALID = -4,    // an argument is out of range
+     SCHED_ERR_STATE = -5       // the call is not valid in the engine's state
+ } SchedStatus;
+
+ // Simulated time and the counters that grow with it
+ typedef long long SchedTime;
+
+ // Opaque handle to one simulation engine
+ typedef struct SchedEngine SchedEngine;
+
+ // Struct for one instruction of a process added through the API
+ typedef struct SchedInstruction {
+     char type;                 // 'e' = execution, 'i' = I/O
+     SchedTime time;            // time to execute or I/O time
+ } SchedInstruction;
+
+ // Struct for the result of one completed process
+ typedef struct SchedProcessResult {
+     int pid;                   // process id
+     SchedTime completion;      // completion time
+     SchedTime waiting;         // total ready/wait time
+     char terminationQueue;     // queue the process finished in, 'A' or 'B'
+ } SchedProcessResult;
+
+ // Struct for the rules of one feedback level
+ typedef struct SchedLevel {
+     int quantum;               // quantum for execution at this level (greater than 1)
+     int promote;               // completions or interrupts before moving up, 0 = never
+     int demote;                // quantum expiries before moving down, 0 = never
+ } SchedLevel;
+
+ // Struct for the task currently on the CPU
+ typedef struct SchedTaskInfo {
+     int pid;                   // process id of the task's parent
+     char type;                 // 'e' = execution, 'i' = I/O, 't' = terminate
+     SchedTime remaining;       // time left on the task
+ } SchedTaskInfo;
+
+ // Struct for the lengths of the engine's queues
+ typedef struct SchedQueueLengths {
+     int queueA;                // processes at the highest level
+     int queueB;                // processes at the lowest level, where they enter
+     int readyQueueA;           // interrupted tasks waiting at the highest level
+     int readyQueueB;           // interrupted tasks waiting at the lowest level
+     int ioQueue;               // tasks performing I/O
+     int exitQueue;             // completed processes
+ } SchedQueueLengths;
+
+ // Struct for the memory held by the engines of one thread
+ typedef struct SchedMemoryUsage {
+     long current;              // bytes held by live tasks, processes, queues and nodes
+     long peak;                 // highest value of current
+     long pooled;               // bytes of freed objects kept for reuse
+     long tasks;                // live tasks
+     long nodes;                // live queue nodes
+     long processes;            // live processes
+ } SchedMemoryUsage;
+
+ // Struct for the results of a simulation
+ typedef struct SchedResults {
+     SchedTime startTime;       // start time of simulation
+     SchedTime endTime;         // end time of simulation
+     int completed;             // number of processes completed
+     SchedTime instructions;    // number of instructions completed
+     double averageWait;        // average ready time
+     SchedTime maxWait;         // maximum ready time
+     SchedTime minWait;         // minimum ready time
+     SchedProcessResult *processes; // completed processes in completion order
+ } SchedResults;
+
+ // function prototypes
+ SCHED_API int schedCreate(SchedEngine **engine, int quantumA, int quantumB, int preemption);
+ SCHED_API int schedSetLevels(SchedEngine *engine, const SchedLevel *levels, int count);
+ SCHED_API int schedSetAging(SchedEngine *engine, int aging);
+ SCHED_API int schedLoad(SchedEngine *engine, FILE *file);
+ SCHED_API int schedLoadFile(SchedEngine *engine, const char *path);
+ SCHED_API int schedAddProcess(SchedEngine *engine, int pid, int priority, SchedTime arrival, const SchedInstruction *instructions, int count);
+ SCHED_API int schedStep(SchedEngine *engine, long iterations);
+ SCHED_API int schedAdvanceUntil(SchedEngine *engine, SchedTime time);
+ SCHED_API int schedRun(SchedEngine *engine);
+ SCHED_API SchedTime schedCurrentTime(SchedEngine *engine);
+ SCHED_API int schedRunningTask(SchedEngine *engine, SchedTaskInfo *task);
+ SCHED_API int schedQueueLengths(SchedEngine *engine, SchedQueueLengths *lengths);
+ SCHED_API int schedProcessWait(SchedEngine *engine, int pid, SchedTime *wait);
+ SCHED_API int schedMemoryUsage(SchedMemoryUsage *usage);
+ SCHED_API int schedGetResults(SchedEngine *engine, SchedResults *results);
+ SCHED_API void schedFreeResults(SchedResults *results);
+ SCHED_API void schedDestroy(SchedEngine *engine);
+ SCHED_API const char *schedStatusString(int status);
+
+ #endif
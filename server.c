@@ -0,0 +1,316 @@
+/*
+ * server.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of server mode. A trace is parsed
+ * once into a workload: each process with its instructions as a shared,
+ * immutable program, as templates are. A request instances the processes
+ * from the workload, which costs one allocation per process and no
+ * parsing, and runs them on the worker thread serving the connection.
+ * Workloads are keyed by path and are parsed again when the file's
+ * modification time or size changes. Each connection sends one request
+ * per line and gets one response per request:
+ *
+ *   RUN [config=<qA:qB:preemption>] [aging=<T>] [limit=<N>] [processes=1] <path>
+ *       -> OK <done|limit> <start> <end> <completed> <instructions> <avg> <max> <min> <iterations> <cached>
+ *          P <pid> <completion> <waiting> <queue>      (per process, with processes=1)
+ *          END
+ *   STATS
+ *       -> OK <workloads> <hits> <misses>
+ *          END
+ *
+ * A request that fails gets a single ERROR <message> line.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "server.h"
+#include "sweep.h"
+#include "workload.h"
+#include "pool.h"
+
+// Struct for the state shared by the server threads
+typedef struct Server {
+    int listener;              // listening socket
+    Branch config;             // configuration of requests that name none
+    BatchSettings settings;    // levels, aging and iteration limit
+    pthread_mutex_t lock;      // guards the cache and its counters
+    Workload *cache;           // resident workloads, most recently used first
+    int entries;               // number of resident workloads
+    int capacity;              // most resident workloads
+    long hits;                 // requests served from a resident workload
+    long misses;               // requests that parsed their trace
+} Server;
+
+/************************************************************
+ * Workloads
+ ************************************************************/
+
+/*
+ * Function: acquireWorkload
+ *
+ * Returns the workload of a trace, held by the caller, parsing it unless
+ * an unchanged copy is resident. Sets *cached to 1 if it was resident.
+ * Returns NULL on failure, with the error in job.
+ */
+static Workload *acquireWorkload(Server *sv, const char *path, int *cached, BatchJob *job) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        job->status = BATCH_OPEN;
+        job->message = "Could not open file";
+        return NULL;
+    }
+
+    Workload *found = NULL, *stale = NULL;
+    pthread_mutex_lock(&sv->lock);
+    for (Workload **link = &sv->cache; *link != NULL; link = &(*link)->next) {
+        Workload *w = *link;
+        if (strcmp(w->path, path) != 0) continue;
+
+        // unlink it: a current copy moves to the front, a stale one goes
+        *link = w->next;
+        if (w->size == st.st_size && w->mtime.tv_sec == st.st_mtim.tv_sec && w->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            found = w;
+            found->next = sv->cache;
+            sv->cache = found;
+            __sync_fetch_and_add(&found->refs, 1);
+            sv->hits++;
+        } else {
+            stale = w;
+            sv->entries--;
+        }
+        break;
+    }
+    if (found == NULL) {
+        sv->misses++;
+    }
+    pthread_mutex_unlock(&sv->lock);
+    releaseWorkload(stale);
+
+    *cached = found != NULL;
+    if (found != NULL) {
+        return found;
+    }
+
+    // parse without holding the lock; other requests keep running
+    Workload *w = loadWorkload(path, &st, job);
+    if (w == NULL) {
+        return NULL;
+    }
+    Workload *evicted = NULL;
+    pthread_mutex_lock(&sv->lock);
+    if (sv->capacity > 0) {
+        __sync_fetch_and_add(&w->refs, 1);
+        w->next = sv->cache;
+        sv->cache = w;
+        if (++sv->entries > sv->capacity) {
+            Workload **link = &sv->cache;
+            while ((*link)->next != NULL) link = &(*link)->next;
+            evicted = *link;
+            *link = NULL;
+            sv->entries--;
+        }
+    }
+    pthread_mutex_unlock(&sv->lock);
+    releaseWorkload(evicted);
+    return w;
+}
+
+/************************************************************
+ * Requests
+ ************************************************************/
+
+/*
+ * Function: runRequest
+ *
+ * Handles a RUN request, whose options and path follow the command word
+ */
+static void runRequest(Server *sv, char *args, FILE *out) {
+    BatchJob job;
+    BatchSettings settings = sv->settings;
+    int processes = 0;
+    memset(&job, 0, sizeof(job));
+    job.config = sv->config;
+
+    // options come first and the rest of the line is the path
+    char *path = args + strspn(args, " \t");
+    while (*path != '\0') {
+        size_t length = strcspn(path, " \t");
+        char saved = path[length];
+        path[length] = '\0';
+        int ok = 1;
+        if (strncmp(path, "config=", 7) == 0) {
+            ok = parseBranch(path + 7, &job.config) == 0;
+        } else if (strncmp(path, "aging=", 6) == 0) {
+            settings.aging = atoi(path + 6);
+        } else if (strncmp(path, "limit=", 6) == 0) {
+            settings.limit = atol(path + 6);
+        } else if (strncmp(path, "processes=", 10) == 0) {
+            processes = atoi(path + 10);
+        } else {
+            path[length] = saved;
+            break;
+        }
+        if (!ok) {
+            fprintf(out, "ERROR Invalid configuration: %s\n", path + 7);
+            return;
+        }
+        path += length + (saved != '\0');
+        path += strspn(path, " \t");
+    }
+    if (*path == '\0') {
+        fprintf(out, "ERROR Missing trace path\n");
+        return;
+    }
+
+    int cached;
+    Workload *w = acquireWorkload(sv, path, &cached, &job);
+    if (w == NULL) {
+        if (job.status == BATCH_PARSE) {
+            fprintf(out, "ERROR line %d: %s\n", job.line, job.message);
+        } else {
+            fprintf(out, "ERROR %s\n", job.message);
+        }
+        return;
+    }
+
+    pQueue *queue = instanceWorkload(w, job.config.quantumB);
+    if (queue == NULL) {
+        releaseWorkload(w);
+        fprintf(out, "ERROR Memory allocation failed\n");
+        return;
+    }
+
+    Simulation sim = { 0 };
+    runBatchQueue(&job, &settings, queue, &sim);
+    if (job.status == BATCH_NOMEM) {
+        fprintf(out, "ERROR %s\n", job.message);
+    } else {
+        fprintf(out, "OK %s %lld %lld %d %lld %.2f %lld %lld %ld %d\n", job.status == BATCH_DONE ? "done" : "limit",
+                job.startTime, job.endTime, job.completed, job.instructions,
+                job.completed > 0 ? (double)job.totalWait / job.completed : 0.0,
+                job.maxWait, job.minWait, job.iterations, cached);
+        for (pNode *n = processes ? sim.exitQueue->head : NULL; n != NULL; n = n->next) {
+            Process *p = n->process;
+            fprintf(out, "P %d %lld %lld %s\n", p->pid, p->runtime, p->ready, p->endQueue);
+        }
+        fprintf(out, "END\n");
+    }
+    freeSimulation(&sim);
+    releaseWorkload(w);
+}
+
+/*
+ * Function: serveConnection
+ *
+ * Answers the requests of one connection until the client closes it
+ */
+static void serveConnection(Server *sv, int fd) {
+    FILE *in = fdopen(fd, "r");
+    int outFd = dup(fd);
+    FILE *out = outFd >= 0 ? fdopen(outFd, "w") : NULL;
+    if (in == NULL || out == NULL) {
+        if (in != NULL) fclose(in); else close(fd);
+        if (out != NULL) fclose(out); else if (outFd >= 0) close(outFd);
+        return;
+    }
+
+    char line[4096];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "RUN", 3) == 0 && (line[3] == ' ' || line[3] == '\0')) {
+            runRequest(sv, line + 3, out);
+        } else if (strcmp(line, "STATS") == 0) {
+            pthread_mutex_lock(&sv->lock);
+            fprintf(out, "OK %d %ld %ld\nEND\n", sv->entries, sv->hits, sv->misses);
+            pthread_mutex_unlock(&sv->lock);
+        } else if (line[0] != '\0') {
+            fprintf(out, "ERROR Unknown request\n");
+        }
+        if (fflush(out) != 0) {
+            break;
+        }
+    }
+    fclose(in);
+    fclose(out);
+}
+
+/*
+ * Function: serverWorker
+ *
+ * Worker thread body: serves one connection at a time for as long as the
+ * server runs, handing the thread's pooled objects back between them
+ */
+static void *serverWorker(void *arg) {
+    Server *sv = (Server *)arg;
+    for (;;) {
+        int fd = accept(sv->listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        serveConnection(sv, fd);
+        poolTrim();
+    }
+    return NULL;
+}
+
+/*
+ * Function: serveSimulations
+ *
+ * Listens on options->address and answers requests until the process is
+ * stopped. Requests run under config and settings unless they say
+ * otherwise. Returns -1 if the server could not be set up.
+ */
+int serveSimulations(const Branch *config, const BatchSettings *settings, const ServerOptions *options) {
+    Server sv;
+    sv.config = *config;
+    sv.settings = *settings;
+    sv.cache = NULL;
+    sv.entries = 0;
+    sv.capacity = options->cacheEntries;
+    sv.hits = sv.misses = 0;
+    pthread_mutex_init(&sv.lock, NULL);
+
+    if ((sv.listener = openStreamSocket(options->address, 1)) < 0) {
+        fprintf(stderr, "Could not listen on %s\n", options->address);
+        return -1;
+    }
+    // a client that goes away must not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    int workers = options->workers > 0 ? options->workers : 1;
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    int started = 0;
+    while (threads != NULL && started < workers && pthread_create(&threads[started], NULL, serverWorker, &sv) == 0) {
+        started++;
+    }
+    fprintf(stderr, "Serving on %s with %d workers\n", options->address, started > 0 ? started : 1);
+
+    // without any thread the connections are served on the calling thread
+    if (started == 0) {
+        serverWorker(&sv);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    close(sv.listener);
+    while (sv.cache != NULL) {
+        Workload *w = sv.cache;
+        sv.cache = w->next;
+        releaseWorkload(w);
+    }
+    pthread_mutex_destroy(&sv.lock);
+    return -1;
+}
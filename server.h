@@ -0,0 +1,31 @@
+/*
+ * server.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for server mode: a long-running
+ * process that keeps parsed workloads resident and answers simulation
+ * requests over a local socket, so a query pays for the simulation only.
+ */
+
+ #ifndef SERVER_H
+ #define SERVER_H
+
+ #include "batch.h"
+
+ #ifndef SERVER_CACHE
+ #define SERVER_CACHE 16 // parsed workloads kept resident
+ #endif
+
+ // Struct for the server settings
+ typedef struct ServerOptions {
+     const char *address;       // unix:<path> or tcp:<host>:<port> to listen on
+     int workers;               // worker threads, one connection each
+     int cacheEntries;          // parsed workloads kept resident
+ } ServerOptions;
+
+ // function prototypes
+ int serveSimulations(const Branch *config, const BatchSettings *settings, const ServerOptions *options);
+
+ #endif
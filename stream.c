@@ -0,0 +1,295 @@
+/*
+ * stream.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of streamed traces. The reader
+ * thread runs the parser with a sink that publishes each process to the
+ * ring; the engine takes them off the other end at the start of a step.
+ * Each side owns one index of the ring and only reads the other's, so the
+ * ring needs no lock. A side finding the ring empty or full sleeps on a
+ * condition variable, after raising a flag the other side checks once it
+ * has moved its index, so a wake-up is never lost.
+ *
+ * The engine is fed so that every process that has arrived by the clock
+ * of a step is queued, along with one that has not, which keeps the
+ * lowest level from looking empty while the trace goes on. Processes are
+ * appended in file order and the lowest level never has processes
+ * inserted by priority (runs that demote into it are not streamed), so the
+ * run is the same as from a full parse. Only a trace out of arrival order
+ * can break this, by holding a process that should already have run; the
+ * engine then stops with the stream marked late and the caller starts the
+ * run again from a full parse. A trace with fair-share groups is run again
+ * the same way, as soon as its first grouped process is reached.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+
+#include "stream.h"
+#include "pool.h"
+
+#define STREAM_MASK (STREAM_RING - 1) // ring slot of an index
+
+/*
+ * Function: pushProcess
+ *
+ * Sink of the reader: publishes p to the ring, sleeping while it is
+ * full. Returns 0 on success, -1 if the engine has stopped the stream.
+ */
+static int pushProcess(Process *p, void *arg) {
+    TraceStream *s = (TraceStream *)arg;
+    unsigned long tail = s->tail;
+
+    if (tail - __atomic_load_n(&s->head, __ATOMIC_ACQUIRE) == STREAM_RING) {
+        pthread_mutex_lock(&s->lock);
+        __atomic_store_n(&s->readerWaiting, 1, __ATOMIC_SEQ_CST);
+        while (tail - __atomic_load_n(&s->head, __ATOMIC_SEQ_CST) == STREAM_RING &&
+               !__atomic_load_n(&s->stop, __ATOMIC_SEQ_CST)) {
+            pthread_cond_wait(&s->drained, &s->lock);
+        }
+        __atomic_store_n(&s->readerWaiting, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&s->lock);
+    }
+    if (__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+
+    s->ring[tail & STREAM_MASK] = p;
+    __atomic_store_n(&s->tail, tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->engineWaiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&s->lock);
+        pthread_cond_signal(&s->filled);
+        pthread_mutex_unlock(&s->lock);
+    }
+    return 0;
+}
+
+/*
+ * Function: readTrace
+ *
+ * Body of the reader thread: parses the whole trace into the ring, then
+ * records how the parse ended
+ */
+static void *readTrace(void *arg) {
+    TraceStream *s = (TraceStream *)arg;
+    ParseSink sink = { pushProcess, s };
+
+    // the whole file is about to be read in order
+    posix_fadvise(fileno(s->file), 0, 0, POSIX_FADV_SEQUENTIAL);
+    int status = parseProcessStream(s->file, s->quantumB, &sink, &s->err);
+
+    __atomic_store_n(&s->status, status, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&s->done, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&s->lock);
+    pthread_cond_signal(&s->filled);
+    pthread_mutex_unlock(&s->lock);
+
+    poolTrim();
+    return NULL;
+}
+
+/*
+ * Function: openTraceStream
+ *
+ * Starts reading the trace open as file on a new thread. The stream owns
+ * file from then on. Returns NULL, leaving file open, if the stream
+ * cannot be started.
+ */
+TraceStream *openTraceStream(FILE *file, int quantumB) {
+    TraceStream *s = (TraceStream *)calloc(1, sizeof(TraceStream));
+    Process **ring = (Process **)malloc(STREAM_RING * sizeof(Process *));
+    if (s == NULL || ring == NULL) {
+        free(s);
+        free(ring);
+        return NULL;
+    }
+    s->file = file;
+    s->quantumB = quantumB;
+    s->ring = ring;
+    s->status = PARSE_OK;
+    s->frontier = LLONG_MIN;
+    s->previous = LLONG_MIN;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->filled, NULL);
+    pthread_cond_init(&s->drained, NULL);
+
+    if (pthread_create(&s->thread, NULL, readTrace, s) != 0) {
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->filled);
+        pthread_cond_destroy(&s->drained);
+        free(ring);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+/*
+ * Function: nextProcess
+ *
+ * Returns the next process in the ring without taking it, sleeping until
+ * the reader has one. Returns NULL once the reader has stopped and the
+ * ring is empty.
+ */
+static Process *nextProcess(TraceStream *s) {
+    unsigned long head = s->head;
+
+    while (__atomic_load_n(&s->tail, __ATOMIC_ACQUIRE) == head) {
+        // the reader publishes its last process before it is done
+        if (__atomic_load_n(&s->done, __ATOMIC_ACQUIRE)) {
+            if (__atomic_load_n(&s->tail, __ATOMIC_ACQUIRE) == head) {
+                return NULL;
+            }
+            break;
+        }
+        pthread_mutex_lock(&s->lock);
+        __atomic_store_n(&s->engineWaiting, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&s->tail, __ATOMIC_SEQ_CST) == head && !__atomic_load_n(&s->done, __ATOMIC_SEQ_CST)) {
+            pthread_cond_wait(&s->filled, &s->lock);
+        }
+        __atomic_store_n(&s->engineWaiting, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&s->lock);
+    }
+    return s->ring[head & STREAM_MASK];
+}
+
+/*
+ * Function: takeProcess
+ *
+ * Takes the next process from the ring, sleeping until the reader has
+ * one. Returns NULL once the reader has stopped and the ring is empty.
+ */
+static Process *takeProcess(TraceStream *s) {
+    Process *p = nextProcess(s);
+    if (p == NULL) {
+        return NULL;
+    }
+    __atomic_store_n(&s->head, s->head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->readerWaiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&s->lock);
+        pthread_cond_signal(&s->drained);
+        pthread_mutex_unlock(&s->lock);
+    }
+    return p;
+}
+
+/*
+ * Function: admitProcesses
+ *
+ * Appends processes from the stream to the lowest level until one that
+ * arrives after runtime has been added or the trace is used up. Returns
+ * 0 on success, -1 if allocation fails or a process came too late.
+ */
+static int admitProcesses(TraceStream *s, Simulation *sim, Ticks runtime) {
+    pQueue *entry = sim->level[sim->levels - 1].queue;
+    int added = 0, status = 0;
+
+    while (s->frontier <= runtime) {
+        Process *p = takeProcess(s);
+        if (p == NULL) {
+            s->frontier = LLONG_MAX;
+            break;
+        }
+        // groups are shared with the reader, which may still be adding to them
+        if (p->group != NULL) {
+            freeProcess(p);
+            s->late = 1;
+            status = -1;
+            break;
+        }
+        if (enqueueProcess(entry, p) != 0) {
+            freeProcess(p);
+            status = -1;
+            break;
+        }
+        adoptProcess(sim, p);
+        added = 1;
+
+        // a process the engine could already have run cannot be made up for
+        if (p->arrival <= s->previous) {
+            s->late = 1;
+            status = -1;
+            break;
+        }
+        s->frontier = p->arrival;
+    }
+
+    if (added) {
+        refreshLevels(sim);
+    }
+    return status;
+}
+
+/*
+ * Function: attachStream
+ *
+ * Makes an engine initialized with no processes take them from stream,
+ * starting the clock at the first one. Returns 0 on success, -1 if the
+ * trace could not be read or allocation fails.
+ */
+int attachStream(Simulation *sim, TraceStream *stream) {
+    sim->stream = stream;
+
+    // simulation start time == first process arrival time
+    Process *first = nextProcess(stream);
+    if (first != NULL) {
+        sim->stats->runtime = sim->stats->startTime = first->arrival;
+    }
+
+    if (admitProcesses(stream, sim, sim->stats->runtime) != 0) {
+        return -1;
+    }
+    return __atomic_load_n(&stream->status, __ATOMIC_ACQUIRE) == PARSE_OK ? 0 : -1;
+}
+
+/*
+ * Function: feedStream
+ *
+ * Called at the start of every step: queues the processes arriving by
+ * the engine's clock. Returns 0 on success, -1 if the reader failed,
+ * allocation fails or the trace is out of arrival order (see late).
+ */
+int feedStream(TraceStream *stream, Simulation *sim) {
+    Ticks runtime = sim->stats->runtime;
+    int status = 0;
+    if (stream->frontier <= runtime) {
+        status = admitProcesses(stream, sim, runtime);
+    }
+    stream->previous = runtime;
+
+    // a trace that fails to parse fails the run, even where it has not been reached
+    if (status == 0 && __atomic_load_n(&stream->status, __ATOMIC_RELAXED) != PARSE_OK) {
+        status = -1;
+    }
+    return status;
+}
+
+/*
+ * Function: closeTraceStream
+ *
+ * Stops the reader, waits for it, and frees the processes it parsed that
+ * the engine never took, then closes the trace
+ */
+void closeTraceStream(TraceStream *stream) {
+    if (stream == NULL) return;
+
+    __atomic_store_n(&stream->stop, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&stream->lock);
+    pthread_cond_signal(&stream->drained);
+    pthread_mutex_unlock(&stream->lock);
+    pthread_join(stream->thread, NULL);
+
+    for (unsigned long i = stream->head; i != stream->tail; i++) {
+        freeProcess(stream->ring[i & STREAM_MASK]);
+    }
+    fclose(stream->file);
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->filled);
+    pthread_cond_destroy(&stream->drained);
+    free(stream->ring);
+    free(stream);
+}
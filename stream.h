@@ -0,0 +1,52 @@
+/*
+ * stream.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for streamed traces: a reader thread
+ * parses the trace ahead of the engine into a bounded single-producer,
+ * single-consumer ring, and the engine takes processes from it just
+ * before they arrive, so a run starts before the trace is fully read.
+ */
+
+ #ifndef STREAM_H
+ #define STREAM_H
+
+ #include <pthread.h>
+ #include "Simulation.h"
+ #include "parser.h"
+
+ #ifndef STREAM_RING
+ #define STREAM_RING 4096 // parsed processes the reader may run ahead by, a power of two
+ #endif
+
+ // Struct for a trace read ahead on another thread
+ typedef struct TraceStream {
+     FILE *file;                // trace being read, closed with the stream
+     int quantumB;              // quantum of the lowest level
+     Process **ring;            // parsed processes waiting for the engine
+     unsigned long head;        // next slot the engine takes, written by the engine
+     unsigned long tail;        // next slot the reader fills, written by the reader
+     int done;                  // set by the reader once it has stopped
+     int stop;                  // set by the engine to make the reader give up
+     int status;                // parser status code of the reader
+     ParseError err;            // where the reader failed
+     int engineWaiting;         // 1 while the engine sleeps on an empty ring
+     int readerWaiting;         // 1 while the reader sleeps on a full ring
+     pthread_mutex_t lock;      // guards sleeping only, never the ring
+     pthread_cond_t filled;     // signalled when the ring gains a process or the reader stops
+     pthread_cond_t drained;    // signalled when the ring gains a slot or the engine stops
+     pthread_t thread;          // the reader
+     Ticks frontier;            // arrival of the last process handed to the engine
+     Ticks previous;            // clock of the last engine step, LLONG_MIN before the first
+     int late;                  // 1 once a process reached the engine after it should have run
+ } TraceStream;
+
+ // function prototypes
+ TraceStream *openTraceStream(FILE *file, int quantumB);
+ int attachStream(Simulation *sim, TraceStream *stream);
+ int feedStream(TraceStream *stream, Simulation *sim);
+ void closeTraceStream(TraceStream *stream);
+
+ #endif
@@ -0,0 +1,681 @@
+/*
+ * sweep.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of distributed sweeps. The
+ * coordinator and its workers exchange one line of text per message:
+ *
+ *   coordinator -> worker   SETTINGS <aging> <limit> <levels> <quantum> <promote> <demote> ...
+ *                           JOB <id> <quantumA> <quantumB> <preemption> <path>
+ *                           DONE
+ *   worker -> coordinator   RESULT <id> <status> <line> <start> <end> <completed>
+ *                                  <instructions> <totalWait> <maxWait> <minWait> <iterations> <message>
+ *
+ * Workers pull work: each holds one job and gets the next one as soon as
+ * it reports a result, so fast workers take more of the sweep. Once no
+ * job is left to hand out, an idle worker steals a copy of a job that is
+ * still running elsewhere and the first result wins, so one slow or stuck
+ * machine cannot hold up the end of the sweep. A job whose worker
+ * disconnects, or that could not open its trace, is queued again up to
+ * the retry limit.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "sweep.h"
+
+#define SWEEP_LINE 8192 // longest message, including the trace path
+
+// Struct for a connected worker
+typedef struct SweepPeer {
+    int fd;                    // connection, -1 once closed
+    int job;                   // job being run, -1 if idle
+    int length;                // bytes in buffer
+    char buffer[SWEEP_LINE];   // received bytes not yet forming a line
+} SweepPeer;
+
+// Struct for the progress of one job
+typedef struct SweepState {
+    int done;                  // 1 once a result is accepted
+    int running;               // workers running the job
+    int attempts;              // failed attempts so far
+    int cached;                // 1 if the result came from the result cache
+} SweepState;
+
+// Struct for the coordinator
+typedef struct Sweep {
+    BatchJob *jobs;            // jobs in result order
+    SweepState *state;         // progress of each job
+    char **messages;           // error messages received for each job
+    int count;                 // number of jobs
+    int finished;              // jobs with an accepted result
+    int *pending;              // jobs waiting for a worker, in order
+    int head;                  // first waiting job in pending
+    int tail;                  // end of the waiting jobs in pending
+    int retries;               // extra attempts for a failed job
+    char settings[SWEEP_LINE]; // SETTINGS line sent to every worker
+} Sweep;
+
+/************************************************************
+ * Sockets
+ ************************************************************/
+
+/*
+ * Function: openStreamSocket
+ *
+ * Opens a stream socket for address, unix:<path> or tcp:<host>:<port>
+ * (an empty host listens on every interface), either listening on it or
+ * connected to it. Returns the descriptor, or -1 on failure.
+ */
+int openStreamSocket(const char *address, int listening) {
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        if (strlen(address + 5) >= sizeof(sa.sun_path)) {
+            return -1;
+        }
+        strcpy(sa.sun_path, address + 5);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (listening) {
+            unlink(sa.sun_path);
+            if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0 && listen(fd, 64) == 0) {
+                return fd;
+            }
+        } else if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0) {
+            return fd;
+        }
+        close(fd);
+        return -1;
+    }
+
+    if (strncmp(address, "tcp:", 4) != 0) {
+        return -1;
+    }
+    const char *colon = strrchr(address + 4, ':');
+    if (colon == NULL) {
+        return -1;
+    }
+    char host[256];
+    size_t hostLength = colon - (address + 4);
+    if (hostLength >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, address + 4, hostLength);
+    host[hostLength] = '\0';
+
+    struct addrinfo hints, *list;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    if (getaddrinfo(hostLength > 0 ? host : NULL, colon + 1, &hints, &list) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = list; ai != NULL && fd < 0; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0) {
+            continue;
+        }
+        int ok;
+        if (listening) {
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            ok = bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0;
+        } else {
+            ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        }
+        if (!ok) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    return fd;
+}
+
+/*
+ * Function: sendLine
+ *
+ * Writes all of a message to a socket. Returns 0 on success, -1 if the
+ * connection failed.
+ */
+static int sendLine(int fd, const char *line) {
+    size_t length = strlen(line);
+    while (length > 0) {
+        ssize_t n = write(fd, line, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        line += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/************************************************************
+ * Coordinator
+ ************************************************************/
+
+/*
+ * Function: queueJob
+ *
+ * Adds a job to the end of the waiting jobs
+ */
+static void queueJob(Sweep *sw, int job) {
+    sw->pending[sw->tail++] = job;
+}
+
+/*
+ * Function: finishJob
+ *
+ * Accepts the outcome now in a job
+ */
+static void finishJob(Sweep *sw, int job) {
+    sw->state[job].done = 1;
+    sw->finished++;
+}
+
+/*
+ * Function: nextJob
+ *
+ * Returns the job to hand to an idle worker: the first waiting job, or
+ * else a copy of the running job with the fewest copies. Returns -1 if
+ * there is nothing to hand out.
+ */
+static int nextJob(Sweep *sw) {
+    while (sw->head < sw->tail) {
+        int job = sw->pending[sw->head++];
+        if (!sw->state[job].done) {
+            return job;
+        }
+    }
+
+    int best = -1;
+    for (int i = 0; i < sw->count; i++) {
+        SweepState *s = &sw->state[i];
+        if (!s->done && s->running > 0 && s->running < SWEEP_COPIES &&
+            (best < 0 || s->running < sw->state[best].running)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/*
+ * Function: assignJob
+ *
+ * Hands an idle worker its next job, or tells it to stop once every job
+ * is finished. Returns 0 on success, -1 if the connection failed.
+ */
+static int assignJob(Sweep *sw, SweepPeer *peer) {
+    if (sw->finished == sw->count) {
+        return sendLine(peer->fd, "DONE\n");
+    }
+
+    int job = nextJob(sw);
+    if (job < 0) {
+        return 0; // stays idle until a job is queued again
+    }
+
+    char line[SWEEP_LINE];
+    BatchJob *j = &sw->jobs[job];
+    snprintf(line, sizeof(line), "JOB %d %d %d %d %s\n", job, j->config.quantumA, j->config.quantumB, j->config.preemption, j->path);
+    peer->job = job;
+    sw->state[job].running++;
+    return sendLine(peer->fd, line);
+}
+
+/*
+ * Function: failJob
+ *
+ * Records a failed attempt at a job that no worker is running any more,
+ * queueing it again while retries are left. Returns 1 if it was queued.
+ */
+static int failJob(Sweep *sw, int job) {
+    SweepState *s = &sw->state[job];
+    if (s->done || s->running > 0) {
+        return 0;
+    }
+    if (s->attempts++ < sw->retries) {
+        queueJob(sw, job);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Function: dropPeer
+ *
+ * Closes a worker connection. A job only that worker was running is
+ * queued again, or recorded as failed once out of retries.
+ */
+static void dropPeer(Sweep *sw, SweepPeer *peer) {
+    close(peer->fd);
+    peer->fd = -1;
+
+    int job = peer->job;
+    peer->job = -1;
+    if (job < 0) {
+        return;
+    }
+    sw->state[job].running--;
+    if (!sw->state[job].done && sw->state[job].running == 0 && !failJob(sw, job)) {
+        sw->jobs[job].status = BATCH_FAILED;
+        sw->jobs[job].message = "Worker failed while running the job";
+        finishJob(sw, job);
+    }
+}
+
+/*
+ * Function: readResult
+ *
+ * Records a RESULT line from a worker. A result for a job that another
+ * copy already finished is ignored. Returns 0 on success, -1 if the line
+ * is malformed.
+ */
+static int readResult(Sweep *sw, SweepPeer *peer, const char *line) {
+    BatchJob r;
+    int id, offset = 0, message;
+    if (sscanf(line, "RESULT %d %n", &id, &offset) < 1 || offset == 0 || id != peer->job ||
+        (message = parseBatchOutcome(line + offset, &r)) < 0) {
+        return -1;
+    }
+    offset += message;
+    peer->job = -1;
+
+    SweepState *s = &sw->state[id];
+    s->running--;
+    if (s->done) {
+        return 0;
+    }
+
+    // the trace may only be missing on that worker's machine
+    if (r.status == BATCH_OPEN && failJob(sw, id)) {
+        return 0;
+    }
+
+    BatchJob *j = &sw->jobs[id];
+    r.path = j->path;
+    r.config = j->config;
+    r.message = NULL;
+    if (r.status < 0) {
+        free(sw->messages[id]);
+        sw->messages[id] = strdup(line + offset);
+        r.message = sw->messages[id] ? sw->messages[id] : "Memory allocation failed";
+    }
+    *j = r;
+    finishJob(sw, id);
+    return 0;
+}
+
+/*
+ * Function: readPeer
+ *
+ * Reads what a worker has sent and handles each complete line. Returns
+ * 0 on success, -1 if the connection should be dropped.
+ */
+static int readPeer(Sweep *sw, SweepPeer *peer) {
+    ssize_t n = read(peer->fd, peer->buffer + peer->length, sizeof(peer->buffer) - 1 - peer->length);
+    if (n < 0 && errno == EINTR) {
+        return 0;
+    }
+    if (n <= 0) {
+        return -1;
+    }
+    peer->length += n;
+    peer->buffer[peer->length] = '\0';
+
+    char *start = peer->buffer, *end;
+    while ((end = strchr(start, '\n')) != NULL) {
+        *end = '\0';
+        if (readResult(sw, peer, start) != 0 || assignJob(sw, peer) != 0) {
+            return -1;
+        }
+        start = end + 1;
+    }
+    peer->length -= start - peer->buffer;
+    memmove(peer->buffer, start, peer->length);
+
+    // a line that does not fit is not a message of ours
+    return peer->length < (int)sizeof(peer->buffer) - 1 ? 0 : -1;
+}
+
+/*
+ * Function: settingsLine
+ *
+ * Formats the SETTINGS line for the batch settings
+ */
+static void settingsLine(char *line, size_t size, const BatchSettings *settings) {
+    int n = snprintf(line, size, "SETTINGS %d %ld %d", settings->aging, settings->limit, settings->numLevels);
+    for (int i = 0; i < settings->numLevels && n < (int)size; i++) {
+        const Level *l = &settings->levels[i];
+        n += snprintf(line + n, size - n, " %d %d %d", l->quantum, l->promote, l->demote);
+    }
+    if (n < (int)size - 1) {
+        strcpy(line + n, "\n");
+    }
+}
+
+/*
+ * Function: runSweep
+ *
+ * Serves workers on the listening socket until every job is finished.
+ * Returns 0 on success, -1 if spawned workers were the only ones and all
+ * of them exited early (the unfinished jobs are then recorded as failed).
+ */
+static int runSweep(Sweep *sw, int listener, int spawned) {
+    SweepPeer *peers = NULL;
+    int numPeers = 0, capacity = 0;
+    int status = 0;
+
+    while (sw->finished < sw->count) {
+        // reap local workers; with none left and no connection, nobody will come
+        while (spawned > 0 && waitpid(-1, NULL, WNOHANG) > 0) {
+            if (--spawned == 0) spawned = -1;
+        }
+        int connected = 0;
+        for (int i = 0; i < numPeers; i++) {
+            connected += peers[i].fd >= 0;
+        }
+        if (spawned < 0 && connected == 0) {
+            for (int i = 0; i < sw->count; i++) {
+                if (!sw->state[i].done) {
+                    sw->jobs[i].status = BATCH_FAILED;
+                    sw->jobs[i].message = "No workers left";
+                    finishJob(sw, i);
+                }
+            }
+            status = -1;
+            break;
+        }
+
+        struct pollfd *fds = (struct pollfd *)malloc((numPeers + 1) * sizeof(struct pollfd));
+        if (fds == NULL) {
+            status = -1;
+            break;
+        }
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < numPeers; i++) {
+            fds[i + 1].fd = peers[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+        if (poll(fds, numPeers + 1, 200) < 0 && errno != EINTR) {
+            free(fds);
+            status = -1;
+            break;
+        }
+
+        for (int i = 0; i < numPeers; i++) {
+            if (peers[i].fd >= 0 && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) && readPeer(sw, &peers[i]) != 0) {
+                dropPeer(sw, &peers[i]);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && numPeers == capacity) {
+                capacity = capacity ? 2 * capacity : 16;
+                SweepPeer *grown = (SweepPeer *)realloc(peers, capacity * sizeof(SweepPeer));
+                if (grown == NULL) {
+                    close(fd);
+                    fd = -1;
+                } else {
+                    peers = grown;
+                }
+            }
+            if (fd >= 0) {
+                SweepPeer *peer = &peers[numPeers++];
+                peer->fd = fd;
+                peer->job = -1;
+                peer->length = 0;
+                if (sendLine(fd, sw->settings) != 0 || assignJob(sw, peer) != 0) {
+                    dropPeer(sw, peer);
+                }
+            }
+        }
+        free(fds);
+
+        // jobs queued again go to workers left idle by an earlier steal
+        for (int i = 0; i < numPeers; i++) {
+            if (peers[i].fd >= 0 && peers[i].job < 0 && sw->head < sw->tail && assignJob(sw, &peers[i]) != 0) {
+                dropPeer(sw, &peers[i]);
+            }
+        }
+    }
+
+    // release the workers; those still running a stolen copy see the close
+    for (int i = 0; i < numPeers; i++) {
+        if (peers[i].fd >= 0) {
+            sendLine(peers[i].fd, "DONE\n");
+            close(peers[i].fd);
+        }
+    }
+    free(peers);
+    return status;
+}
+
+/*
+ * Function: simulateSweep
+ *
+ * Runs every input under every configuration on the workers that connect
+ * to options->address, starting options->spawn of them locally, and writes
+ * the results as batch mode does. Jobs found in the result cache are not
+ * handed out, and the rest are stored once accepted. Returns the number
+ * of jobs that did not run to completion, or -1 if the sweep could not
+ * be set up.
+ */
+int simulateSweep(const char *inputs, const Branch *configs, int numConfigs, const BatchSettings *settings, const SweepOptions *options, const char *results) {
+    char **paths;
+    int numPaths = listBatchInputs(inputs, &paths);
+    if (numPaths < 0) {
+        fprintf(stderr, "No inputs found for %s\n", inputs);
+        return -1;
+    }
+
+    Sweep sw;
+    sw.count = numPaths * numConfigs;
+    sw.finished = 0;
+    sw.head = sw.tail = 0;
+    sw.retries = options->retries > 0 ? options->retries : 0;
+    sw.jobs = createBatchJobs(paths, numPaths, configs, numConfigs);
+    sw.state = (SweepState *)calloc(sw.count + 1, sizeof(SweepState));
+    sw.messages = (char **)calloc(sw.count + 1, sizeof(char *));
+    sw.pending = (int *)malloc(((long)sw.count * (sw.retries + 1) + 1) * sizeof(int));
+    FILE *out = NULL;
+    int listener = -1;
+    if (!sw.jobs || !sw.state || !sw.messages || !sw.pending) {
+        fprintf(stderr, "Memory allocation failed\n");
+    } else if ((out = strcmp(results, "-") == 0 ? stdout : fopen(results, "w")) == NULL) {
+        perror(results);
+    } else if ((listener = openStreamSocket(options->address, 1)) < 0) {
+        fprintf(stderr, "Could not listen on %s\n", options->address);
+    }
+    if (listener < 0) {
+        if (out != NULL && out != stdout) {
+            fclose(out);
+        }
+        free(sw.jobs);
+        free(sw.state);
+        free(sw.messages);
+        free(sw.pending);
+        freeBatchInputs(paths, numPaths);
+        return -1;
+    }
+
+    // results already in the cache need no worker
+    char (*keys)[CACHE_KEY] = settings->cache ? (char (*)[CACHE_KEY])calloc(sw.count + 1, CACHE_KEY) : NULL;
+    for (int i = 0; i < sw.count; i++) {
+        if (keys != NULL && batchResultKey(keys[i], &sw.jobs[i], settings) != 0) {
+            keys[i][0] = '\0';
+        }
+        if (keys != NULL && keys[i][0] != '\0' && loadBatchResult(&sw.jobs[i], settings, keys[i])) {
+            sw.state[i].cached = 1;
+            finishJob(&sw, i);
+        } else {
+            queueJob(&sw, i);
+        }
+    }
+    settingsLine(sw.settings, sizeof(sw.settings), settings);
+
+    // a worker that dies must not take the coordinator with it
+    signal(SIGPIPE, SIG_IGN);
+
+    int spawned = 0;
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < options->spawn && sw.finished < sw.count; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            _exit(sweepWorker(options->address) == 0 ? 0 : 1);
+        }
+        if (pid > 0) {
+            spawned++;
+        } else {
+            perror("fork");
+        }
+    }
+
+    runSweep(&sw, listener, spawned);
+    close(listener);
+    if (strncmp(options->address, "unix:", 5) == 0) {
+        unlink(options->address + 5);
+    }
+    while (spawned > 0 && wait(NULL) > 0);
+
+    for (int i = 0; keys != NULL && i < sw.count; i++) {
+        if (keys[i][0] != '\0' && !sw.state[i].cached) {
+            storeBatchResult(&sw.jobs[i], settings, keys[i]);
+        }
+    }
+    free(keys);
+
+    writeBatchResults(out, sw.jobs, sw.count);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < sw.count; i++) {
+        failed += sw.jobs[i].status != BATCH_DONE;
+        free(sw.messages[i]);
+    }
+    free(sw.jobs);
+    free(sw.state);
+    free(sw.messages);
+    free(sw.pending);
+    freeBatchInputs(paths, numPaths);
+    return failed;
+}
+
+/************************************************************
+ * Worker
+ ************************************************************/
+
+/*
+ * Function: readSettings
+ *
+ * Parses a SETTINGS line. Returns 0 on success, -1 if it is malformed.
+ */
+static int readSettings(const char *line, BatchSettings *settings) {
+    int offset = 0;
+    if (sscanf(line, "SETTINGS %d %ld %d%n", &settings->aging, &settings->limit, &settings->numLevels, &offset) != 3 ||
+        settings->numLevels < 1 || settings->numLevels > MAX_LEVELS) {
+        return -1;
+    }
+    for (int i = 0; i < settings->numLevels; i++) {
+        Level *l = &settings->levels[i];
+        int used = 0;
+        if (sscanf(line + offset, " %d %d %d%n", &l->quantum, &l->promote, &l->demote, &used) != 3) {
+            return -1;
+        }
+        offset += used;
+    }
+    return 0;
+}
+
+/*
+ * Function: sweepWorker
+ *
+ * Connects to the coordinator at address, retrying while it starts up,
+ * and runs the jobs it hands out until it says DONE or goes away. Returns
+ * 0 on success, -1 if the coordinator could not be reached or broke the
+ * protocol.
+ */
+int sweepWorker(const char *address) {
+    signal(SIGPIPE, SIG_IGN);
+
+    int fd = -1;
+    for (int attempt = 0; attempt < 50 && (fd = openStreamSocket(address, 0)) < 0; attempt++) {
+        usleep(100000);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Could not connect to %s\n", address);
+        return -1;
+    }
+    FILE *in = fdopen(fd, "r");
+    if (in == NULL) {
+        close(fd);
+        return -1;
+    }
+
+    BatchSettings settings;
+    settings.numLevels = 0;
+    settings.cache = NULL;
+    int status = 0;
+    char line[SWEEP_LINE];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+
+        if (strncmp(line, "SETTINGS ", 9) == 0) {
+            if (readSettings(line, &settings) != 0) {
+                status = -1;
+                break;
+            }
+        } else if (strncmp(line, "JOB ", 4) == 0 && settings.numLevels > 0) {
+            BatchJob job;
+            int id, offset = 0;
+            memset(&job, 0, sizeof(job));
+            if (sscanf(line, "JOB %d %d %d %d %n", &id, &job.config.quantumA, &job.config.quantumB,
+                       &job.config.preemption, &offset) != 4 || offset == 0) {
+                status = -1;
+                break;
+            }
+            job.path = line + offset;
+            runBatchJob(&job, &settings);
+
+            char result[SWEEP_LINE];
+            int length = snprintf(result, sizeof(result), "RESULT %d ", id);
+            formatBatchOutcome(result + length, sizeof(result) - length - 1, &job);
+            strcat(result, "\n");
+            if (sendLine(fd, result) != 0) {
+                break;
+            }
+        } else if (strcmp(line, "DONE") == 0) {
+            break;
+        } else {
+            status = -1;
+            break;
+        }
+    }
+
+    fclose(in);
+    return status;
+}
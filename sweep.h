@@ -0,0 +1,35 @@
+/*
+ * sweep.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for distributed sweeps. A coordinator
+ * splits a sweep over traces and configurations into batch jobs and hands
+ * them to worker processes over Unix or TCP stream sockets. Workers may
+ * run on other machines as long as they see the trace files at the same
+ * paths.
+ */
+
+ #ifndef SWEEP_H
+ #define SWEEP_H
+
+ #include "batch.h"
+
+ #ifndef SWEEP_COPIES
+ #define SWEEP_COPIES 2 // most workers running one job at the same time
+ #endif
+
+ // Struct for the coordinator settings
+ typedef struct SweepOptions {
+     const char *address;       // unix:<path> or tcp:<host>:<port> to listen on
+     int spawn;                 // local worker processes to start
+     int retries;               // extra attempts for a job whose worker failed
+ } SweepOptions;
+
+ // function prototypes
+ int openStreamSocket(const char *address, int listening);
+ int simulateSweep(const char *inputs, const Branch *configs, int numConfigs, const BatchSettings *settings, const SweepOptions *options, const char *results);
+ int sweepWorker(const char *address);
+
+ #endif
@@ -0,0 +1,521 @@
+/*
+ * tune.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of the autotuner. The trace is
+ * parsed once into a workload, and every candidate configuration (a grid
+ * of quanta, with or without preemption) runs against instances of it.
+ * The search is successive halving: each round runs the candidates still
+ * in the race up to a checkpoint in simulated time, ranks them by the
+ * objective so far and keeps the best third, tripling the checkpoint
+ * time, until only a few finalists are left to run to completion. Within
+ * a round, candidates run in parallel on worker threads.
+ *
+ * Ready time only grows, so a run's objective so far never overstates how
+ * well it will end. Any run already doing worse than the best finished
+ * run is therefore abandoned as soon as that is seen, in any round.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "tune.h"
+#include "workload.h"
+#include "pool.h"
+
+#define TUNE_VALUES 64 // most quanta tried on each level
+
+// Candidate states
+#define CANDIDATE_RUNNING 0    // reached its last checkpoint
+#define CANDIDATE_DONE 1       // ran to completion
+#define CANDIDATE_PRUNED 2     // abandoned, ranked out or beaten by a finished run
+#define CANDIDATE_LIMIT 3      // stuck, or stopped by the iteration limit
+#define CANDIDATE_FAILED 4     // engine ran out of memory
+
+// Struct for one configuration in the search
+typedef struct Candidate {
+    Branch config;             // quanta and preemption flag
+    int state;                 // one of the candidate states
+    double cost;               // objective at its last checkpoint, lower is better
+    long iterations;           // scheduler loop iterations of its last run
+} Candidate;
+
+// Struct for the state shared by the worker threads
+typedef struct Tuner {
+    Candidate *candidates;     // every configuration
+    int count;                 // number of candidates
+    Candidate **runs;          // candidates to run this round
+    int numRuns;               // number of runs this round
+    int next;                  // index of the next run to take
+    Workload *workload;        // parsed trace shared by every run
+    const BatchSettings *settings; // levels and aging
+    int objective;             // what is being minimized
+    long limit;                // loop iterations per run
+    long check;                // iterations between checks against the best
+    Ticks target;              // simulated time the runs stop at, LLONG_MAX for none
+    pthread_mutex_t lock;      // guards best
+    double best;               // cost of the best finished run, HUGE_VAL until one finishes
+} Tuner;
+
+/*
+ * Function: parseTuneObjective
+ *
+ * Returns the objective named avg, p99 or throughput, or -1 if the name
+ * is unknown
+ */
+int parseTuneObjective(const char *name) {
+    if (strcmp(name, "avg") == 0) return TUNE_AVG;
+    if (strcmp(name, "p99") == 0) return TUNE_P99;
+    if (strcmp(name, "throughput") == 0) return TUNE_THROUGHPUT;
+    return -1;
+}
+
+/*
+ * Function: objectiveName
+ *
+ * Returns the heading for an objective in the report
+ */
+static const char *objectiveName(int objective) {
+    switch (objective) {
+        case TUNE_P99: return "p99 ready time";
+        case TUNE_THROUGHPUT: return "completed per 1000 ticks";
+        default: return "average ready time";
+    }
+}
+
+/*
+ * Function: tuneQuanta
+ *
+ * Fills values with the quanta tried on a level: min, then steps of about
+ * half again up to max. Returns their number.
+ */
+static int tuneQuanta(int *values, int min, int max) {
+    int count = 0;
+    for (int q = min; q <= max && count < TUNE_VALUES; q = q + 1 > q * 3 / 2 ? q + 1 : q * 3 / 2) {
+        values[count++] = q;
+    }
+    if (count > 0 && values[count - 1] != max && count < TUNE_VALUES) {
+        values[count++] = max;
+    }
+    return count;
+}
+
+/*
+ * Function: selectTicks
+ *
+ * Returns the k-th smallest of n times, reordering them
+ */
+static Ticks selectTicks(Ticks *v, int n, int k) {
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        Ticks pivot = v[lo + (hi - lo) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                Ticks swap = v[i];
+                v[i++] = v[j];
+                v[j--] = swap;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return v[k];
+}
+
+/*
+ * Function: runCost
+ *
+ * Returns the objective of a run so far, lower being better. Ready time
+ * is taken over every process, finished or not, so for the ready time
+ * objectives this is also a lower bound on the final cost.
+ */
+static double runCost(const Tuner *t, Simulation *sim) {
+    Stats *s = sim->stats;
+    if (t->objective == TUNE_THROUGHPUT) {
+        Ticks elapsed = s->runtime - s->startTime;
+        return elapsed > 0 ? -(sim->exitQueue->size * 1000.0 / elapsed) : 0.0;
+    }
+
+    int count = t->workload->count;
+    if (count == 0) {
+        return 0.0;
+    }
+    if (t->objective == TUNE_AVG) {
+        Ticks total = 0;
+        for (Process *p = sim->owned; p != NULL; p = p->nextOwned) {
+            total += p->ready;
+        }
+        return (double)total / count;
+    }
+
+    Ticks *ready = (Ticks *)malloc(count * sizeof(Ticks));
+    if (ready == NULL) {
+        return HUGE_VAL;
+    }
+    int n = 0;
+    for (Process *p = sim->owned; p != NULL && n < count; p = p->nextOwned) {
+        ready[n++] = p->ready;
+    }
+    // nearest rank: the smallest time at least 99% of processes do not exceed
+    int k = (int)ceil(0.99 * n) - 1;
+    double cost = n > 0 ? (double)selectTicks(ready, n, k < 0 ? 0 : k) : 0.0;
+    free(ready);
+    return cost;
+}
+
+/*
+ * Function: costBound
+ *
+ * Returns a cost the run cannot finish below. Throughput is at best every
+ * process completed right now.
+ */
+static double costBound(const Tuner *t, Simulation *sim) {
+    if (t->objective == TUNE_THROUGHPUT) {
+        Ticks elapsed = sim->stats->runtime - sim->stats->startTime;
+        return elapsed > 0 ? -(t->workload->count * 1000.0 / elapsed) : -HUGE_VAL;
+    }
+    return runCost(t, sim);
+}
+
+/*
+ * Function: bestCost
+ *
+ * Returns the cost of the best finished run so far
+ */
+static double bestCost(Tuner *t) {
+    pthread_mutex_lock(&t->lock);
+    double best = t->best;
+    pthread_mutex_unlock(&t->lock);
+    return best;
+}
+
+/*
+ * Function: runCandidate
+ *
+ * Runs a fresh instance of the workload under a candidate's configuration
+ * up to the round's checkpoint, or to completion in the final round, and
+ * records where it got to. A run that finishes becomes the best so far if
+ * it beats it.
+ */
+static void runCandidate(Tuner *t, Candidate *c) {
+    Level levels[MAX_LEVELS];
+    int count = batchLevels(levels, t->settings, &c->config);
+
+    Simulation sim = { 0 };
+    pQueue *queue = instanceWorkload(t->workload, levels[count - 1].quantum);
+    int status = queue != NULL ? initializeSimulation(&sim, levels, count, c->config.preemption, queue) : -1;
+
+    long iterations = 0, moved = 0;
+    Ticks clock = 0;
+    c->state = CANDIDATE_RUNNING;
+    if (status == 0) {
+        setAging(&sim, t->settings->aging);
+        while ((status = stepSimulation(&sim)) > 0) {
+            if (sim.stats->runtime >= t->target) {
+                break;
+            }
+            // a run whose clock stops moving is stuck, however long it is given
+            if (sim.stats->runtime != clock) {
+                clock = sim.stats->runtime;
+                moved = iterations;
+            }
+            if (++iterations >= t->limit || iterations - moved >= TUNE_STALL) {
+                c->state = CANDIDATE_LIMIT;
+                break;
+            }
+            if (iterations % t->check == 0 && costBound(t, &sim) > bestCost(t)) {
+                c->state = CANDIDATE_PRUNED;
+                break;
+            }
+        }
+    }
+
+    c->iterations = iterations;
+    if (status < 0) {
+        c->state = CANDIDATE_FAILED;
+    } else if (status == 0) {
+        c->state = CANDIDATE_DONE;
+    }
+    c->cost = c->state == CANDIDATE_DONE || c->state == CANDIDATE_RUNNING ? runCost(t, &sim) : HUGE_VAL;
+
+    if (c->state == CANDIDATE_DONE) {
+        pthread_mutex_lock(&t->lock);
+        if (c->cost < t->best) {
+            t->best = c->cost;
+        }
+        pthread_mutex_unlock(&t->lock);
+    }
+    freeSimulation(&sim);
+}
+
+/*
+ * Function: tuneWorker
+ *
+ * Thread body: takes runs of the current round until none are left
+ */
+static void *tuneWorker(void *arg) {
+    Tuner *t = (Tuner *)arg;
+    int i;
+    while ((i = __sync_fetch_and_add(&t->next, 1)) < t->numRuns) {
+        runCandidate(t, t->runs[i]);
+    }
+    poolTrim();
+    return NULL;
+}
+
+/*
+ * Function: runRound
+ *
+ * Runs every candidate still running, up to target, on the given number
+ * of worker threads
+ */
+static void runRound(Tuner *t, Ticks target, int workers) {
+    t->numRuns = 0;
+    t->next = 0;
+    t->target = target;
+    for (int i = 0; i < t->count; i++) {
+        if (t->candidates[i].state == CANDIDATE_RUNNING) {
+            t->runs[t->numRuns++] = &t->candidates[i];
+        }
+    }
+
+    if (workers > t->numRuns) {
+        workers = t->numRuns;
+    }
+    pthread_t *threads = (pthread_t *)malloc((workers > 0 ? workers : 1) * sizeof(pthread_t));
+    int started = 0;
+    while (threads != NULL && started < workers && pthread_create(&threads[started], NULL, tuneWorker, t) == 0) {
+        started++;
+    }
+    // without any thread the runs still happen, on the calling thread
+    if (started == 0) {
+        tuneWorker(t);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+/*
+ * Function: compareCandidates
+ *
+ * Orders candidates by cost, then by their place in the grid
+ */
+static int compareCandidates(const void *x, const void *y) {
+    const Candidate *a = *(Candidate *const *)x;
+    const Candidate *b = *(Candidate *const *)y;
+    if (a->cost != b->cost) {
+        return a->cost < b->cost ? -1 : 1;
+    }
+    return (a > b) - (a < b);
+}
+
+/*
+ * Function: rankCandidates
+ *
+ * Collects the candidates in the given states into ranked, best first,
+ * and returns their number
+ */
+static int rankCandidates(Tuner *t, Candidate **ranked, int running, int done) {
+    int n = 0;
+    for (int i = 0; i < t->count; i++) {
+        Candidate *c = &t->candidates[i];
+        if ((running && c->state == CANDIDATE_RUNNING) || (done && c->state == CANDIDATE_DONE)) {
+            ranked[n++] = c;
+        }
+    }
+    qsort(ranked, n, sizeof(Candidate *), compareCandidates);
+    return n;
+}
+
+/*
+ * Function: workloadSpan
+ *
+ * Estimates how long the workload runs: from the first arrival to the
+ * last, plus all of its instructions back to back. Sets *start to the
+ * first arrival.
+ */
+static Ticks workloadSpan(const Workload *w, Ticks *start) {
+    Ticks first = LLONG_MAX, last = 0, work = 0;
+    for (int i = 0; i < w->count; i++) {
+        const WorkloadProcess *wp = &w->processes[i];
+        first = wp->arrival < first ? wp->arrival : first;
+        last = wp->arrival > last ? wp->arrival : last;
+        for (int j = 0; j < wp->program->count; j++) {
+            work += programTime(wp->program, j);
+        }
+    }
+    *start = w->count > 0 ? first : 0;
+    return last - *start + work;
+}
+
+/*
+ * Function: autotune
+ *
+ * Searches quanta from options->minQuantum to options->maxQuantum for the
+ * highest and lowest levels, with preemption on, off or both, for the
+ * configuration with the best objective on the trace at path, and prints
+ * the search and its result. The middle levels, aging and iteration limit
+ * come from settings. Returns 0 on success, 1 if no candidate finished,
+ * -1 if the search could not be set up.
+ */
+int autotune(const char *path, const BatchSettings *settings, const TuneOptions *options) {
+    struct stat st;
+    BatchJob job;
+    memset(&job, 0, sizeof(job));
+    Workload *w = NULL;
+    if (stat(path, &st) != 0) {
+        job.message = "Could not open file";
+    } else {
+        w = loadWorkload(path, &st, &job);
+    }
+    if (w == NULL) {
+        if (job.line > 0) {
+            printf("Error: %s: line %d: %s\n", path, job.line, job.message);
+        } else {
+            printf("Error: %s: %s\n", path, job.message);
+        }
+        return -1;
+    }
+
+    int quanta[TUNE_VALUES];
+    int numQuanta = tuneQuanta(quanta, options->minQuantum, options->maxQuantum);
+    int numFlags = options->preemption < 0 ? 2 : 1;
+
+    Tuner t;
+    t.count = numQuanta * numQuanta * numFlags;
+    t.candidates = (Candidate *)calloc(t.count + 1, sizeof(Candidate));
+    t.runs = (Candidate **)malloc((t.count + 1) * sizeof(Candidate *));
+    Candidate **ranked = (Candidate **)malloc((t.count + 1) * sizeof(Candidate *));
+    Candidate **reserve = (Candidate **)malloc((t.count + 1) * sizeof(Candidate *));
+    int numReserve = 0;
+    if (t.candidates == NULL || t.runs == NULL || ranked == NULL || reserve == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(t.candidates);
+        free(t.runs);
+        free(ranked);
+        free(reserve);
+        releaseWorkload(w);
+        return -1;
+    }
+    t.workload = w;
+    t.settings = settings;
+    t.objective = options->objective;
+    t.limit = settings->limit > 0 ? settings->limit : TUNE_LIMIT;
+    t.check = w->count > TUNE_CHECK ? w->count : TUNE_CHECK;
+    t.best = HUGE_VAL;
+    pthread_mutex_init(&t.lock, NULL);
+
+    int n = 0;
+    for (int f = 0; f < numFlags; f++) {
+        for (int a = 0; a < numQuanta; a++) {
+            for (int b = 0; b < numQuanta; b++) {
+                Candidate *c = &t.candidates[n++];
+                c->config.quantumA = quanta[a];
+                c->config.quantumB = quanta[b];
+                c->config.preemption = options->preemption < 0 ? f : options->preemption;
+                c->state = CANDIDATE_RUNNING;
+            }
+        }
+    }
+
+    // each round keeps a third; the first checkpoint is that far before the end
+    int rounds = 0;
+    for (int left = t.count; left > TUNE_FINALISTS; left = (left + 2) / 3) {
+        rounds++;
+    }
+    Ticks start;
+    Ticks span = workloadSpan(w, &start);
+    printf("Tuning %s: %d processes, %d candidates, objective %s\n", path, w->count, t.count, objectiveName(t.objective));
+
+    for (int r = 0; r < rounds; r++) {
+        Ticks scale = 1;
+        for (int i = r; i < rounds && scale < span; i++) {
+            scale *= 3;
+        }
+        Ticks target = start + (span / scale > 0 ? span / scale : 1);
+        runRound(&t, target, settings->workers);
+
+        // the candidates ranked out go ahead of those ranked out earlier
+        int alive = rankCandidates(&t, ranked, 1, 1);
+        int keep = (alive + 2) / 3 > TUNE_FINALISTS ? (alive + 2) / 3 : TUNE_FINALISTS;
+        // candidates the checkpoint cannot tell apart all stay
+        while (keep > 0 && keep < alive && ranked[keep]->cost == ranked[keep - 1]->cost) {
+            keep++;
+        }
+        int out = 0;
+        for (int i = keep; i < alive; i++) {
+            if (ranked[i]->state == CANDIDATE_RUNNING) {
+                ranked[i]->state = CANDIDATE_PRUNED;
+                ranked[out++] = ranked[i];
+            }
+        }
+        memmove(reserve + out, reserve, numReserve * sizeof(Candidate *));
+        memcpy(reserve, ranked, out * sizeof(Candidate *));
+        numReserve += out;
+        printf("Round %d: %d runs to time %lld, kept %d\n", r + 1, t.numRuns, target, keep < alive ? keep : alive);
+    }
+
+    // a finalist that never finishes gives way to the best candidate ranked out
+    int finalRuns = 0, revive = 0;
+    for (;;) {
+        runRound(&t, LLONG_MAX, settings->workers);
+        finalRuns += t.numRuns;
+        int stuck = 0, revived = 0;
+        for (int i = 0; i < t.numRuns; i++) {
+            stuck += t.runs[i]->state == CANDIDATE_LIMIT || t.runs[i]->state == CANDIDATE_FAILED;
+        }
+        while (revived < stuck && revive < numReserve) {
+            reserve[revive++]->state = CANDIDATE_RUNNING;
+            revived++;
+        }
+        if (revived == 0) {
+            break;
+        }
+    }
+    printf("Final round: %d runs to completion\n", finalRuns);
+
+    int pruned = 0, limited = 0, failed = 0;
+    for (int i = 0; i < t.count; i++) {
+        pruned += t.candidates[i].state == CANDIDATE_PRUNED;
+        limited += t.candidates[i].state == CANDIDATE_LIMIT;
+        failed += t.candidates[i].state == CANDIDATE_FAILED;
+    }
+    printf("Abandoned early: %d, stuck or over the iteration limit: %d, out of memory: %d\n", pruned, limited, failed);
+
+    int finished = rankCandidates(&t, ranked, 0, 1);
+    if (finished > 0) {
+        printf("\nRank quantumA quantumB preemption %s\n", objectiveName(t.objective));
+        for (int i = 0; i < finished && i < 10; i++) {
+            Candidate *c = ranked[i];
+            printf("%4d %9d %8d %10d %.2f\n", i + 1, c->config.quantumA, c->config.quantumB, c->config.preemption,
+                   t.objective == TUNE_THROUGHPUT ? -c->cost : c->cost);
+        }
+        printf("\nBest configuration: %d %d %d\n", ranked[0]->config.quantumA, ranked[0]->config.quantumB, ranked[0]->config.preemption);
+    } else {
+        printf("\nNo candidate ran to completion\n");
+    }
+
+    pthread_mutex_destroy(&t.lock);
+    free(t.candidates);
+    free(t.runs);
+    free(ranked);
+    free(reserve);
+    releaseWorkload(w);
+    return finished > 0 ? 0 : 1;
+}
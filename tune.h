@@ -0,0 +1,50 @@
+/*
+ * tune.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for the autotuner, which searches
+ * the quanta and preemption flag for the configuration that does best on
+ * one trace under a chosen objective.
+ */
+
+ #ifndef TUNE_H
+ #define TUNE_H
+
+ #include "batch.h"
+
+ #ifndef TUNE_LIMIT
+ #define TUNE_LIMIT 10000000L // default scheduler iterations per candidate run
+ #endif
+
+ #ifndef TUNE_STALL
+ #define TUNE_STALL 100000L // iterations without the clock moving before a run counts as stuck
+ #endif
+
+ #ifndef TUNE_FINALISTS
+ #define TUNE_FINALISTS 3 // candidates left to run to completion
+ #endif
+
+ #ifndef TUNE_CHECK
+ #define TUNE_CHECK 4096 // fewest iterations between checks against the best finished run
+ #endif
+
+ // Objectives
+ #define TUNE_AVG 0             // average ready time
+ #define TUNE_P99 1             // 99th percentile ready time
+ #define TUNE_THROUGHPUT 2      // processes completed per 1000 ticks
+
+ // Struct for the search settings
+ typedef struct TuneOptions {
+     int objective;             // TUNE_AVG, TUNE_P99 or TUNE_THROUGHPUT
+     int minQuantum;            // smallest quantum tried
+     int maxQuantum;            // largest quantum tried
+     int preemption;            // 0 or 1 to fix the flag, -1 to try both
+ } TuneOptions;
+
+ // function prototypes
+ int parseTuneObjective(const char *name);
+ int autotune(const char *path, const BatchSettings *settings, const TuneOptions *options);
+
+ #endif
@@ -0,0 +1,748 @@
+/*
+ * validate.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the differential validation harness. It generates
+ * random workloads, runs each one through the frozen reference engine and
+ * the current engine under random quanta and preemption, and compares the
+ * start/end time, instruction count and every process's completion time,
+ * ready time and termination queue. A grouped trial places every process
+ * in one fair-share group, which the current engine must run exactly as
+ * the reference engine runs it without groups. A mismatch is shrunk to a
+ * minimal workload by removing processes and instructions and lowering
+ * times while the engines still disagree.
+ *
+ * Runs that let idle time pass, as generated and embedded ones do, only
+ * stop once nothing left can run, so every trial is also run that way and
+ * must end, and a trace whose first process is promoted is run through
+ * libscheduler's schedRun, which must return with both processes
+ * completed. So must an imported scheduler trace whose tasks are promoted
+ * after they wake up. A process that a stream of higher priority arrivals
+ * starves without aging must, with aging, wait no longer than the
+ * priority between them is worth.
+ *
+ * Usage: ./Validate [--runs N] [--seed S] [--processes N] [--tasks N] [--limit N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include "Simulation.h"
+#include "parser.h"
+#include "reference.h"
+#include "scheduler.h"
+#include "import.h"
+
+#define MAX_GEN_PROCESSES 64
+#define MAX_GEN_TASKS 64
+#define RETRY_FACTOR 64 // limit multiplier before a one-sided stop counts as a hang
+#define HANG_SECONDS 60 // time a run that must return gets before the harness gives up
+#define AGING_TICKS 4 // ready ticks per point of aging in the starvation check
+#define STARVED_PRIORITY 90 // priority of the process the stream would starve
+#define STREAM_GAP 5 // ticks between arrivals of the stream
+
+// Struct for one instruction of a generated process
+typedef struct GenTask {
+    char type;                 // 'e' = execution, 'i' = I/O
+    int time;                  // time to execute or I/O time
+} GenTask;
+
+// Struct for one generated process
+typedef struct GenProcess {
+    int pid;                   // process id
+    int priority;              // process priority
+    int arrival;               // arrival time
+    int numTasks;              // number of instructions before terminate
+    GenTask tasks[MAX_GEN_TASKS]; // instructions
+} GenProcess;
+
+// Struct for a generated workload and the configuration it runs under
+typedef struct Trial {
+    int quantumA;              // quantum for queue A
+    int quantumB;              // quantum for queue B
+    int preemption;            // flag for preemption
+    int templated;             // 1 to write each process as a template instance
+    int grouped;               // 1 to place every process in one fair-share group
+    int numProcesses;          // number of processes
+    GenProcess processes[MAX_GEN_PROCESSES]; // processes in file order
+} Trial;
+
+// Struct for what one engine reported
+typedef struct Outcome {
+    int finished;              // 1 if the run ended within the limit
+    Ticks startTime;           // start time of simulation
+    Ticks endTime;             // end time of simulation
+    Ticks instructions;        // number of instructions completed
+    int completed;             // number of processes completed
+    int pid[MAX_GEN_PROCESSES]; // process ids in completion order
+    Ticks completion[MAX_GEN_PROCESSES]; // completion times
+    Ticks waiting[MAX_GEN_PROCESSES]; // ready times
+    char queue[MAX_GEN_PROCESSES]; // termination queues
+} Outcome;
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+/*
+ * Function: nextRandom
+ *
+ * Returns a random number in [0, n) from a xorshift generator
+ */
+static int nextRandom(int n) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (int)(rngState % (unsigned long long)n);
+}
+
+/*
+ * Function: generateTrial
+ *
+ * Fills trial with a random workload of up to maxProcesses processes of
+ * up to maxTasks instructions each, and random quanta and preemption.
+ * Small ranges are used on purpose so that priorities, arrivals and
+ * quantum boundaries often tie.
+ */
+static void generateTrial(Trial *trial, int maxProcesses, int maxTasks) {
+    trial->quantumA = 2 + nextRandom(7);
+    trial->quantumB = 2 + nextRandom(9);
+    trial->preemption = nextRandom(2);
+    trial->templated = nextRandom(2);
+    trial->grouped = nextRandom(2);
+    trial->numProcesses = 1 + nextRandom(maxProcesses);
+
+    for (int i = 0; i < trial->numProcesses; i++) {
+        GenProcess *p = &trial->processes[i];
+        p->pid = 1000 + i;
+        p->priority = nextRandom(2) ? nextRandom(5) : nextRandom(100);
+        p->arrival = nextRandom(20);
+        p->numTasks = 1 + nextRandom(maxTasks);
+        for (int j = 0; j < p->numTasks; j++) {
+            p->tasks[j].type = nextRandom(3) == 0 ? 'i' : 'e';
+            p->tasks[j].time = nextRandom(12);
+        }
+    }
+}
+
+/*
+ * Function: writeTrial
+ *
+ * Writes the workload of a trial in the input file format. A templated
+ * trial defines each process's instructions as a template and instances
+ * it, so the current engine runs them from a shared program while the
+ * reference engine expands them. A grouped trial names one group for
+ * every process, which the reference engine ignores.
+ */
+static void writeTrial(FILE *f, const Trial *trial) {
+    for (int i = 0; i < trial->numProcesses; i++) {
+        const GenProcess *p = &trial->processes[i];
+        if (trial->templated) {
+            fprintf(f, "job:t%d\n", i);
+        } else {
+            fprintf(f, "P%d:%d\narrival_t:%d\n", p->pid, p->priority, p->arrival);
+            if (trial->grouped) {
+                fprintf(f, "group:all\n");
+            }
+        }
+        for (int j = 0; j < p->numTasks; j++) {
+            fprintf(f, "%s:%d\n", p->tasks[j].type == 'i' ? "io" : "exe", p->tasks[j].time);
+        }
+        fprintf(f, "terminate\n");
+        if (trial->templated) {
+            fprintf(f, "P%d:%d\narrival_t:%d\n%suse:t%d\n", p->pid, p->priority, p->arrival,
+                    trial->grouped ? "group:all\n" : "", i);
+        }
+    }
+}
+
+/*
+ * Function: parseWorkload
+ *
+ * Parses a generated workload of length bytes into a fresh process queue
+ * and frees the text
+ */
+static pQueue *parseWorkload(char *text, size_t length, int quantumB) {
+    pQueue *q = createProcessQueue();
+    FILE *in = fmemopen(text, length, "r");
+    if (q == NULL || in == NULL || parseProcesses(in, quantumB, q, NULL) != PARSE_OK) {
+        fprintf(stderr, "VALIDATE: generated workload could not be parsed\n");
+        exit(EXIT_FAILURE);
+    }
+    fclose(in);
+    free(text);
+    return q;
+}
+
+/*
+ * Function: parseTrial
+ *
+ * Parses the workload of a trial into a fresh process queue, or returns
+ * NULL on failure
+ */
+static pQueue *parseTrial(const Trial *trial) {
+    char *text = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream(&text, &length);
+    if (out == NULL) {
+        return NULL;
+    }
+    writeTrial(out, trial);
+    fclose(out);
+    return parseWorkload(text, length, trial->quantumB);
+}
+
+/*
+ * Function: collectOutcome
+ *
+ * Records the statistics and completed processes of a run
+ */
+static void collectOutcome(Outcome *out, int finished, Stats *stats, pQueue *exitQueue) {
+    out->finished = finished;
+    out->startTime = stats->startTime;
+    out->endTime = stats->runtime;
+    out->instructions = stats->instructions;
+    out->completed = 0;
+    for (pNode *n = exitQueue->head; n != NULL && out->completed < MAX_GEN_PROCESSES; n = n->next) {
+        Process *p = n->process;
+        out->pid[out->completed] = p->pid;
+        out->completion[out->completed] = p->runtime;
+        out->waiting[out->completed] = p->ready;
+        out->queue[out->completed] = p->endQueue[0];
+        out->completed++;
+    }
+}
+
+/*
+ * Function: runCurrent
+ *
+ * Runs a trial through the current engine, letting idle time pass if idle
+ * is set, stopping after limit steps
+ */
+static void runCurrent(const Trial *trial, long limit, int idle, Outcome *out) {
+    Simulation sim = { 0 };
+    Level levels[MAX_LEVELS];
+    int count = defaultLevels(levels, trial->quantumA, trial->quantumB);
+
+    if (initializeSimulation(&sim, levels, count, trial->preemption, parseTrial(trial)) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    sim.idleTicks = idle;
+
+    int status = 1;
+    for (long steps = 0; status > 0 && steps < limit; steps++) {
+        status = stepSimulation(&sim);
+    }
+    if (status < 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    collectOutcome(out, status == 0, sim.stats, sim.exitQueue);
+    freeSimulation(&sim);
+}
+
+/*
+ * Function: runOriginal
+ *
+ * Runs a trial through the reference engine, stopping after limit loop
+ * iterations
+ */
+static void runOriginal(const Trial *trial, long limit, Outcome *out) {
+    Reference ref;
+    int status = runReference(&ref, trial->quantumA, trial->quantumB, trial->preemption, parseTrial(trial), limit);
+    if (status < 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    collectOutcome(out, status == 0, ref.stats, ref.exitQueue);
+    freeReference(&ref);
+}
+
+/*
+ * Function: sameOutcome
+ *
+ * Returns 1 if two finished runs reported the same results
+ */
+static int sameOutcome(const Outcome *a, const Outcome *b) {
+    if (a->startTime != b->startTime || a->endTime != b->endTime ||
+        a->instructions != b->instructions || a->completed != b->completed) {
+        return 0;
+    }
+    for (int i = 0; i < a->completed; i++) {
+        if (a->pid[i] != b->pid[i] || a->completion[i] != b->completion[i] ||
+            a->waiting[i] != b->waiting[i] || a->queue[i] != b->queue[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Function: silenceEngines
+ *
+ * Sends the engines' own diagnostics (such as a process not found in a
+ * queue, which both engines print) to /dev/null while on is set, so they
+ * do not interleave with the report
+ */
+static void silenceEngines(int on) {
+    static int savedOut = -1, savedErr = -1;
+
+    fflush(stdout);
+    fflush(stderr);
+    if (on && savedOut < 0) {
+        int null = open("/dev/null", O_WRONLY);
+        if (null < 0) return;
+        savedOut = dup(STDOUT_FILENO);
+        savedErr = dup(STDERR_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(null);
+    } else if (!on && savedOut >= 0) {
+        dup2(savedOut, STDOUT_FILENO);
+        dup2(savedErr, STDERR_FILENO);
+        close(savedOut);
+        close(savedErr);
+        savedOut = savedErr = -1;
+    }
+}
+
+/*
+ * Function: compareTrial
+ *
+ * Runs a trial through both engines. The current engine takes a few
+ * steps per loop iteration of the original, so it gets a larger limit,
+ * and a run that stops on its limit while the other finishes is retried
+ * with a much larger one before it counts as a hang. Returns 1 if the
+ * engines agree, 0 if they disagree, -1 if neither finished.
+ */
+static int compareTrial(const Trial *trial, long limit, Outcome *ref, Outcome *cur) {
+    silenceEngines(1);
+    runOriginal(trial, limit, ref);
+    runCurrent(trial, 4 * limit, 0, cur);
+
+    if (ref->finished != cur->finished) {
+        if (!ref->finished) {
+            runOriginal(trial, RETRY_FACTOR * limit, ref);
+        } else {
+            runCurrent(trial, 4 * RETRY_FACTOR * limit, 0, cur);
+        }
+    }
+    silenceEngines(0);
+
+    if (!ref->finished && !cur->finished) {
+        return -1;
+    }
+    return ref->finished == cur->finished && sameOutcome(ref, cur);
+}
+
+/*
+ * Function: endsIdle
+ *
+ * Returns 1 if a trial run with idle ticks ends within the limit
+ */
+static int endsIdle(const Trial *trial, long limit) {
+    Outcome out;
+    silenceEngines(1);
+    runCurrent(trial, 4 * limit, 1, &out);
+    silenceEngines(0);
+    return out.finished;
+}
+
+/*
+ * Function: reportHang
+ *
+ * Stops the harness when a run that must return has not
+ */
+static void reportHang(int signal) {
+    static const char message[] = "HANG: schedRun did not return\n";
+    (void)signal;
+    (void)write(STDOUT_FILENO, message, sizeof(message) - 1);
+    _exit(EXIT_FAILURE);
+}
+
+/*
+ * Function: libraryRunEnds
+ *
+ * Runs a trace through libscheduler whose first process is promoted after
+ * its I/O, leaving a copy of it at the lowest level, and returns 1 if
+ * schedRun returns with both processes completed
+ */
+static int libraryRunEnds(void) {
+    static const SchedInstruction first[] = { { 'i', 2 }, { 'e', 3 }, { 'i', 5 }, { 'e', 4 } };
+    static const SchedInstruction second[] = { { 'e', 3 } };
+    SchedEngine *engine;
+    SchedResults results;
+
+    if (schedCreate(&engine, 4, 6, 0) != SCHED_OK) {
+        return 0;
+    }
+    int ok = schedAddProcess(engine, 1700, 10, 1, first, 4) == SCHED_OK &&
+             schedAddProcess(engine, 456, 5, 3, second, 1) == SCHED_OK;
+
+    signal(SIGALRM, reportHang);
+    alarm(HANG_SECONDS);
+    ok = ok && schedRun(engine) == SCHED_OK && schedGetResults(engine, &results) == SCHED_OK;
+    alarm(0);
+
+    if (ok) {
+        ok = results.completed == 2;
+        schedFreeResults(&results);
+    }
+    schedDestroy(engine);
+    return ok;
+}
+
+/*
+ * Function: writeSchedTrace
+ *
+ * Writes an ftrace dump of tasks taking turns on one CPU, each sleeping
+ * after a burst until it is woken 2 ms later and exiting after rounds
+ * bursts. The wake-ups promote the imported processes.
+ */
+static void writeSchedTrace(FILE *f, int tasks, int rounds) {
+    long long time = 1000000; // microseconds
+
+    for (int r = 0; r < rounds; r++) {
+        for (int k = 0; k < tasks; k++) {
+            int pid = 100 + k, next = 100 + (k + 1) % tasks, last = r == rounds - 1;
+            time += 500 * (1 + (pid + r) % 3);
+            fprintf(f, "  task-%d %d [000] %lld.%06lld: sched:sched_switch: prev_comm=task-%d prev_pid=%d "
+                       "prev_prio=120 prev_state=%c ==> next_comm=task-%d next_pid=%d next_prio=120\n",
+                    pid, pid, time / 1000000, time % 1000000, pid, pid, last ? 'X' : 'S', next, next);
+            if (!last) {
+                long long wake = time + 2000;
+                fprintf(f, "  x 0 [000] %lld.%06lld: sched:sched_wakeup: comm=task-%d pid=%d prio=120 target_cpu=000\n",
+                        wake / 1000000, wake % 1000000, pid, pid);
+            }
+        }
+    }
+}
+
+/*
+ * Function: importRunEnds
+ *
+ * Imports a scheduler trace whose tasks are promoted and runs it letting
+ * idle time pass, as --import does, and returns 1 if the run ends within
+ * limit steps with every task completed
+ */
+static int importRunEnds(long limit) {
+    char *text = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream(&text, &length);
+    if (out == NULL) {
+        return 0;
+    }
+    writeSchedTrace(out, 4, 6);
+    fclose(out);
+
+    Simulation sim = { 0 };
+    Level levels[MAX_LEVELS];
+    int count = defaultLevels(levels, 3, 7);
+    ImportStats stats;
+    ParseError err;
+    pQueue *q = createProcessQueue();
+    FILE *in = fmemopen(text, length, "r");
+    if (q == NULL || in == NULL || importSchedTrace(in, IMPORT_TICK * 1000LL, levels[count - 1].quantum, q, &stats, &err) != PARSE_OK) {
+        fprintf(stderr, "VALIDATE: generated scheduler trace could not be imported\n");
+        exit(EXIT_FAILURE);
+    }
+    fclose(in);
+    free(text);
+
+    if (initializeSimulation(&sim, levels, count, 0, q) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    sim.idleTicks = 1;
+
+    int status = 1;
+    for (long steps = 0; status > 0 && steps < limit; steps++) {
+        status = stepSimulation(&sim);
+    }
+    int ended = status == 0 && sim.exitQueue->size == stats.tasks;
+    freeSimulation(&sim);
+    return ended;
+}
+
+/*
+ * Function: starvedWait
+ *
+ * Runs a process of STARVED_PRIORITY against a stream of priority 1
+ * processes arriving every STREAM_GAP ticks, each of which goes first
+ * under preemption, and returns the ready time of the first process, or
+ * -1 if it did not complete within limit steps
+ */
+static Ticks starvedWait(int aging, long limit) {
+    char *text = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream(&text, &length);
+    if (out == NULL) {
+        return -1;
+    }
+    fprintf(out, "P1:%d\narrival_t:1\nexe:6\nterminate\n", STARVED_PRIORITY);
+    for (int k = 0; k < 200; k++) {
+        fprintf(out, "P%d:1\narrival_t:%d\nexe:2\nterminate\n", 100 + k, 1 + STREAM_GAP * k);
+    }
+    fclose(out);
+
+    Simulation sim = { 0 };
+    Level levels[MAX_LEVELS];
+    int count = defaultLevels(levels, 3, 5);
+    if (initializeSimulation(&sim, levels, count, 1, parseWorkload(text, length, 5)) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    setAging(&sim, aging);
+
+    int status = 1;
+    for (long steps = 0; status > 0 && steps < limit; steps++) {
+        status = stepSimulation(&sim);
+    }
+    Ticks wait = -1;
+    for (pNode *n = sim.exitQueue->head; n != NULL; n = n->next) {
+        if (n->process->pid == 1) {
+            wait = n->process->ready;
+        }
+    }
+    freeSimulation(&sim);
+    return wait;
+}
+
+/*
+ * Function: stillFails
+ *
+ * Returns 1 if a candidate trial still makes the engines disagree
+ */
+static int stillFails(const Trial *trial, long limit) {
+    Outcome ref, cur;
+    return compareTrial(trial, limit, &ref, &cur) == 0;
+}
+
+/*
+ * Function: shrinkTrial
+ *
+ * Reduces a failing trial one change at a time, keeping each change that
+ * leaves the engines disagreeing, until no single change does: drop a
+ * process, drop an instruction, then halve or decrement a time, arrival
+ * or priority. Returns the number of changes kept.
+ */
+static int shrinkTrial(Trial *trial, long limit) {
+    Trial *candidate = (Trial *)malloc(sizeof(Trial));
+    if (candidate == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int kept = 0;
+    int progress = 1;
+    while (progress) {
+        progress = 0;
+
+        // drop whole processes
+        for (int i = 0; trial->numProcesses > 1 && i < trial->numProcesses; i++) {
+            *candidate = *trial;
+            memmove(&candidate->processes[i], &candidate->processes[i + 1],
+                    (candidate->numProcesses - i - 1) * sizeof(GenProcess));
+            candidate->numProcesses--;
+            if (stillFails(candidate, limit)) {
+                *trial = *candidate;
+                kept++;
+                progress = 1;
+                i--;
+            }
+        }
+
+        // drop single instructions
+        for (int i = 0; i < trial->numProcesses; i++) {
+            for (int j = 0; j < trial->processes[i].numTasks; j++) {
+                *candidate = *trial;
+                GenProcess *p = &candidate->processes[i];
+                memmove(&p->tasks[j], &p->tasks[j + 1], (p->numTasks - j - 1) * sizeof(GenTask));
+                p->numTasks--;
+                if (stillFails(candidate, limit)) {
+                    *trial = *candidate;
+                    kept++;
+                    progress = 1;
+                    j--;
+                }
+            }
+        }
+
+        // lower numbers: halve first, then step down by one
+        for (int i = 0; i < trial->numProcesses; i++) {
+            GenProcess *p = &trial->processes[i];
+            int *values[MAX_GEN_TASKS + 2];
+            int count = 0;
+            values[count++] = &p->arrival;
+            values[count++] = &p->priority;
+            for (int j = 0; j < p->numTasks; j++) {
+                values[count++] = &p->tasks[j].time;
+            }
+
+            for (int k = 0; k < count; k++) {
+                int original = *values[k];
+                int tries[2] = { original / 2, original - 1 };
+                for (int n = 0; n < 2 && *values[k] > 0; n++) {
+                    if (tries[n] == original || (n == 1 && tries[1] == tries[0])) continue;
+                    *values[k] = tries[n];
+                    if (stillFails(trial, limit)) {
+                        kept++;
+                        progress = 1;
+                        break;
+                    }
+                    *values[k] = original;
+                }
+            }
+        }
+    }
+
+    free(candidate);
+    return kept;
+}
+
+/*
+ * Function: printOutcome
+ *
+ * Prints what one engine reported in the engine's report format
+ */
+static void printOutcome(const char *name, const Outcome *out) {
+    printf("%s:%s\n", name, out->finished ? "" : " (stopped at the iteration limit)");
+    printf("Start/End Time: %lld, %lld\n", out->startTime, out->endTime);
+    printf("Processes completed: %d\n", out->completed);
+    printf("Instructions completed: %lld\n", out->instructions);
+    for (int i = 0; i < out->completed; i++) {
+        printf("P%d time_completion:%lld time_waiting:%lld termination_queue:%c\n",
+               out->pid[i], out->completion[i], out->waiting[i], out->queue[i]);
+    }
+}
+
+/*
+ * Function: printUsage
+ *
+ * Prints the command line usage and the optional arguments
+ */
+static void printUsage(char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  --runs <N>        number of random trials (default 1000)\n");
+    printf("  --seed <S>        random seed (default 1)\n");
+    printf("  --processes <N>   most processes per trial (default 6, at most %d)\n", MAX_GEN_PROCESSES);
+    printf("  --tasks <N>       most instructions per process (default 6, at most %d)\n", MAX_GEN_TASKS);
+    printf("  --limit <N>       reference loop iterations before a run counts as stuck (default 100000)\n\n");
+}
+
+/*
+ * Function: main
+ *
+ * Runs the random trials and shrinks and reports the first mismatch.
+ * Returns 0 if the engines agreed on every trial, 1 otherwise.
+ */
+int main(int argc, char *argv[]) {
+    long runs = 1000;
+    unsigned long long seed = 1;
+    int maxProcesses = 6;
+    int maxTasks = 6;
+    long limit = 100000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            maxProcesses = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tasks") == 0 && i + 1 < argc) {
+            maxTasks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = atol(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (maxProcesses < 1 || maxProcesses > MAX_GEN_PROCESSES || maxTasks < 1 ||
+        maxTasks > MAX_GEN_TASKS || limit < 1 || runs < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    rngState ^= seed * 0x9E3779B97F4A7C15ULL;
+
+    Trial *trial = (Trial *)malloc(sizeof(Trial));
+    if (trial == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    if (!libraryRunEnds()) {
+        printf("FAILED: a promoting trace run through schedRun did not complete\n");
+        free(trial);
+        return 1;
+    }
+    if (!importRunEnds(4 * limit)) {
+        printf("FAILED: an imported trace with promotions did not complete\n");
+        free(trial);
+        return 1;
+    }
+
+    // the stream starves the process without aging; with it, the process
+    // goes first once it has waited a point of priority per AGING_TICKS
+    // for each point between them, and a few arrivals more
+    Ticks bound = (Ticks)(STARVED_PRIORITY - 1) * AGING_TICKS + 4 * STREAM_GAP;
+    Ticks starved = starvedWait(0, 4 * limit), aged = starvedWait(AGING_TICKS, 4 * limit);
+    if (starved <= bound || aged < 0 || aged > bound) {
+        printf("FAILED: aging did not bound the wait of a starved process (%lld ticks without aging, %lld with, bound %lld)\n",
+               starved, aged, bound);
+        free(trial);
+        return 1;
+    }
+
+    long agreed = 0, stuck = 0;
+    for (long run = 0; run < runs; run++) {
+        generateTrial(trial, maxProcesses, maxTasks);
+
+        // with idle ticks a run must end, whatever the engines agree on
+        if (!endsIdle(trial, limit)) {
+            printf("UNFINISHED with idle ticks: trial %ld (seed %llu), quantumA:%d quantumB:%d preemption:%d\n\n",
+                   run + 1, seed, trial->quantumA, trial->quantumB, trial->preemption);
+            writeTrial(stdout, trial);
+            free(trial);
+            return 1;
+        }
+
+        Outcome ref, cur;
+        int result = compareTrial(trial, limit, &ref, &cur);
+        if (result > 0) {
+            agreed++;
+            continue;
+        }
+        if (result < 0) {
+            stuck++;
+            continue;
+        }
+
+        // shrink the mismatch and report it
+        printf("MISMATCH in trial %ld (seed %llu)\n", run + 1, seed);
+        int kept = shrinkTrial(trial, limit);
+        compareTrial(trial, limit, &ref, &cur);
+        printf("Shrunk with %d reductions to quantumA:%d quantumB:%d preemption:%d\n\n",
+               kept, trial->quantumA, trial->quantumB, trial->preemption);
+        writeTrial(stdout, trial);
+        printf("\n");
+        printOutcome("Reference engine", &ref);
+        printf("\n");
+        printOutcome("Current engine", &cur);
+        free(trial);
+        return 1;
+    }
+
+    printf("Trials: %ld, agreed: %ld, stuck in both engines: %ld, mismatches: 0\n", runs, agreed, stuck);
+    free(trial);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * workload.c
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the implementation of parsed workloads. Parsing a
+ * trace queues processes as usual; the instructions each one has left are
+ * then captured as a program, as templates are, and the processes freed.
+ * An instance costs one allocation per process and shares the programs.
+ * Workloads are reference counted so that threads can run instances of
+ * one while its owner lets go of it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "workload.h"
+#include "parser.h"
+#include "decompress.h"
+#include "pool.h"
+
+/*
+ * Function: releaseWorkload
+ *
+ * Drops one hold on a workload, freeing it when the last is dropped
+ */
+void releaseWorkload(Workload *w) {
+    if (w == NULL || __sync_sub_and_fetch(&w->refs, 1) > 0) return;
+
+    for (int i = 0; i < w->count; i++) {
+        releaseProgram(w->processes[i].program);
+    }
+    free(w->processes);
+    free(w->path);
+    free(w);
+}
+
+/*
+ * Function: captureProgram
+ *
+ * Returns the instructions a parsed process has left as a program held
+ * by the caller. A template instance already has one and shares it.
+ * Returns NULL if allocation fails.
+ */
+static Program *captureProgram(Process *p) {
+    if (isEmptyT(p->tasks) && p->program != NULL && p->programNext == 0) {
+        __sync_fetch_and_add(&p->program->refs, 1);
+        return p->program;
+    }
+
+    Program *prog = createProgram(8);
+    if (prog == NULL) {
+        return NULL;
+    }
+    prog->count = 0;
+
+    Task *t;
+    while ((t = takeTask(p)) != NULL) {
+        int ok = prog->count < prog->capacity || growProgram(prog) == 0;
+        if (ok) {
+            prog->instructions[prog->count].type = t->type;
+            ok = setProgramTime(prog, prog->count, t->time) == 0;
+        }
+        freeTask(t);
+        if (!ok) {
+            releaseProgram(prog);
+            return NULL;
+        }
+        prog->count++;
+    }
+    return prog;
+}
+
+/*
+ * Function: loadWorkload
+ *
+ * Parses a trace into a workload held once by the caller. Returns NULL
+ * on failure, with the error in job.
+ */
+Workload *loadWorkload(const char *path, const struct stat *st, BatchJob *job) {
+    FILE *file = openTrace(path);
+    if (file == NULL) {
+        job->status = BATCH_OPEN;
+        job->message = "Could not open file";
+        return NULL;
+    }
+
+    pQueue *queue = createProcessQueue();
+    ParseError err;
+    int parsed = queue ? parseProcesses(file, 0, queue, &err) : PARSE_NOMEM;
+    fclose(file);
+
+    Workload *w = NULL;
+    if (parsed == PARSE_OK && (w = (Workload *)calloc(1, sizeof(Workload))) != NULL) {
+        w->path = strdup(path);
+        w->mtime = st->st_mtim;
+        w->size = st->st_size;
+        w->refs = 1;
+        w->processes = (WorkloadProcess *)malloc((queue->size + 1) * sizeof(WorkloadProcess));
+        if (w->path == NULL || w->processes == NULL) {
+            parsed = PARSE_NOMEM;
+        }
+    } else if (parsed == PARSE_OK) {
+        parsed = PARSE_NOMEM;
+    }
+
+    // the processes are only needed for their instructions
+    Process *p;
+    while (queue != NULL && (p = dequeueProcess(queue)) != NULL) {
+        // the groups' shares are state of one run, which instances cannot share
+        if (parsed == PARSE_OK && p->group != NULL) {
+            parsed = PARSE_ERROR;
+            err.line = 0;
+            err.message = "Fair-share groups are not supported in this mode";
+        }
+        if (parsed == PARSE_OK) {
+            WorkloadProcess *wp = &w->processes[w->count];
+            wp->pid = p->pid;
+            wp->priority = p->priority;
+            wp->arrival = p->arrival;
+            if ((wp->program = captureProgram(p)) != NULL) {
+                w->count++;
+            } else {
+                parsed = PARSE_NOMEM;
+            }
+        }
+        freeProcess(p);
+    }
+    freeProcessQueue(queue);
+
+    if (parsed != PARSE_OK) {
+        releaseWorkload(w);
+        job->status = parsed == PARSE_NOMEM ? BATCH_NOMEM : BATCH_PARSE;
+        job->line = parsed == PARSE_NOMEM ? 0 : err.line;
+        job->message = parsed == PARSE_NOMEM ? "Memory allocation failed" : err.message;
+        return NULL;
+    }
+    return w;
+}
+
+/*
+ * Function: instanceWorkload
+ *
+ * Creates a queue of fresh processes running a workload's programs, or
+ * returns NULL if allocation fails
+ */
+pQueue *instanceWorkload(const Workload *w, int quantum) {
+    return instanceWorkloadRange(w, 0, w->count, quantum);
+}
+
+/*
+ * Function: instanceWorkloadRange
+ *
+ * Creates a queue of fresh processes for count of a workload's processes
+ * from first on, in queue order, or returns NULL if allocation fails
+ */
+pQueue *instanceWorkloadRange(const Workload *w, int first, int count, int quantum) {
+    pQueue *queue = createProcessQueue();
+    for (int i = first; queue != NULL && i < first + count && i < w->count; i++) {
+        const WorkloadProcess *wp = &w->processes[i];
+        Process *p = createProcess();
+        if (p != NULL) {
+            p->pid = wp->pid;
+            p->priority = wp->priority;
+            p->arrival = wp->arrival;
+            p->quantum = quantum;
+            attachProgram(p, wp->program);
+        }
+        if (p == NULL || enqueueProcess(queue, p) != 0) {
+            Process *q;
+            freeProcess(p);
+            while ((q = dequeueProcess(queue)) != NULL) {
+                freeProcess(q);
+            }
+            freeProcessQueue(queue);
+            return NULL;
+        }
+        p->endQueue = "B";
+    }
+    return queue;
+}
@@ -0,0 +1,44 @@
+/*
+ * workload.h
+ *
+ * Author: Andrew Cox
+ * Date: 18 Oct 2026
+ *
+ * This file contains the definitions for parsed workloads: a trace parsed
+ * once into processes whose instructions are shared, immutable programs,
+ * from which any number of runs can create fresh processes without
+ * parsing again.
+ */
+
+ #ifndef WORKLOAD_H
+ #define WORKLOAD_H
+
+ #include <sys/stat.h>
+ #include "batch.h"
+
+ // Struct for one process of a workload
+ typedef struct WorkloadProcess {
+     int pid;                   // process id
+     int priority;              // process priority
+     Ticks arrival;             // arrival time
+     Program *program;          // instructions, shared by every instance
+ } WorkloadProcess;
+
+ // Struct for a parsed trace
+ typedef struct Workload {
+     char *path;                // trace file
+     struct timespec mtime;     // modification time when parsed
+     off_t size;                // file size when parsed
+     WorkloadProcess *processes; // processes in queue order
+     int count;                 // number of processes
+     int refs;                  // holds by the owner and by running requests
+     struct Workload *next;     // next workload in the owner's list
+ } Workload;
+
+ // function prototypes
+ Workload *loadWorkload(const char *path, const struct stat *st, BatchJob *job);
+ void releaseWorkload(Workload *w);
+ pQueue *instanceWorkload(const Workload *w, int quantum);
+ pQueue *instanceWorkloadRange(const Workload *w, int first, int count, int quantum);
+
+ #endif